@@ -14,7 +14,7 @@
 *     p = InterpreterParsePoly(state);
 *
 *     // Print loaded polynomial
-*     PolyPrint(&p);
+*     InterpreterPrintPoly(&calc, &p);
 *
 *     // Cleanup
 *     PolyDestroy(&p);
@@ -32,6 +32,7 @@
 #include <stdbool.h>
 #include <string.h>
 #include <limits.h>
+#include <unistd.h>
 #include "stack.h"
 #include "memalloc.h"
 #include "poly.h"
@@ -40,13 +41,29 @@
 #define NUMBER_MIN LONG_MIN
 #define NUMBER_MAX LONG_MAX
 
+/*
+* Number of digits of coefficient parsed at once
+* (so that every chunk fits into machine integer)
+*/
+#define COEFF_CHUNK_DIGITS 18
+
+/*
+* Number of nesting levels of parsed polynomial kept in local array
+* (deeper levels are allocated)
+*/
+#define INTERPRETER_PARSE_LOCAL_FRAMES 16
+
 /*
  Create new empty instance of interpreter runtime state.
 */
 InterpreterState InterpreterNew(FILE* err_out) {
   if(err_out == NULL) err_out = stderr;
+  // Every session starts with the default coefficients arithmetic
+  PolyCoeffSetModulus(POLY_COEFF_MODULUS);
   return (InterpreterState) {
     .err_out = err_out,
+    .input = InputBufferFromFd(STDIN_FILENO, INPUT_BUFFER_BLOCK_SIZE),
+    .output = OutputBufferToFd(STDOUT_FILENO, OUTPUT_BUFFER_BLOCK_SIZE),
     .char_buffer = '0',
     .error_type = NO_ERROR,
     .poly_stack = StackNew(),
@@ -56,10 +73,33 @@ InterpreterState InterpreterNew(FILE* err_out) {
     .prev_input_row = 1,
     .error_col = 0,
     .error_row = 0,
-    .critical_error_flag = false
+    .critical_error_flag = false,
+    .pool = NULL
   };
 }
 
+/*
+* Read the code from file instead of standard input
+*/
+bool InterpreterOpenInput(InterpreterState* state, const char* path) {
+  InputBuffer input;
+  if(!InputBufferOpen(&input, path, INPUT_BUFFER_BLOCK_SIZE)) {
+    return false;
+  }
+  InputBufferDestroy(&(state->input));
+  state->input = input;
+  return true;
+}
+
+/*
+* Set number of threads used by interpreter operations
+*/
+void InterpreterSetThreads(InterpreterState* state, int threads) {
+  assert(threads >= 1);
+  ThreadPoolDestroy(state->pool);
+  state->pool = (threads > 1) ? ThreadPoolNew(threads) : NULL;
+}
+
 /*
 * Report an error to the interpreter
 */
@@ -138,28 +178,44 @@ bool InterpreterCurrentIsDigit(InterpreterState* state) {
     return (state->char_buffer >= '0') && (state->char_buffer <= '9');
 }
 
+/*
+* Update position in input after reading character @p c
+*/
+static inline void InterpreterAdvance(InterpreterState* state, int c) {
+  state->char_buffer = c;
+  state->prev_input_row = state->input_row;
+  state->prev_input_col = state->input_col;
+  if(c == '\n') {
+    state->input_col = 1;
+    ++state->input_row;
+  } else {
+    ++state->input_col;
+  }
+}
+
+/*
+* Skip input until the end of line.
+* The position is updated as if the characters were read one by one.
+*/
+static inline void InterpreterSkipLine(InterpreterState* state) {
+  size_t skipped = 0;
+  const int c = InputBufferSkipLine(&(state->input), &skipped);
+  state->input_col += (int) skipped;
+  InterpreterAdvance(state, c);
+}
+
 /*
 * Read input until new line is reached
 */
 void InterpreterReadUntilNewLine(InterpreterState* state) {
-  do {
-    state->char_buffer = getchar();
-  } while(state->char_buffer != EOF && state->char_buffer != '\n');
+  InterpreterSkipLine(state);
 }
 
 /*
 * Read next character from input
 */
 char InterpreterNextChar(InterpreterState* state) {
-  state->char_buffer = getchar();
-  state->prev_input_row = state->input_row;
-  state->prev_input_col = state->input_col;
-  if(state->char_buffer == '\n') {
-    state->input_col = 1;
-    ++state->input_row;
-  } else {
-    ++state->input_col;
-  }
+  InterpreterAdvance(state, InputBufferGet(&(state->input)));
   return state->char_buffer;
 }
 
@@ -216,6 +272,41 @@ long long InterpreterParseNumber(InterpreterState* state, InterpreterErrorType e
   }
 }
 
+/*
+* Try to parse a coefficient of any size at current location.
+* Digits are parsed in chunks which are then combined exactly.
+*/
+poly_coeff_t InterpreterParseCoeff(InterpreterState* state, InterpreterErrorType error_when_failed) {
+  bool neg_flag = false;
+
+  if(state->char_buffer == '-') {
+    InterpreterNextChar(state);
+    neg_flag = true;
+  }
+  if(!InterpreterCurrentIsDigit(state)) {
+    InterpreterReportError(state, error_when_failed);
+    return 0;
+  }
+
+  poly_coeff_t accumulator = 0;
+  do {
+    long chunk = 0;
+    long scale = 1;
+    for(int i=0;i<COEFF_CHUNK_DIGITS && InterpreterCurrentIsDigit(state);++i) {
+      chunk = chunk * 10 + (state->char_buffer-'0');
+      scale *= 10;
+      InterpreterNextChar(state);
+    }
+    const poly_coeff_t shifted = PolyCoeffMulExact(accumulator, scale);
+    PolyCoeffDestroy(accumulator);
+    accumulator = PolyCoeffAddExact(shifted, neg_flag ? -chunk : chunk);
+    PolyCoeffDestroy(shifted);
+  } while(InterpreterCurrentIsDigit(state));
+
+  const poly_coeff_t result = PolyCoeffClone(PolyCoeffReduce(accumulator));
+  PolyCoeffDestroy(accumulator);
+  return result;
+}
 
 /*
 * ZERO stack operation impl
@@ -239,10 +330,11 @@ void InterpreterOpIsCoeff(InterpreterState* state) {
     return;
   }
   if(PolyIsCoeff((Poly*) StackFirst(&(state->poly_stack)))) {
-    printf("1\n");
+    OutputBufferPut(&(state->output), '1');
   } else {
-    printf("0\n");
+    OutputBufferPut(&(state->output), '0');
   }
+  OutputBufferEndLine(&(state->output));
 }
 
 /*
@@ -254,10 +346,11 @@ void InterpreterOpIsZero(InterpreterState* state) {
     return;
   }
   if(PolyIsZero((Poly*) StackFirst(&(state->poly_stack)))) {
-    printf("1\n");
+    OutputBufferPut(&(state->output), '1');
   } else {
-    printf("0\n");
+    OutputBufferPut(&(state->output), '0');
   }
+  OutputBufferEndLine(&(state->output));
 }
 
 /*
@@ -281,18 +374,13 @@ void InterpreterOpAdd(InterpreterState* state) {
     InterpreterReportError(state, WRONG_COMMAND);
     return;
   }
-  Poly* ret = MALLOCATE(Poly);
   Poly* a = (Poly*) StackPop(&(state->poly_stack));
   Poly* b = (Poly*) StackPop(&(state->poly_stack));
 
-  *ret = PolyAdd(a, b);
-
-  PolyDestroy(a);
-  PolyDestroy(b);
-  free(a);
+  PolyAddTakeInPlace(a, b);
   free(b);
 
-  StackPush(&(state->poly_stack), ret);
+  StackPush(&(state->poly_stack), a);
 }
 
 /*
@@ -303,18 +391,13 @@ void InterpreterOpMul(InterpreterState* state) {
     InterpreterReportError(state, WRONG_COMMAND);
     return;
   }
-  Poly* ret = MALLOCATE(Poly);
   Poly* a = (Poly*) StackPop(&(state->poly_stack));
   Poly* b = (Poly*) StackPop(&(state->poly_stack));
 
-  *ret = PolyMul(a, b);
-
-  PolyDestroy(a);
-  PolyDestroy(b);
-  free(a);
+  PolyMulTakeInPlaceParallel(a, b, state->pool);
   free(b);
 
-  StackPush(&(state->poly_stack), ret);
+  StackPush(&(state->poly_stack), a);
 }
 
 /*
@@ -328,15 +411,9 @@ void InterpreterOpPow(InterpreterState* state) {
     return;
   }
 
-  Poly* ret = MALLOCATE(Poly);
   Poly* a = (Poly*) StackPop(&(state->poly_stack));
-
-  *ret = PolyPow(a, x);
-
-  PolyDestroy(a);
-  free(a);
-
-  StackPush(&(state->poly_stack), ret);
+  PolyPowInPlaceParallel(a, x, state->pool);
+  StackPush(&(state->poly_stack), a);
 }
 
 
@@ -372,7 +449,7 @@ void InterpreterOpCompose(InterpreterState* state) {
   }
 
   Poly* ret = MALLOCATE(Poly);
-  *ret = PolyCompose(p, count, composition_table);
+  *ret = PolyComposeParallel(p, count, composition_table, state->pool);
   StackPush(&(state->poly_stack), ret);
 
   PolyDestroy(p);
@@ -384,6 +461,36 @@ void InterpreterOpCompose(InterpreterState* state) {
 
 }
 
+/*
+* MOD stack operation impl
+*/
+void InterpreterOpMod(InterpreterState* state) {
+  long long modulus = InterpreterParseNumber(state, WRONG_VALUE, POLY_COEFF_MODULUS_MAX, 0);
+  if(InterpreterWasError(state)) return;
+  if(state->char_buffer != '\n' && state->char_buffer != EOF) {
+    InterpreterReportError(state, WRONG_VALUE);
+    return;
+  }
+  if(modulus == 1) {
+    InterpreterReportError(state, WRONG_VALUE);
+    return;
+  }
+
+  PolyCoeffSetModulus(modulus);
+
+  // All the polynomials on the stack are reduced with the new modulus
+  const int size = StackSize(&(state->poly_stack));
+  Poly** polys = MALLOCATE_ARRAY(Poly*, (size > 0) ? size : 1);
+  for(int i=0;i<size;++i) {
+    polys[i] = (Poly*) StackPop(&(state->poly_stack));
+    PolyReduceCoeffs(polys[i]);
+  }
+  for(int i=size-1;i>=0;--i) {
+    StackPush(&(state->poly_stack), polys[i]);
+  }
+  free(polys);
+}
+
 /*
 * NEG stack operation impl
 */
@@ -392,15 +499,9 @@ void InterpreterOpNeg(InterpreterState* state) {
     InterpreterReportError(state, WRONG_COMMAND);
     return;
   }
-  Poly* ret = MALLOCATE(Poly);
   Poly* a = (Poly*) StackPop(&(state->poly_stack));
-
-  *ret = PolyNeg(a);
-
-  PolyDestroy(a);
-  free(a);
-
-  StackPush(&(state->poly_stack), ret);
+  PolyNegInPlace(a);
+  StackPush(&(state->poly_stack), a);
 }
 
 /*
@@ -411,18 +512,13 @@ void InterpreterOpSub(InterpreterState* state) {
     InterpreterReportError(state, WRONG_COMMAND);
     return;
   }
-  Poly* ret = MALLOCATE(Poly);
   Poly* a = (Poly*) StackPop(&(state->poly_stack));
   Poly* b = (Poly*) StackPop(&(state->poly_stack));
 
-  *ret = PolySub(a, b);
-
-  PolyDestroy(a);
-  PolyDestroy(b);
-  free(a);
+  PolySubTakeInPlace(a, b);
   free(b);
 
-  StackPush(&(state->poly_stack), ret);
+  StackPush(&(state->poly_stack), a);
 }
 
 /*
@@ -439,10 +535,11 @@ void InterpreterOpIsEq(InterpreterState* state) {
   StackPush(&(state->poly_stack), a);
 
   if(PolyIsEq(a, b)) {
-    printf("1\n");
+    OutputBufferPut(&(state->output), '1');
   } else {
-    printf("0\n");
+    OutputBufferPut(&(state->output), '0');
   }
+  OutputBufferEndLine(&(state->output));
 }
 
 /*
@@ -453,7 +550,8 @@ void InterpreterOpDeg(InterpreterState* state) {
     InterpreterReportError(state, WRONG_COMMAND);
     return;
   }
-  printf("%d\n", PolyDeg((Poly*) StackFirst(&(state->poly_stack))));
+  OutputBufferWriteLong(&(state->output), PolyDeg((Poly*) StackFirst(&(state->poly_stack))));
+  OutputBufferEndLine(&(state->output));
 }
 
 /*
@@ -471,77 +569,95 @@ void InterpreterOpDegBy(InterpreterState* state) {
     return;
   }
 
-  printf("%d\n", PolyDegBy((Poly*) StackFirst(&(state->poly_stack)), x));
+  OutputBufferWriteLong(&(state->output), PolyDegBy((Poly*) StackFirst(&(state->poly_stack)), x));
+  OutputBufferEndLine(&(state->output));
 }
 
 /*
 * AT stack operation impl
 */
 void InterpreterOpAt(InterpreterState* state) {
-  long long x = InterpreterParseNumber(state, WRONG_VALUE, NUMBER_MAX, NUMBER_MIN);
+  const poly_coeff_t x = InterpreterParseCoeff(state, WRONG_VALUE);
   if(InterpreterWasError(state)) return;
   if(state->char_buffer != '\n' && state->char_buffer != EOF) {
+    PolyCoeffDestroy(x);
     InterpreterReportError(state, WRONG_VALUE);
     return;
   }
 
   Poly* a = (Poly*) StackPop(&(state->poly_stack));
-  Poly* ret = MALLOCATE(Poly);
-  *ret = PolyAt(a, x);
-  //PolyPrint(ret);
-  StackPush(&(state->poly_stack), ret);
+  PolyAtInPlace(a, x);
+  PolyCoeffDestroy(x);
+  StackPush(&(state->poly_stack), a);
+}
 
-  PolyDestroy(a);
-  free(a);
+
+/*
+* Write coefficient to the output
+*/
+static void InterpreterWriteCoeff(OutputBuffer* out, poly_coeff_t c) {
+  if(PolyCoeffIsSmall(c)) {
+    OutputBufferWriteLong(out, c);
+    return;
+  }
+  // Every 3 bits take less than one decimal digit
+  char* str = MALLOCATE_ARRAY(char, PolyCoeffBits(c) / 3 + 3);
+  OutputBufferWrite(out, str, PolyCoeffSprintf(str, c));
+  free(str);
 }
 
+/*
+* Write `,EXP)` ending monomial to the output
+*/
+static inline void InterpreterWriteMonoEnd(OutputBuffer* out, poly_exp_t exp) {
+  OutputBufferPut(out, ',');
+  OutputBufferWriteLong(out, exp);
+  OutputBufferPut(out, ')');
+}
 
 /*
 * Print poly in interpreter manner
 */
-void InterpreterPrintPolyRec(Poly* p, poly_coeff_t freeTerm) {
+static void InterpreterPrintPolyRec(OutputBuffer* out, Poly* p, poly_coeff_t freeTerm) {
+  const poly_coeff_t constTerm = PolyCoeffAdd(PolyGetConstTerm(p), freeTerm);
   if(PolyIsCoeff(p)) {
-    printf("%ld", PolyGetConstTerm(p) + freeTerm);
+    InterpreterWriteCoeff(out, constTerm);
   } else {
     int index = 0;
-    LOOP_LIST(&(p->monos), i) {
-      Mono* mono = (Mono*) ListGetValue(i);
+    LOOP_POLY(p, mono) {
       if(index != 0) {
-        printf("+");
-        printf("(");
-        InterpreterPrintPolyRec(&(mono->p), 0);
-        printf(",");
-        printf("%d)", mono->exp);
+        OutputBufferWrite(out, "+(", 2);
+        InterpreterPrintPolyRec(out, &(mono->p), 0);
+        InterpreterWriteMonoEnd(out, mono->exp);
         ++index;
       } else if(mono->exp == 0) {
-        printf("(");
-        InterpreterPrintPolyRec(&(mono->p), p->c + freeTerm);
-        printf(",");
-        printf("%d)", mono->exp);
+        OutputBufferPut(out, '(');
+        InterpreterPrintPolyRec(out, &(mono->p), constTerm);
+        InterpreterWriteMonoEnd(out, mono->exp);
         ++index;
-      } else if(p->c+freeTerm != 0){
-        printf("(%ld,0)", p->c + freeTerm);
-        printf("+(");
-        InterpreterPrintPolyRec(&(mono->p), 0);
-        printf(",");
-        printf("%d)", mono->exp);
+      } else if(constTerm != 0){
+        OutputBufferPut(out, '(');
+        InterpreterWriteCoeff(out, constTerm);
+        OutputBufferWrite(out, ",0)+(", 5);
+        InterpreterPrintPolyRec(out, &(mono->p), 0);
+        InterpreterWriteMonoEnd(out, mono->exp);
         ++index;
       } else if(mono->exp != 0) {
-        printf("(");
-        InterpreterPrintPolyRec(&(mono->p), 0);
-        printf(",");
-        printf("%d)", mono->exp);
+        OutputBufferPut(out, '(');
+        InterpreterPrintPolyRec(out, &(mono->p), 0);
+        InterpreterWriteMonoEnd(out, mono->exp);
         ++index;
       }
     }
   }
+  PolyCoeffDestroy(constTerm);
 }
 
 /*
 * Print poly in interpreter manner
 */
-void InterpreterPrintPoly(Poly* p) {
-  InterpreterPrintPolyRec(p, 0);
+void InterpreterPrintPoly(InterpreterState* state, Poly* p) {
+  InterpreterPrintPolyRec(&(state->output), p, 0);
 }
 
 /*
@@ -552,8 +668,8 @@ void InterpreterOpPrint(InterpreterState* state) {
     InterpreterReportError(state, WRONG_COMMAND);
     return;
   }
-  InterpreterPrintPoly((Poly*) StackFirst(&(state->poly_stack)));
-  printf("\n");
+  InterpreterPrintPoly(state, (Poly*) StackFirst(&(state->poly_stack)));
+  OutputBufferEndLine(&(state->output));
 }
 
 /*
@@ -572,8 +688,109 @@ void InterpreterOpDump(InterpreterState* state) {
     InterpreterReportError(state, WRONG_COMMAND);
     return;
   }
+  // Stack is printed by stdio, so the buffered output must go first
+  OutputBufferFlush(&(state->output));
   StackPrint(&(state->poly_stack), InterpreterPolyStackPrinter);
   printf("\n");
+  fflush(stdout);
+}
+
+/*
+* Parse path of file given as the rest of line.
+* Returned path must be freed by the caller (NULL on error).
+*/
+static char* InterpreterParsePath(InterpreterState* state) {
+  int alloc_size = 32;
+  int size = 0;
+  char* path = MALLOCATE_ARRAY(char, alloc_size);
+  while(state->char_buffer != '\n' && state->char_buffer != EOF) {
+    if(size + 1 == alloc_size) {
+      alloc_size *= 2;
+      path = MREALLOCATE_ARRAY(char, alloc_size, path);
+    }
+    path[size++] = state->char_buffer;
+    InterpreterNextChar(state);
+  }
+  path[size] = '\0';
+  if(size == 0) {
+    free(path);
+    InterpreterReportError(state, WRONG_FILE);
+    return NULL;
+  }
+  return path;
+}
+
+/*
+* SAVE stack operation impl
+*/
+void InterpreterOpSave(InterpreterState* state) {
+  char* path = InterpreterParsePath(state);
+  if(InterpreterWasError(state)) return;
+  OutputBuffer out;
+  const bool opened = OutputBufferOpen(&out, path, OUTPUT_BUFFER_BLOCK_SIZE);
+  free(path);
+  if(!opened) {
+    InterpreterReportError(state, WRONG_FILE);
+    return;
+  }
+
+  // Polynomials are saved from the bottom of the stack
+  const int size = StackSize(&(state->poly_stack));
+  Poly** polys = MALLOCATE_ARRAY(Poly*, (size > 0) ? size : 1);
+  for(int i=size-1;i>=0;--i) {
+    polys[i] = (Poly*) StackPop(&(state->poly_stack));
+  }
+  PolyBinaryWriteHeader(&out, (size_t) size);
+  for(int i=0;i<size;++i) {
+    PolySave(polys[i], &out);
+    StackPush(&(state->poly_stack), polys[i]);
+  }
+  free(polys);
+
+  if(!OutputBufferDestroy(&out)) {
+    InterpreterReportError(state, WRONG_FILE);
+  }
+}
+
+/*
+* LOAD stack operation impl
+*/
+void InterpreterOpLoad(InterpreterState* state) {
+  char* path = InterpreterParsePath(state);
+  if(InterpreterWasError(state)) return;
+  InputBuffer in;
+  const bool opened = InputBufferOpen(&in, path, INPUT_BUFFER_BLOCK_SIZE);
+  free(path);
+  if(!opened) {
+    InterpreterReportError(state, WRONG_FILE);
+    return;
+  }
+
+  // Polynomials are pushed as they are read (the last one is on the top)
+  size_t count = 0;
+  size_t loaded = 0;
+  bool valid = PolyBinaryReadHeader(&in, &count);
+  while(valid && loaded < count) {
+    Poly* p = MALLOCATE(Poly);
+    valid = PolyLoad(&in, p);
+    if(!valid) {
+      free(p);
+      break;
+    }
+    StackPush(&(state->poly_stack), p);
+    ++loaded;
+  }
+  valid = valid && InputBufferGet(&in) == EOF;
+  InputBufferDestroy(&in);
+
+  if(!valid) {
+    for(size_t i=0;i<loaded;++i) {
+      Poly* p = (Poly*) StackPop(&(state->poly_stack));
+      PolyDestroy(p);
+      free(p);
+    }
+    InterpreterReportError(state, WRONG_FILE);
+  }
 }
 
 /*
@@ -610,7 +827,7 @@ void InterpreterOpForceReturn(InterpreterState* state) {
 /*
 * Number of all valid commands
 */
-#define INTERPRETER_COMMANDS_COUNT 19
+#define INTERPRETER_COMMANDS_COUNT 22
 
 /*
 * All command bindings
@@ -632,18 +849,40 @@ static const InterpreterCommandBinding INTERPRETER_COMMANDS[INTERPRETER_COMMANDS
   { .required_params = 1, .command = "POP",      .action = InterpreterOpPop         },
   { .required_params = 1, .command = "POW",      .action = InterpreterOpPow         },
   { .required_params = 0, .command = "COMPOSE",  .action = InterpreterOpCompose     },
+  { .required_params = 0, .command = "MOD",      .action = InterpreterOpMod         },
   { .required_params = 0, .command = "DUMP",     .action = InterpreterOpDump        },
+  { .required_params = 0, .command = "SAVE",     .action = InterpreterOpSave        },
+  { .required_params = 0, .command = "LOAD",     .action = InterpreterOpLoad        },
   { .required_params = 0, .command = "CLEAN",    .action = InterpreterOpClean       },
   { .required_params = 0, .command = "EXIT",     .action = InterpreterOpForceReturn }
 };
 
+/*
+* Try to parse the rest of mono `,EXP` after its coefficient @p fact.
+* The coefficient is taken by the mono (or destroyed on error).
+*/
+static Mono InterpreterParseMonoExp(InterpreterState* state, Poly* fact) {
+  if(state->char_buffer != ',') {
+    InterpreterReportError(state, INVALID_POLY_INPUT);
+    PolyDestroy(fact);
+    return MonoZero();
+  }
+  InterpreterNextChar(state);
+  const poly_coeff_t exp = (poly_coeff_t)InterpreterParseNumber(state, INVALID_POLY_INPUT, UINT_MAX, 0);
+  if(InterpreterWasError(state)) {
+    PolyDestroy(fact);
+    return MonoZero();
+  }
+  return MonoFromPoly(fact, exp);
+}
+
 /*
 * Try to parse mono at current character
 */
 Mono InterpreterParseMono(InterpreterState* state) {
   Poly fact = PolyZero();
   if(InterpreterCurrentIsDigit(state) || state->char_buffer == '-') {
-    long long coeff = InterpreterParseNumber(state, INVALID_POLY_INPUT, NUMBER_MAX, NUMBER_MIN);
+    const poly_coeff_t coeff = InterpreterParseCoeff(state, INVALID_POLY_INPUT);
     if(InterpreterWasError(state)) {
       return MonoZero();
     }
@@ -651,76 +890,142 @@ Mono InterpreterParseMono(InterpreterState* state) {
   } else if(state->char_buffer == '(') {
     fact = InterpreterParsePoly(state);
     if(InterpreterWasError(state)) {
+      PolyDestroy(&fact);
       return MonoZero();
     }
   } else {
     InterpreterReportError(state, INVALID_POLY_INPUT);
     return MonoZero();
   }
-  if(state->char_buffer != ',') {
-    InterpreterReportError(state, INVALID_POLY_INPUT);
-    return MonoZero();
-  }
-  poly_coeff_t exp = 0;
-  InterpreterNextChar(state);
-  exp = (poly_coeff_t)InterpreterParseNumber(state, INVALID_POLY_INPUT, UINT_MAX, 0);
-  if(InterpreterWasError(state)) {
-    return MonoZero();
-  }
-  Mono ret = MonoFromPoly(&fact, exp);
-  return ret;
+  return InterpreterParseMonoExp(state, &fact);
 }
 
+/*
+* Polynomial being parsed at single level of nesting
+*/
+typedef struct InterpreterParseFrame {
+  PolyBuilder builder; ///< Monos parsed so far
+  bool mono_first_flag; ///< No mono was parsed yet
+  bool allow_add; ///< Next mono can be parsed
+} InterpreterParseFrame;
 
 /*
-* Try to parse poly at current character
+* Push new frame on the stack of parsed polynomials
+* (the stack starts in the local array and moves to heap when it grows)
+*/
+static inline void InterpreterParsePushFrame(InterpreterParseFrame** frames, int* depth, int* alloc_size, InterpreterParseFrame* local) {
+  if(*depth == *alloc_size) {
+    *alloc_size *= 2;
+    if(*frames == local) {
+      *frames = MALLOCATE_ARRAY(InterpreterParseFrame, *alloc_size);
+      memcpy(*frames, local, (*depth) * sizeof(InterpreterParseFrame));
+    } else {
+      *frames = MREALLOCATE_ARRAY(InterpreterParseFrame, *alloc_size, *frames);
+    }
+  }
+  (*frames)[(*depth)++] = (InterpreterParseFrame) {
+    .builder = PolyBuilderNew(),
+    .mono_first_flag = true,
+    .allow_add = true
+  };
+}
+
+/*
+* Try to parse poly at current character.
+* Nested coefficients are parsed using explicit stack of frames
+* (instead of recursion), so the input can be nested arbitrarily deep.
 */
 Poly InterpreterParsePoly(InterpreterState* state) {
-  Poly p = PolyZero();
+  InterpreterParseFrame local[INTERPRETER_PARSE_LOCAL_FRAMES];
+  InterpreterParseFrame* frames = local;
+  int alloc_size = INTERPRETER_PARSE_LOCAL_FRAMES;
+  int depth = 0;
+  InterpreterParsePushFrame(&frames, &depth, &alloc_size, local);
 
-  bool mono_first_flag = true;
-  bool allow_add=true;
+  Poly result = PolyZero();
   while(true) {
+    InterpreterParseFrame* frame = &frames[depth-1];
+    bool frame_done = false;
+
     if(state->char_buffer == '-' || InterpreterCurrentIsDigit(state)) {
-      poly_coeff_t coeff = (poly_coeff_t)InterpreterParseNumber(state, INVALID_POLY_INPUT, NUMBER_MAX, NUMBER_MIN);
+      const poly_coeff_t coeff = InterpreterParseCoeff(state, INVALID_POLY_INPUT);
       if(InterpreterWasError(state)) {
-        return p;
+        break;
       }
-      return PolyFromCoeff(coeff);
+      PolyBuilderDestroy(&(frame->builder));
+      result = PolyFromCoeff(coeff);
+      frame_done = true;
     } else if(state->char_buffer == '(') {
-      if(!allow_add) {
+      if(!frame->allow_add) {
         InterpreterReportError(state, INVALID_POLY_INPUT);
-        return p;
+        break;
       }
       InterpreterNextChar(state);
-      Mono m = InterpreterParseMono(state);
-      if(InterpreterWasError(state)) {
-        return p;
+      if(state->char_buffer == '(') {
+        // Coefficient of the mono is parsed in the next frame
+        InterpreterParsePushFrame(&frames, &depth, &alloc_size, local);
+        continue;
       }
-      if(state->char_buffer != ')') {
+      if(!InterpreterCurrentIsDigit(state) && state->char_buffer != '-') {
         InterpreterReportError(state, INVALID_POLY_INPUT);
-        return p;
+        break;
       }
-      InterpreterNextChar(state);
-      PolyInsertMono(&p, m);
-      mono_first_flag=false;
-      allow_add=false;
+      const poly_coeff_t coeff = InterpreterParseCoeff(state, INVALID_POLY_INPUT);
+      if(InterpreterWasError(state)) {
+        break;
+      }
+      result = PolyFromCoeff(coeff);
     } else if(state->char_buffer == '+') {
-      allow_add=true;
-      if(mono_first_flag) {
+      frame->allow_add = true;
+      if(frame->mono_first_flag) {
         InterpreterReportError(state, INVALID_POLY_INPUT);
-        return p;
+        break;
       }
       InterpreterNextChar(state);
       if(state->char_buffer != '(') {
         InterpreterReportError(state, INVALID_POLY_INPUT);
-        return p;
+        break;
       }
+      continue;
     } else {
+      result = PolyBuilderBuild(&(frame->builder));
+      frame_done = true;
+    }
+
+    if(frame_done) {
+      // The polynomial is complete
+      --depth;
+      if(depth == 0) {
+        break;
+      }
+      frame = &frames[depth-1];
+    }
+
+    // Finish the mono of the frame with parsed coefficient
+    Mono m = InterpreterParseMonoExp(state, &result);
+    result = PolyZero();
+    if(InterpreterWasError(state)) {
+      break;
+    }
+    if(state->char_buffer != ')') {
+      InterpreterReportError(state, INVALID_POLY_INPUT);
+      MonoDestroy(&m);
       break;
     }
+    InterpreterNextChar(state);
+    PolyBuilderAdd(&(frame->builder), m);
+    frame->mono_first_flag = false;
+    frame->allow_add = false;
+  }
+
+  // Frames are left only if parsing failed
+  for(int i=0;i<depth;++i) {
+    PolyBuilderDestroy(&(frames[i].builder));
+  }
+  if(frames != local) {
+    free(frames);
   }
-  return p;
+  return result;
 }
 
 
@@ -767,8 +1072,8 @@ void InterpreterParseCommand(InterpreterState* state) {
 * Read characters until EOF or new line is reached
 */
 void InterpreterSeekLineEnd(InterpreterState* state) {
-  while(state->char_buffer != '\n' && state->char_buffer != EOF) {
-    InterpreterNextChar(state);
+  if(state->char_buffer != '\n' && state->char_buffer != EOF) {
+    InterpreterSkipLine(state);
   }
 }
 
@@ -801,6 +1106,9 @@ void InterpreterPrintError(InterpreterState* state) {
     case WRONG_VALUE:
       fprintf(state->err_out, "ERROR %d WRONG VALUE\n", state->error_row);
     break;
+    case WRONG_FILE:
+      fprintf(state->err_out, "ERROR %d WRONG FILE\n", state->error_row);
+    break;
     case NO_ERROR:
     break;
     case INVALID_POLY_INPUT:
@@ -826,4 +1134,8 @@ void* InterpreterStackDeallocator(void* element) {
 */
 void InterpreterCleanup(InterpreterState* state) {
   StackDestroyDeep(&(state->poly_stack), InterpreterStackDeallocator);
+  InputBufferDestroy(&(state->input));
+  OutputBufferDestroy(&(state->output));
+  ThreadPoolDestroy(state->pool);
+  state->pool = NULL;
 }
@@ -14,7 +14,7 @@
 *     p = InterpreterParsePoly(state);
 *
 *     // Print loaded polynomial
-*     PolyPrint(&p);
+*     InterpreterPrintPoly(&calc, &p);
 *
 *     // Cleanup
 *     PolyDestroy(&p);
@@ -35,6 +35,9 @@
 #include "stack.h"
 #include "memalloc.h"
 #include "poly.h"
+#include "input_buffer.h"
+#include "output_buffer.h"
+#include "poly_binary.h"
 
 #ifndef __STY_COMMON_INTERPRETER_H__
 #define __STY_COMMON_INTERPRETER_H__
@@ -74,6 +77,7 @@ typedef enum {
   WRONG_VARIABLE, ///< Invalid variable id was used
   WRONG_VALUE, ///< Invalid numerical value was used
   WRONG_COUNT, ///< Wrong count given to command
+  WRONG_FILE, ///< File cannot be read or written (or its content is not valid)
   NO_ERROR, ///< No error was reported
   INVALID_POLY_INPUT, ///< Invalid poly specification
   PROCESS_FORCE_RETURN ///< Process was forcefully closed
@@ -84,6 +88,8 @@ typedef enum {
 */
 struct InterpreterState {
   FILE* err_out; ///< Stream to write errors to
+  InputBuffer input; ///< Input the code is read from
+  OutputBuffer output; ///< Standard output of commands
   char char_buffer; ///< Input buffer
   InterpreterErrorType error_type; ///< Error flag
   int input_col; ///< Number of currently parsed column
@@ -94,6 +100,7 @@ struct InterpreterState {
   int error_row; ///< Row where flagged error happened
   bool critical_error_flag; ///< Is this error crititcal
   Stack poly_stack; ///< Stack of polynomials
+  ThreadPool* pool; ///< Thread pool used by operations (NULL if single-threaded)
 };
 
 
@@ -106,6 +113,25 @@ struct InterpreterState {
 */
 InterpreterState InterpreterNew(FILE* err_out);
 
+/**
+* Read the code from file instead of standard input.
+* Regular files are mapped into memory.
+*
+* @param[in] state : Interpreter instance
+* @param[in] path  : Path of the file
+* @return was the file opened?
+*/
+bool InterpreterOpenInput(InterpreterState* state, const char* path);
+
+/**
+* Set number of threads used by interpreter operations.
+* By default the interpreter is single-threaded.
+*
+* @param[in] state   : Interpreter instance
+* @param[in] threads : Number of threads (at least 1)
+*/
+void InterpreterSetThreads(InterpreterState* state, int threads);
+
 /**
 * Reports an error to the interpreter.
 *
@@ -168,6 +194,7 @@ void InterpreterRequestStackParams(InterpreterState* state, const int number_of_
 
 /**
 * Read data until new line is reached.
+* The skipped characters are searched in input buffer at once.
 *
 * @param[in] state : Interpreter instance
 */
@@ -197,6 +224,19 @@ char InterpreterNextChar(InterpreterState* state);
 */
 long long InterpreterParseNumber(InterpreterState* state, InterpreterErrorType error_when_failed, long long maximum, long long minimum);
 
+/**
+* Try to parse a coefficient at current location.
+* Coefficients are not limited (see PolyCoeffIsSmall),
+* so an error of specified type is raised only when the number
+* starts from non-digit.
+* The value is reduced (see PolyCoeffReduce) and owned by the caller.
+*
+* @param[in]  state             : Interpreter instance
+* @param[in]  error_when_failed : Type of error raised when the number cannot be parsed
+* @return parsed coefficient
+*/
+poly_coeff_t InterpreterParseCoeff(InterpreterState* state, InterpreterErrorType error_when_failed);
+
 /**
 * Print poly in interpreter manner.
 * The format is as follows:
@@ -222,9 +262,12 @@ long long InterpreterParseNumber(InterpreterState* state, InterpreterErrorType e
 *   PolyP( PolyC(12), 0, PolyC(13), 1 )   // ((12,0),(13,1))
 * @endcode
 *
-* @param[in] p : Polynomial to be printed
+* The polynomial is written to the output buffer of interpreter.
+*
+* @param[in] state : Interpreter instance
+* @param[in] p     : Polynomial to be printed
 */
-void InterpreterPrintPoly(Poly* p);
+void InterpreterPrintPoly(InterpreterState* state, Poly* p);
 
 /**
 * Try to parse poly at current character.
@@ -234,8 +277,9 @@ void InterpreterPrintPoly(Poly* p);
 *   where `POLYN` is n-th monomial coefficent
 *   and `EXPN` is its variable exponent.
 *
-* This function is used together with InterpreterParseMono to
-* parse polynomials recursively.
+* Nested coefficients are parsed iteratively (using explicit stack
+* instead of recursion), so the nesting depth of input is not limited
+* by the size of native stack.
 *
 * Examples:
 * @code
@@ -270,8 +314,7 @@ Poly InterpreterParsePoly(InterpreterState* state);
 * (for more see InterpreterParsePoly)
 * And exp is number - variable exponent.
 *
-* This function is used together with InterpreterParsePoly to
-* parse polynomials recursively.
+* Polynomial coefficients are parsed with InterpreterParsePoly.
 *
 * Examples:
 * @code
@@ -306,6 +349,7 @@ void InterpreterParseCommand(InterpreterState* state);
 
 /**
 * Read characters until EOF or new line is reached.
+* The skipped characters are searched in input buffer at once.
 *
 * @param[in] state : Interpreter instance
 */
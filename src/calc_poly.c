@@ -9,6 +9,13 @@
 #include "utils.h"
 #include "calc_interpreter.h"
 
+/**
+* @def CALC_MAX_THREADS
+*
+* Maximum number of threads accepted by `-t` option
+*/
+#define CALC_MAX_THREADS 1024
+
 
 /**
 * Try to parse one line of input
@@ -61,6 +68,41 @@ void ReadInputLine(InterpreterState* state) {
   }
 }
 
+/**
+* Parse command line options: number of threads
+* (`-t N` or `--threads N`, the default is 1 thread)
+* and optional path of input file (the default is stdin).
+*
+* @param[in]  argc       : main argc
+* @param[in]  argv       : main argv
+* @param[out] threads    : Parsed number of threads
+* @param[out] input_path : Parsed input path (NULL if not given)
+* @return are the options valid?
+*/
+bool ParseOptions(int argc, char* argv[], int* threads, const char** input_path) {
+  *threads = 1;
+  *input_path = NULL;
+  for(int i=1;i<argc;++i) {
+    if(strcmp(argv[i], "-t") != 0 && strcmp(argv[i], "--threads") != 0) {
+      if(*input_path != NULL || argv[i][0] == '-') {
+        return false;
+      }
+      *input_path = argv[i];
+      continue;
+    }
+    if(i+1 >= argc) {
+      return false;
+    }
+    char* end = NULL;
+    const long value = strtol(argv[++i], &end, 10);
+    if(*end != '\0' || value < 1 || value > CALC_MAX_THREADS) {
+      return false;
+    }
+    *threads = (int)value;
+  }
+  return true;
+}
+
 /**
 * Entrypoint to the wroking calc application
 *
@@ -69,15 +111,25 @@ void ReadInputLine(InterpreterState* state) {
 * @return exit code
 */
 int main(int argc, char* argv[]) {
-  (void)argc;
-  (void)argv;
+  int threads = 1;
+  const char* input_path = NULL;
+  if(!ParseOptions(argc, argv, &threads, &input_path)) {
+    fprintf(stderr, "Usage: %s [-t THREADS] [FILE]\n", argv[0]);
+    return 1;
+  }
 
   // Create new instance of parser
   InterpreterState instance = InterpreterNew(NULL);
   InterpreterState* state = &instance;
+  if(input_path != NULL && !InterpreterOpenInput(state, input_path)) {
+    fprintf(stderr, "Cannot open %s\n", input_path);
+    InterpreterCleanup(state);
+    return 1;
+  }
+  InterpreterSetThreads(state, threads);
 
   //
-  // Parse input from stdin continously
+  // Parse input (stdin or the file) continously
   //
   while(state->char_buffer != EOF) {
     // Read next line
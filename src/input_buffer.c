@@ -0,0 +1,146 @@
+/*
+*  Buffered reading of input.
+*
+*  @author Piotr Styczyński <piotrsty1@gmail.com>
+*  @copyright MIT
+*  @date 2017-05-13
+*/
+#define _POSIX_C_SOURCE 200809L
+#include "utils.h"
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "memalloc.h"
+#include "input_buffer.h"
+
+/*
+* Create input buffer reading file descriptor in blocks
+*/
+InputBuffer InputBufferFromFd(int fd, size_t block_size) {
+  assert(block_size > 0);
+  char* block = MALLOCATE_ARRAY(char, block_size);
+  return (InputBuffer) {
+    .data = block,
+    .size = 0,
+    .pos = 0,
+    .block = block,
+    .block_size = block_size,
+    .fd = fd,
+    .owns_fd = false,
+    .mapping = NULL,
+    .mapping_size = 0
+  };
+}
+
+/*
+* Open file as input buffer (mapped into memory if possible)
+*/
+bool InputBufferOpen(InputBuffer* buffer, const char* path, size_t block_size) {
+  const int fd = open(path, O_RDONLY);
+  if(fd < 0) return false;
+
+  struct stat info;
+  if(fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+    void* mapping = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(mapping != MAP_FAILED) {
+      // The whole file is parsed once from the beginning to the end
+      posix_madvise(mapping, (size_t) info.st_size, POSIX_MADV_SEQUENTIAL);
+      close(fd);
+      *buffer = (InputBuffer) {
+        .data = mapping,
+        .size = (size_t) info.st_size,
+        .pos = 0,
+        .block = NULL,
+        .block_size = 0,
+        .fd = -1,
+        .owns_fd = false,
+        .mapping = mapping,
+        .mapping_size = (size_t) info.st_size
+      };
+      return true;
+    }
+  }
+
+  // Pipes, devices and empty files are read in blocks
+  *buffer = InputBufferFromFd(fd, block_size);
+  buffer->owns_fd = true;
+  return true;
+}
+
+/*
+* Read next block of input
+*/
+int InputBufferRefill(InputBuffer* buffer) {
+  assert(buffer->pos >= buffer->size);
+  if(buffer->fd < 0) return EOF;
+
+  ssize_t count;
+  do {
+    count = read(buffer->fd, buffer->block, buffer->block_size);
+  } while(count < 0 && errno == EINTR);
+
+  if(count <= 0) {
+    // Nothing more can be read
+    if(buffer->owns_fd) close(buffer->fd);
+    buffer->fd = -1;
+    buffer->owns_fd = false;
+    buffer->size = 0;
+    buffer->pos = 0;
+    return EOF;
+  }
+  buffer->size = (size_t) count;
+  buffer->pos = 1;
+  return (unsigned char) buffer->data[0];
+}
+
+/*
+* Skip input until the end of line (inclusive)
+*/
+int InputBufferSkipLine(InputBuffer* buffer, size_t* skipped) {
+  *skipped = 0;
+  while(true) {
+    const char* begin = buffer->data + buffer->pos;
+    const size_t left = buffer->size - buffer->pos;
+    const char* end = memchr(begin, '\n', left);
+    if(end != NULL) {
+      *skipped += (size_t) (end - begin);
+      buffer->pos += (size_t) (end - begin) + 1;
+      return '\n';
+    }
+    *skipped += left;
+    buffer->pos = buffer->size;
+
+    const int c = InputBufferRefill(buffer);
+    if(c == EOF) return EOF;
+    if(c == '\n') return '\n';
+    ++(*skipped);
+  }
+}
+
+/*
+* Free input buffer
+*/
+void InputBufferDestroy(InputBuffer* buffer) {
+  if(buffer->mapping != NULL) {
+    munmap(buffer->mapping, buffer->mapping_size);
+  }
+  if(buffer->owns_fd) {
+    close(buffer->fd);
+  }
+  free(buffer->block);
+  *buffer = (InputBuffer) {
+    .data = NULL,
+    .size = 0,
+    .pos = 0,
+    .block = NULL,
+    .block_size = 0,
+    .fd = -1,
+    .owns_fd = false,
+    .mapping = NULL,
+    .mapping_size = 0
+  };
+}
@@ -0,0 +1,118 @@
+/** @file
+*  Buffered reading of input.
+*
+*  Input is read in large blocks (or the whole file is mapped into memory)
+*  and characters are taken from the memory, so reading single character
+*  costs no library call.
+*
+*  Usage:
+*  @code
+*     #include <input_buffer.h>
+*      ...
+*     InputBuffer input = InputBufferFromFd(0, INPUT_BUFFER_BLOCK_SIZE); // stdin
+*     int c;
+*     while((c = InputBufferGet(&input)) != EOF) {
+*       ...
+*     }
+*     InputBufferDestroy(&input);
+*  @endcode
+*
+*  @author Piotr Styczyński <piotrsty1@gmail.com>
+*  @copyright MIT
+*  @date 2017-05-13
+*/
+#include "utils.h"
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifndef __STY_COMMON_INPUT_BUFFER_H__
+#define __STY_COMMON_INPUT_BUFFER_H__
+
+/**
+* @def INPUT_BUFFER_BLOCK_SIZE
+*
+* Default size of block of input read at once (in bytes)
+*/
+#ifndef INPUT_BUFFER_BLOCK_SIZE
+#define INPUT_BUFFER_BLOCK_SIZE (1 << 16)
+#endif
+
+/**
+* Buffered input.
+* The buffered bytes are either the block read from file descriptor
+* or the whole mapped file.
+*/
+typedef struct InputBuffer {
+  const char* data; ///< Buffered bytes
+  size_t size; ///< Number of buffered bytes
+  size_t pos; ///< Position of the next byte in buffered bytes
+  char* block; ///< Block the descriptor is read into (NULL if file is mapped)
+  size_t block_size; ///< Size of the block
+  int fd; ///< Descriptor read in blocks (-1 if there's nothing more to read)
+  bool owns_fd; ///< Is the descriptor closed with the buffer
+  void* mapping; ///< Mapped file (NULL if file is not mapped)
+  size_t mapping_size; ///< Size of the mapped file
+} InputBuffer;
+
+/**
+* Create input buffer reading file descriptor in blocks.
+* The descriptor is not closed with the buffer.
+*
+* @param[in] fd         : File descriptor
+* @param[in] block_size : Size of block read at once
+* @return input buffer
+*/
+InputBuffer InputBufferFromFd(int fd, size_t block_size);
+
+/**
+* Open file as input buffer.
+* Regular files are mapped into memory, others are read in blocks.
+*
+* @param[out] buffer     : Created input buffer
+* @param[in]  path       : Path of file
+* @param[in]  block_size : Size of block read at once (if file is not mapped)
+* @return was the file opened?
+*/
+bool InputBufferOpen(InputBuffer* buffer, const char* path, size_t block_size);
+
+/**
+* Read next block of input.
+* Used by InputBufferGet when all buffered bytes are consumed.
+*
+* @param[in] buffer : Input buffer
+* @return next character of input (as unsigned char) or EOF
+*/
+int InputBufferRefill(InputBuffer* buffer);
+
+/**
+* Get next character of input.
+*
+* @param[in] buffer : Input buffer
+* @return next character of input (as unsigned char) or EOF
+*/
+static inline int InputBufferGet(InputBuffer* buffer) {
+  if(buffer->pos < buffer->size) {
+    return (unsigned char) buffer->data[buffer->pos++];
+  }
+  return InputBufferRefill(buffer);
+}
+
+/**
+* Skip input until the end of line (inclusive).
+* Buffered bytes are searched at once.
+*
+* @param[in]  buffer  : Input buffer
+* @param[out] skipped : Number of characters skipped before the end of line
+* @return `\n` or EOF if there is no more input
+*/
+int InputBufferSkipLine(InputBuffer* buffer, size_t* skipped);
+
+/**
+* Free input buffer (and close its file if it was opened by buffer).
+*
+* @param[in] buffer : Input buffer
+*/
+void InputBufferDestroy(InputBuffer* buffer);
+
+#endif /* __STY_COMMON_INPUT_BUFFER_H__ */
@@ -7,6 +7,7 @@
 */
 #include "utils.h"
 #include <stdlib.h>
+#include <stddef.h>
 #include <errno.h>
 #include <assert.h>
 
@@ -81,6 +82,69 @@
 #define MALLOCATE_BLOCKS(BLOCK_SIZE, LEN) \
 ( (void*) AllocateMemoryBlockArray((LEN), (BLOCK_SIZE)) )
 
+/**
+* @def MEM_ARENA_BLOCK_SIZE
+*
+* Size (in bytes) of the blocks that MemArena allocates in bulk.
+* Requests bigger than quarter of that get their own block.
+*/
+#define MEM_ARENA_BLOCK_SIZE 65536
+
+/**
+* @def ARENA_MALLOCATE(ARENA, STRUCT)
+*
+* Macro giving value of pointer to the structure @p STRUCT
+* allocated in the memory arena @p ARENA.
+*
+* NOTICE: The memory MUST NOT be freed with free.
+*         It's released only by MemArenaDestroy.
+*
+* @param[in] ARENA  : Arena to allocate from (MemArena*)
+* @param[in] STRUCT : Type to be allocated
+*/
+#define ARENA_MALLOCATE(ARENA, STRUCT) \
+( (STRUCT*) MemArenaAllocate((ARENA), sizeof(STRUCT)) )
+
+/**
+* @def ARENA_MALLOCATE_ARRAY(ARENA, STRUCT, LEN)
+*
+* Macro giving value of pointer to the array of size @p LEN
+* of structures @p STRUCT allocated in the memory arena @p ARENA.
+*
+* NOTICE: The memory MUST NOT be freed with free.
+*         It's released only by MemArenaDestroy.
+*
+* @param[in] ARENA  : Arena to allocate from (MemArena*)
+* @param[in] STRUCT : Type to be allocated
+* @param[in] LEN    : Length of array to be allocated
+*/
+#define ARENA_MALLOCATE_ARRAY(ARENA, STRUCT, LEN) \
+( (STRUCT*) MemArenaAllocate((ARENA), (size_t)(LEN) * sizeof(STRUCT)) )
+
+/** Type of single bulk-allocated block of memory arena */
+typedef struct MemArenaBlock MemArenaBlock;
+
+/**
+* Single block of memory arena.
+* Blocks are chained from the newest to the oldest one.
+*/
+struct MemArenaBlock {
+  MemArenaBlock* prev; ///< Previously allocated block
+  size_t capacity; ///< Number of bytes available in @p data
+  size_t used; ///< Number of bytes already given away from @p data
+  max_align_t data[]; ///< Memory given away by the arena
+};
+
+/**
+* Memory arena (region allocator).
+* Memory is taken from the system in big blocks and given away
+* by bumping a pointer. Single allocations cannot be freed,
+* all of them are released at once by MemArenaDestroy.
+*/
+typedef struct MemArena {
+  MemArenaBlock* top; ///< Block that allocations are currently taken from
+} MemArena;
+
 /**
 * Function allocating @p size bytes.
 *
@@ -157,4 +221,92 @@ static inline void* ReallocateMemoryBlockArray(void* p, int count, int size) {
   return data;
 }
 
+/**
+* Create new empty memory arena.
+* No memory is allocated until the first MemArenaAllocate call.
+*
+* @return MemArena
+*/
+static inline MemArena MemArenaNew() {
+  return (MemArena) { .top = NULL };
+}
+
+/**
+* Allocates new arena block capable of holding @p capacity bytes.
+*
+* @param[in] capacity : size_t
+* @return MemArenaBlock* (not chained yet)
+*/
+static inline MemArenaBlock* MemArenaNewBlock(size_t capacity) {
+  MemArenaBlock* block = (MemArenaBlock*) AllocateMemoryBlock(
+    (int)(sizeof(MemArenaBlock) + capacity));
+  block->prev = NULL;
+  block->capacity = capacity;
+  block->used = 0;
+  return block;
+}
+
+/**
+* Function allocating @p size bytes in the memory arena @p arena.
+* Returned memory is aligned for any type.
+*
+* NOTICE: Assertion checking is done for allocation errors.
+*
+* @param[in] arena : MemArena*
+* @param[in] size  : size_t
+* @return void* to allocated memory block
+*/
+static inline void* MemArenaAllocate(MemArena* arena, size_t size) {
+  assert(arena != NULL);
+  assert(size > 0);
+
+  // Round up to keep all allocations aligned
+  size = (size + sizeof(max_align_t) - 1) / sizeof(max_align_t) * sizeof(max_align_t);
+
+  MemArenaBlock* top = arena->top;
+  if(top != NULL && top->capacity - top->used >= size) {
+    void* data = ((char*) top->data) + top->used;
+    top->used += size;
+    return data;
+  }
+
+  if(size > MEM_ARENA_BLOCK_SIZE / 4) {
+    // Big requests get dedicated block placed below the current one
+    // so the free space of the current block is not wasted
+    MemArenaBlock* block = MemArenaNewBlock(size);
+    block->used = size;
+    if(top == NULL) {
+      arena->top = block;
+    } else {
+      block->prev = top->prev;
+      top->prev = block;
+    }
+    return (void*) block->data;
+  }
+
+  MemArenaBlock* block = MemArenaNewBlock(MEM_ARENA_BLOCK_SIZE);
+  block->prev = top;
+  block->used = size;
+  arena->top = block;
+  return (void*) block->data;
+}
+
+/**
+* Releases all memory allocated in the given arena.
+* The cost depends only on number of bulk blocks
+* not on the number of allocations made.
+*
+* @param[in] arena : MemArena*
+*/
+static inline void MemArenaDestroy(MemArena* arena) {
+  if(arena == NULL) return;
+  MemArenaBlock* block = arena->top;
+  while(block != NULL) {
+    MemArenaBlock* prev = block->prev;
+    free(block);
+    block = prev;
+  }
+  arena->top = NULL;
+}
+
 #endif /* __STY_COMMON_MEMALLOC_H__ */
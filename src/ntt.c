@@ -0,0 +1,307 @@
+/*
+*  Multiplication of integer polynomials using
+*  number theoretic transform (NTT).
+*
+*  @author Piotr Styczyński <piotrsty1@gmail.com>
+*  @copyright MIT
+*  @date 2017-05-13
+*/
+#include "utils.h"
+#include <assert.h>
+#include <stdint.h>
+#include "memalloc.h"
+#include "ntt.h"
+
+#if NTT_SUPPORTED
+
+/*
+* 128-bit unsigned integer type used for modular multiplication
+*/
+__extension__ typedef unsigned __int128 NTTWide;
+
+/*
+* Number of primes used for transforms
+*/
+#define NTT_PRIMES_COUNT 3
+
+/*
+* Primes of form k*2^32 + 1 (all of them less than 2^62)
+* and their primitive roots
+*/
+static const uint64_t NTTPrimes[NTT_PRIMES_COUNT] = {
+  4611685941117976577ULL,
+  4611685692009873409ULL,
+  4611685606110527489ULL
+};
+static const uint64_t NTTPrimitiveRoots[NTT_PRIMES_COUNT] = { 3, 19, 3 };
+
+/*
+* Montgomery arithmetic context for single prime
+*/
+typedef struct NTTField {
+  uint64_t p; ///< Prime modulus
+  uint64_t p_inv_neg; ///< -p^(-1) mod 2^64
+  uint64_t r2; ///< 2^128 mod p
+} NTTField;
+
+/*
+* Plain modular multiplication (used only outside the transforms)
+*/
+static inline uint64_t NTTMulModPlain(uint64_t a, uint64_t b, uint64_t p) {
+  return (uint64_t)(((NTTWide)a * b) % p);
+}
+
+/*
+* Plain modular subtraction
+*/
+static inline uint64_t NTTSubModPlain(uint64_t a, uint64_t b, uint64_t p) {
+  return (a >= b) ? a - b : a + p - b;
+}
+
+/*
+* Plain modular exponentiation
+*/
+static uint64_t NTTPowModPlain(uint64_t base, uint64_t exp, uint64_t p) {
+  uint64_t result = 1;
+  base %= p;
+  while(exp) {
+    if(exp & 1) result = NTTMulModPlain(result, base, p);
+    base = NTTMulModPlain(base, base, p);
+    exp >>= 1;
+  }
+  return result;
+}
+
+/*
+* Creates Montgomery context for prime @p p
+*/
+static NTTField NTTFieldNew(uint64_t p) {
+  // Newton iteration doubles number of correct bits of inverse
+  uint64_t inv = p;
+  for(int i=0;i<5;++i) {
+    inv *= 2 - p * inv;
+  }
+  const uint64_t r = (uint64_t)(((NTTWide)1 << 64) % p);
+  return (NTTField) {
+    .p = p,
+    .p_inv_neg = (uint64_t)0 - inv,
+    .r2 = NTTMulModPlain(r, r, p)
+  };
+}
+
+/*
+* Montgomery reduction: returns x * 2^(-64) mod p
+* (requires x < p * 2^64)
+*/
+static inline uint64_t NTTReduce(const NTTField* f, NTTWide x) {
+  const uint64_t m = (uint64_t)x * f->p_inv_neg;
+  const uint64_t t = (uint64_t)((x + (NTTWide)m * f->p) >> 64);
+  return (t >= f->p) ? t - f->p : t;
+}
+
+/*
+* Montgomery multiplication
+*/
+static inline uint64_t NTTMul(const NTTField* f, uint64_t a, uint64_t b) {
+  return NTTReduce(f, (NTTWide)a * b);
+}
+
+/*
+* Modular addition
+*/
+static inline uint64_t NTTAdd(const NTTField* f, uint64_t a, uint64_t b) {
+  const uint64_t s = a + b;
+  return (s >= f->p) ? s - f->p : s;
+}
+
+/*
+* Modular subtraction
+*/
+static inline uint64_t NTTSub(const NTTField* f, uint64_t a, uint64_t b) {
+  return NTTSubModPlain(a, b, f->p);
+}
+
+/*
+* Converts value to Montgomery form
+*/
+static inline uint64_t NTTToField(const NTTField* f, uint64_t a) {
+  return NTTMul(f, a % f->p, f->r2);
+}
+
+/*
+* Converts signed value to Montgomery form
+*/
+static inline uint64_t NTTToFieldSigned(const NTTField* f, long a) {
+  const uint64_t abs_value = (a >= 0) ? (uint64_t)a : (uint64_t)0 - (uint64_t)a;
+  const uint64_t r = NTTToField(f, abs_value);
+  return (a >= 0 || r == 0) ? r : f->p - r;
+}
+
+/*
+* Fills @p table with powers of @p root (first @p len of them)
+* All values are in Montgomery form.
+*/
+static void NTTPowersTable(const NTTField* f, uint64_t root, uint64_t* table, int len) {
+  uint64_t w = NTTToField(f, 1);
+  for(int i=0;i<len;++i) {
+    table[i] = w;
+    w = NTTMul(f, w, root);
+  }
+}
+
+/*
+* Forward transform (decimation in frequency).
+* The result is in bit-reversed order.
+*/
+static void NTTForward(const NTTField* f, uint64_t* a, int n, const uint64_t* roots) {
+  for(int len=n;len>=2;len>>=1) {
+    const int half = len / 2;
+    const int step = n / len;
+    for(int i=0;i<n;i+=len) {
+      for(int j=0;j<half;++j) {
+        const uint64_t u = a[i+j];
+        const uint64_t v = a[i+j+half];
+        a[i+j] = NTTAdd(f, u, v);
+        a[i+j+half] = NTTMul(f, NTTSub(f, u, v), roots[j*step]);
+      }
+    }
+  }
+}
+
+/*
+* Inverse transform (decimation in time) without scaling.
+* The input must be in bit-reversed order.
+*/
+static void NTTInverse(const NTTField* f, uint64_t* a, int n, const uint64_t* inv_roots) {
+  for(int len=2;len<=n;len<<=1) {
+    const int half = len / 2;
+    const int step = n / len;
+    for(int i=0;i<n;i+=len) {
+      for(int j=0;j<half;++j) {
+        const uint64_t u = a[i+j];
+        const uint64_t v = NTTMul(f, a[i+j+half], inv_roots[j*step]);
+        a[i+j] = NTTAdd(f, u, v);
+        a[i+j+half] = NTTSub(f, u, v);
+      }
+    }
+  }
+}
+
+/*
+* Computes product of @p a and @p b modulo single prime.
+* Residues of product coefficients are stored in @p residues.
+*/
+static void NTTMultiplyModPrime(int prime_index, const long* a, int na, const long* b, int nb,
+                                int n, uint64_t* fa, uint64_t* fb, uint64_t* roots, uint64_t* residues) {
+  const NTTField f = NTTFieldNew(NTTPrimes[prime_index]);
+  const uint64_t p = f.p;
+
+  // Primitive n-th root of unity
+  const uint64_t w = NTTPowModPlain(NTTPrimitiveRoots[prime_index], (p - 1) / (uint64_t)n, p);
+  const uint64_t* inv_roots = roots + n/2;
+  NTTPowersTable(&f, NTTToField(&f, w), roots, n/2);
+  NTTPowersTable(&f, NTTToField(&f, NTTPowModPlain(w, p - 2, p)), roots + n/2, n/2);
+
+  for(int i=0;i<n;++i) {
+    fa[i] = (i < na) ? NTTToFieldSigned(&f, a[i]) : 0;
+    fb[i] = (i < nb) ? NTTToFieldSigned(&f, b[i]) : 0;
+  }
+  NTTForward(&f, fa, n, roots);
+  NTTForward(&f, fb, n, roots);
+  for(int i=0;i<n;++i) {
+    fa[i] = NTTMul(&f, fa[i], fb[i]);
+  }
+  NTTInverse(&f, fa, n, inv_roots);
+
+  // Scaling by 1/n and leaving Montgomery form at once
+  const uint64_t n_inv = NTTPowModPlain((uint64_t)n, p - 2, p);
+  const int nr = na + nb - 1;
+  for(int i=0;i<nr;++i) {
+    residues[i] = NTTMulModPlain(NTTReduce(&f, fa[i]), n_inv, p);
+  }
+}
+
+/*
+* Multiply two integer polynomials (see ntt.h)
+*
+* Each coefficient of exact product has absolute value less than
+* 2^126 * min(na, nb), so it is uniquely determined by residues modulo
+* three primes of 62 bits. Residues are combined with Garner's algorithm
+* and the (signed) value is taken modulo 2^64.
+*/
+bool NTTMultiply(const long* a, int na, const long* b, int nb, long* result) {
+  assert(na > 0 && nb > 0);
+  const int nr = na + nb - 1;
+  if(nr > (1 << NTT_MAX_LENGTH_LOG)) {
+    return false;
+  }
+  int n = 2;
+  while(n < nr) n <<= 1;
+
+  uint64_t* fa = MALLOCATE_ARRAY(uint64_t, n);
+  uint64_t* fb = MALLOCATE_ARRAY(uint64_t, n);
+  uint64_t* roots = MALLOCATE_ARRAY(uint64_t, n);
+  uint64_t* residues[NTT_PRIMES_COUNT];
+  for(int k=0;k<NTT_PRIMES_COUNT;++k) {
+    residues[k] = MALLOCATE_ARRAY(uint64_t, nr);
+    NTTMultiplyModPrime(k, a, na, b, nb, n, fa, fb, roots, residues[k]);
+  }
+  free(fa);
+  free(fb);
+  free(roots);
+
+  const uint64_t p0 = NTTPrimes[0];
+  const uint64_t p1 = NTTPrimes[1];
+  const uint64_t p2 = NTTPrimes[2];
+  const uint64_t p0_inv_mod_p1 = NTTPowModPlain(p0 % p1, p1 - 2, p1);
+  const uint64_t p0p1_mod_p2 = NTTMulModPlain(p0 % p2, p1 % p2, p2);
+  const uint64_t p0p1_inv_mod_p2 = NTTPowModPlain(p0p1_mod_p2, p2 - 2, p2);
+  // Product of all primes modulo 2^64 (wrapping arithmetic)
+  const uint64_t p0p1 = p0 * p1;
+  const uint64_t modulus = p0p1 * p2;
+
+  for(int i=0;i<nr;++i) {
+    // Mixed radix digits: x = d0 + d1*p0 + d2*p0*p1
+    const uint64_t d0 = residues[0][i];
+    const uint64_t d1 = NTTMulModPlain(NTTSubModPlain(residues[1][i], d0 % p1, p1), p0_inv_mod_p1, p1);
+    const uint64_t t = NTTSubModPlain(residues[2][i],
+      (uint64_t)(((NTTWide)d0 + (NTTWide)d1 * p0) % p2), p2);
+    const uint64_t d2 = NTTMulModPlain(t, p0p1_inv_mod_p2, p2);
+
+    uint64_t value = d0 + d1 * p0 + d2 * p0p1;
+    // Digits of (p0*p1*p2 - 1)/2 are ((p2-1)/2, (p1-1)/2, (p0-1)/2)
+    bool negative = false;
+    if(d2 != (p2 - 1) / 2) {
+      negative = (d2 > (p2 - 1) / 2);
+    } else if(d1 != (p1 - 1) / 2) {
+      negative = (d1 > (p1 - 1) / 2);
+    } else {
+      negative = (d0 > (p0 - 1) / 2);
+    }
+    if(negative) {
+      value -= modulus;
+    }
+    result[i] = (long)value;
+  }
+
+  for(int k=0;k<NTT_PRIMES_COUNT;++k) {
+    free(residues[k]);
+  }
+  return true;
+}
+
+#else
+
+/*
+* NTT is not available (see ntt.h)
+*/
+bool NTTMultiply(const long* a, int na, const long* b, int nb, long* result) {
+  (void)a;
+  (void)na;
+  (void)b;
+  (void)nb;
+  (void)result;
+  return false;
+}
+
+#endif /* NTT_SUPPORTED */
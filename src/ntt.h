@@ -0,0 +1,70 @@
+/** @file
+*  Multiplication of integer polynomials using
+*  number theoretic transform (NTT).
+*
+*  The transforms are computed modulo three primes
+*  and the results are combined using chinese remainder theorem.
+*  The product is exact modulo 2^64, so it's the same as
+*  computed by the naive algorithm in wrapping arithmetic.
+*
+*  Usage:
+*  @code
+*     #include <ntt.h>
+*      ...
+*     long a[] = { 1, 2 };    // 1 + 2x
+*     long b[] = { 3, 0, 1 }; // 3 + x^2
+*     long r[4];
+*
+*     if(NTTMultiply(a, 2, b, 3, r)) {
+*       // r = { 3, 6, 1, 2 } // 3 + 6x + x^2 + 2x^3
+*     }
+*  @endcode
+*
+*  @author Piotr Styczyński <piotrsty1@gmail.com>
+*  @copyright MIT
+*  @date 2017-05-13
+*/
+#include "utils.h"
+#include <stdbool.h>
+
+#ifndef __STY_COMMON_NTT_H__
+#define __STY_COMMON_NTT_H__
+
+/**
+* @def NTT_SUPPORTED
+*
+* Is NTT multiplication available on this platform?
+* (the implementation requires 128-bit integers)
+*/
+#if defined(__SIZEOF_INT128__)
+#define NTT_SUPPORTED 1
+#else
+#define NTT_SUPPORTED 0
+#endif
+
+/**
+* @def NTT_MAX_LENGTH_LOG
+*
+* Binary logarithm of the maximum transform length.
+*/
+#define NTT_MAX_LENGTH_LOG 30
+
+/**
+* Multiply two integer polynomials.
+* The polynomials are given as arrays of coefficients, where
+* i-th element is coefficient of x^i.
+* The result array must have at least `na + nb - 1` elements.
+*
+* Returns false (and does not modify @p result) if NTT is not supported
+* or the product is too long.
+*
+* @param[in]  a      : coefficients of the first polynomial
+* @param[in]  na     : number of coefficients of the first polynomial
+* @param[in]  b      : coefficients of the second polynomial
+* @param[in]  nb     : number of coefficients of the second polynomial
+* @param[out] result : coefficients of the product
+* @return was the product computed?
+*/
+bool NTTMultiply(const long* a, int na, const long* b, int nb, long* result);
+
+#endif /* __STY_COMMON_NTT_H__ */
@@ -0,0 +1,121 @@
+/*
+*  Buffered writing of output.
+*
+*  @author Piotr Styczyński <piotrsty1@gmail.com>
+*  @copyright MIT
+*  @date 2017-05-13
+*/
+#define _POSIX_C_SOURCE 200809L
+#include "utils.h"
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include "memalloc.h"
+#include "output_buffer.h"
+
+/*
+* Create output buffer writing to file descriptor in blocks
+*/
+OutputBuffer OutputBufferToFd(int fd, size_t block_size) {
+  assert(block_size > 0);
+  return (OutputBuffer) {
+    .block = MALLOCATE_ARRAY(char, block_size),
+    .size = 0,
+    .block_size = block_size,
+    .fd = fd,
+    .owns_fd = false,
+    .line_flush = (isatty(fd) == 1),
+    .failed = false
+  };
+}
+
+/*
+* Create (or truncate) file and open it as output buffer
+*/
+bool OutputBufferOpen(OutputBuffer* buffer, const char* path, size_t block_size) {
+  const int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if(fd < 0) return false;
+  *buffer = OutputBufferToFd(fd, block_size);
+  buffer->owns_fd = true;
+  return true;
+}
+
+/*
+* Write all characters to the descriptor
+* (output is dropped if the descriptor cannot be written)
+*/
+static void OutputBufferWriteFd(OutputBuffer* buffer, const char* str, size_t length) {
+  while(length > 0) {
+    const ssize_t count = write(buffer->fd, str, length);
+    if(count < 0 && errno == EINTR) continue;
+    if(count <= 0) {
+      buffer->failed = true;
+      return;
+    }
+    str += count;
+    length -= (size_t) count;
+  }
+}
+
+/*
+* Write collected bytes to the descriptor
+*/
+void OutputBufferFlush(OutputBuffer* buffer) {
+  if(buffer->size == 0) return;
+  OutputBufferWriteFd(buffer, buffer->block, buffer->size);
+  buffer->size = 0;
+}
+
+/*
+* Write characters not fitting in the block
+*/
+void OutputBufferWriteLarge(OutputBuffer* buffer, const char* str, size_t length) {
+  OutputBufferFlush(buffer);
+  if(length > buffer->block_size) {
+    OutputBufferWriteFd(buffer, str, length);
+    return;
+  }
+  memcpy(buffer->block, str, length);
+  buffer->size = length;
+}
+
+/*
+* Write integer in decimal (digits are generated from the last one)
+*/
+void OutputBufferWriteLong(OutputBuffer* buffer, long value) {
+  char digits[24];
+  char* begin = digits + sizeof(digits);
+  unsigned long magnitude = (value < 0) ? -(unsigned long) value : (unsigned long) value;
+  do {
+    *(--begin) = (char) ('0' + magnitude % 10);
+    magnitude /= 10;
+  } while(magnitude > 0);
+  if(value < 0) {
+    *(--begin) = '-';
+  }
+  OutputBufferWrite(buffer, begin, (size_t) (digits + sizeof(digits) - begin));
+}
+
+/*
+* Write collected bytes and free output buffer
+*/
+bool OutputBufferDestroy(OutputBuffer* buffer) {
+  OutputBufferFlush(buffer);
+  bool written = !buffer->failed;
+  if(buffer->owns_fd && close(buffer->fd) != 0) {
+    written = false;
+  }
+  free(buffer->block);
+  *buffer = (OutputBuffer) {
+    .block = NULL,
+    .size = 0,
+    .block_size = 0,
+    .fd = -1,
+    .owns_fd = false,
+    .line_flush = false,
+    .failed = false
+  };
+  return written;
+}
@@ -0,0 +1,152 @@
+/** @file
+*  Buffered writing of output.
+*
+*  Output is collected in large block of memory and written
+*  to the file descriptor at once, so writing single character
+*  or number costs no library call (nor format parsing).
+*  The block is written when it's full, at the end of line
+*  if the descriptor is a terminal and when the buffer is destroyed.
+*
+*  Usage:
+*  @code
+*     #include <output_buffer.h>
+*      ...
+*     OutputBuffer output = OutputBufferToFd(1, OUTPUT_BUFFER_BLOCK_SIZE); // stdout
+*     OutputBufferWrite(&output, "DEG ", 4);
+*     OutputBufferWriteLong(&output, 42);
+*     OutputBufferEndLine(&output);
+*     OutputBufferDestroy(&output);
+*  @endcode
+*
+*  @author Piotr Styczyński <piotrsty1@gmail.com>
+*  @copyright MIT
+*  @date 2017-05-13
+*/
+#include "utils.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#ifndef __STY_COMMON_OUTPUT_BUFFER_H__
+#define __STY_COMMON_OUTPUT_BUFFER_H__
+
+/**
+* @def OUTPUT_BUFFER_BLOCK_SIZE
+*
+* Default size of block of output written at once (in bytes)
+*/
+#ifndef OUTPUT_BUFFER_BLOCK_SIZE
+#define OUTPUT_BUFFER_BLOCK_SIZE (1 << 16)
+#endif
+
+/**
+* Buffered output.
+*/
+typedef struct OutputBuffer {
+  char* block; ///< Collected bytes
+  size_t size; ///< Number of collected bytes
+  size_t block_size; ///< Size of the block
+  int fd; ///< Descriptor the output is written to
+  bool owns_fd; ///< Is the descriptor closed with the buffer
+  bool line_flush; ///< Is the block written at the end of every line
+  bool failed; ///< Was any output dropped (the descriptor could not be written)
+} OutputBuffer;
+
+/**
+* Create output buffer writing to file descriptor in blocks.
+* Output of terminals is written at the end of every line.
+* The descriptor is not closed with the buffer.
+*
+* @param[in] fd         : File descriptor
+* @param[in] block_size : Size of block written at once
+* @return output buffer
+*/
+OutputBuffer OutputBufferToFd(int fd, size_t block_size);
+
+/**
+* Create (or truncate) file and open it as output buffer.
+*
+* @param[out] buffer     : Created output buffer
+* @param[in]  path       : Path of file
+* @param[in]  block_size : Size of block written at once
+* @return was the file opened?
+*/
+bool OutputBufferOpen(OutputBuffer* buffer, const char* path, size_t block_size);
+
+/**
+* Write collected bytes to the descriptor.
+*
+* @param[in] buffer : Output buffer
+*/
+void OutputBufferFlush(OutputBuffer* buffer);
+
+/**
+* Write characters not fitting in the block.
+* Used by OutputBufferWrite when the block is full.
+*
+* @param[in] buffer : Output buffer
+* @param[in] str    : Characters
+* @param[in] length : Number of characters
+*/
+void OutputBufferWriteLarge(OutputBuffer* buffer, const char* str, size_t length);
+
+/**
+* Write characters.
+*
+* @param[in] buffer : Output buffer
+* @param[in] str    : Characters (not necessarily null-terminated)
+* @param[in] length : Number of characters
+*/
+static inline void OutputBufferWrite(OutputBuffer* buffer, const char* str, size_t length) {
+  if(buffer->size + length <= buffer->block_size) {
+    memcpy(buffer->block + buffer->size, str, length);
+    buffer->size += length;
+    return;
+  }
+  OutputBufferWriteLarge(buffer, str, length);
+}
+
+/**
+* Write single character.
+*
+* @param[in] buffer : Output buffer
+* @param[in] c      : Character
+*/
+static inline void OutputBufferPut(OutputBuffer* buffer, char c) {
+  if(buffer->size == buffer->block_size) {
+    OutputBufferFlush(buffer);
+  }
+  buffer->block[buffer->size++] = c;
+}
+
+/**
+* Write integer in decimal.
+*
+* @param[in] buffer : Output buffer
+* @param[in] value  : Integer
+*/
+void OutputBufferWriteLong(OutputBuffer* buffer, long value);
+
+/**
+* Write the end of line
+* (and the collected bytes if the buffer writes whole lines).
+*
+* @param[in] buffer : Output buffer
+*/
+static inline void OutputBufferEndLine(OutputBuffer* buffer) {
+  OutputBufferPut(buffer, '\n');
+  if(buffer->line_flush) {
+    OutputBufferFlush(buffer);
+  }
+}
+
+/**
+* Write collected bytes and free output buffer
+* (and close its file if it was opened by buffer).
+*
+* @param[in] buffer : Output buffer
+* @return was all the output written?
+*/
+bool OutputBufferDestroy(OutputBuffer* buffer);
+
+#endif /* __STY_COMMON_OUTPUT_BUFFER_H__ */
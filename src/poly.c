@@ -9,10 +9,12 @@
 #include <assert.h>
 #include <stdio.h>
 #include "memalloc.h"
-#include "dynamic_lists.h"
+#include <string.h>
+#include <stddef.h>
+#include <stdatomic.h>
 #include "generics.h"
 #include "poly.h"
-#include "math_utils.h"
+#include "ntt.h"
 
 /*
 * Creates monomial from given exponent and coefficient
@@ -21,176 +23,548 @@ static inline Mono MonoFromCoeff(poly_coeff_t c, poly_exp_t e) {
     return (Mono) { .exp = e, .p = PolyFromCoeff(c) };
 }
 
+/*
+* Header placed in front of every heap allocated monomials array.
+* The arrays are shared by clones of the polynomial (copy-on-write)
+* and freed when the last polynomial referencing them is destroyed.
+* The counter is atomic, so copies may be used by different threads.
+*/
+typedef union PolyMonosHeader {
+  atomic_long refs; ///< Number of polynomials referencing the array
+  max_align_t align; ///< Keeps monomials following the header aligned
+} PolyMonosHeader;
+
+/*
+* Gets header of heap allocated monomials array
+*/
+static inline PolyMonosHeader* PolyMonosHeaderOf(const Poly* p) {
+  return ((PolyMonosHeader*) p->monos) - 1;
+}
+
+/*
+* Allocates monomials array (with the reference count set to 1)
+*/
+static inline Mono* PolyMonosAllocate(int capacity) {
+  PolyMonosHeader* header = MALLOCATE_BLOCKS(sizeof(PolyMonosHeader) + capacity * sizeof(Mono), 1);
+  atomic_init(&(header->refs), 1);
+  return (Mono*) (header + 1);
+}
+
+/*
+* Checks if polynomial monomials array is not owned by it
+* (is allocated in arena)
+*/
+static inline bool PolyMonosBorrowed(const Poly* p) {
+  return p->alloc_size == 0 && p->size > 0;
+}
+
+/*
+* Checks if polynomial monomials array is referenced
+* also by other polynomials
+*/
+static inline bool PolyMonosShared(const Poly* p) {
+  return p->alloc_size > 0
+    && atomic_load_explicit(&(PolyMonosHeaderOf(p)->refs), memory_order_acquire) > 1;
+}
+
+/*
+* Resizes capacity of polynomial monomials array to at least @p min_size
+* (the array grows by factor of 2 to amortize reallocations)
+* Borrowed and shared arrays are copied to the new heap array.
+*/
+static inline void PolyMonosReserve(Poly* p, int min_size) {
+  const bool borrowed = PolyMonosBorrowed(p);
+  const bool shared = PolyMonosShared(p);
+  if(p->alloc_size >= min_size && !shared) return;
+  int new_size = p->alloc_size;
+  if(new_size < min_size) {
+    new_size = p->alloc_size * 2;
+    if(new_size < min_size) new_size = min_size;
+    if(new_size < 2) new_size = 2;
+  }
+  if(borrowed || shared) {
+    Mono* monos = PolyMonosAllocate(new_size);
+    if(shared) {
+      // Other owners keep the old array, so the monomials are cloned
+      // (the old array is destroyed if they released it in the meantime)
+      for(int i=0;i<p->size;++i) {
+        monos[i] = MonoClone(&(p->monos[i]));
+      }
+      // (the constant term stays in the polynomial)
+      Poly old = *p;
+      old.c = 0;
+      PolyDestroy(&old);
+    } else {
+      memcpy(monos, p->monos, p->size * sizeof(Mono));
+    }
+    p->monos = monos;
+  } else if(p->monos == NULL) {
+    p->monos = PolyMonosAllocate(new_size);
+  } else {
+    PolyMonosHeader* header = ReallocateMemoryBlockArray(PolyMonosHeaderOf(p), 1,
+      sizeof(PolyMonosHeader) + new_size * sizeof(Mono));
+    p->monos = (Mono*) (header + 1);
+  }
+  p->alloc_size = new_size;
+}
+
+/*
+* Makes sure the monomials array is owned only by the polynomial
+* so its elements can be modified in place.
+*/
+static inline void PolyMonosMakeOwned(Poly* p) {
+  if(PolyMonosBorrowed(p) || PolyMonosShared(p)) {
+    PolyMonosReserve(p, p->size);
+  }
+}
+
+/*
+* Releases monomials array (not the monomials themselves)
+* and makes the polynomial constant.
+* Shared array is only dereferenced.
+*/
+static inline void PolyMonosFree(Poly* p) {
+  if(p->alloc_size > 0) {
+    PolyMonosHeader* header = PolyMonosHeaderOf(p);
+    if(atomic_fetch_sub_explicit(&(header->refs), 1, memory_order_acq_rel) == 1) {
+      free(header);
+    }
+  }
+  p->monos = NULL;
+  p->size = 0;
+  p->alloc_size = 0;
+}
+
+/*
+* Appends monomial at the end of monomials array.
+* The monomial must have the highest exponent of all of them.
+*/
+static inline void PolyPushMono(Poly* p, Mono m) {
+  assert(p->size == 0 || p->monos[p->size-1].exp < m.exp);
+  PolyMonosReserve(p, p->size + 1);
+  p->monos[p->size++] = m;
+}
+
+/*
+* Finds index of the first monomial with exponent not lower than @p exp
+* (binary search over monomials array)
+*/
+static inline int PolyFindMonoPosition(const Poly* p, poly_exp_t exp) {
+  int lo = 0;
+  int hi = p->size;
+  while(lo < hi) {
+    const int mid = lo + (hi - lo) / 2;
+    if(p->monos[mid].exp < exp) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
 /*
 * Deallocated memory taken by polynomial
+* (the monomials are destroyed by the last owner of the array)
 */
 void PolyDestroy(Poly *p) {
   if(p==NULL) return;
-  LOOP_LIST(&(p->monos), i) {
-    Mono* m = (Mono*) ListGetValue(i);
-    MonoDestroy(m);
+  PolyCoeffDestroy(p->c);
+  p->c = 0;
+  // Arena arrays (with the whole subtree) are never freed
+  if(p->alloc_size > 0) {
+    PolyMonosHeader* header = PolyMonosHeaderOf(p);
+    if(atomic_fetch_sub_explicit(&(header->refs), 1, memory_order_acq_rel) == 1) {
+      LOOP_POLY(p, m) {
+        MonoDestroy(m);
+      }
+      free(header);
+    }
+  }
+  p->monos = NULL;
+  p->size = 0;
+  p->alloc_size = 0;
+}
+
+/*
+* Copies polynomial.
+* Heap arrays are shared with the copy (O(1)), arena arrays are deep-copied.
+*/
+Poly PolyClone(const Poly *p) {
+  assert(p!=NULL);
+  if(p->size > 0 && !PolyMonosBorrowed(p)) {
+    atomic_fetch_add_explicit(&(PolyMonosHeaderOf(p)->refs), 1, memory_order_relaxed);
+    Poly result = *p;
+    result.c = PolyCoeffClone(p->c);
+    return result;
   }
-  LOOP_LIST(&(p->monos), i) {
-    Mono* m = (Mono*) ListGetValue(i);
-    free(m);
+  Poly result = PolyFromCoeff(PolyCoeffClone(p->c));
+  if(p->size > 0) {
+    PolyMonosReserve(&result, p->size);
+    LOOP_POLY(p, m) {
+      result.monos[result.size++] = MonoClone(m);
+    }
   }
-  ListDestroy(&(p->monos));
+  return result;
 }
 
+/*
+* Counts monomials on all nesting levels of polynomial
+*/
+static size_t PolyCountMonosRec(const Poly *p) {
+  size_t count = p->size;
+  LOOP_POLY(p, m) {
+    count += PolyCountMonosRec(&(m->p));
+  }
+  return count;
+}
 
 /*
-* Helper function for deep-copying list of monomials
-* Deep-copies given monomial pointed by ListData pointer.
-* Then returns pointer to the newly copied monomial.
+* Deep-copies polynomial into preallocated block of monomials
+* moving the @p cursor past the used part of the block
+* (big coefficients are copied to the arena)
 */
-static inline ListData polyCopier(ListData data) {
-  Mono* mono = (Mono*) data;
-  Mono* mono_new = MALLOCATE(Mono);
-  *mono_new = MonoClone(mono);
-  return (ListData) mono_new;
+static Poly PolyCloneToBlock(const Poly *p, Mono** cursor, MemArena* arena) {
+  Poly result = PolyFromCoeff(PolyCoeffCloneToArena(p->c, arena));
+  if(p->size == 0) return result;
+  result.monos = *cursor;
+  result.size = p->size;
+  result.alloc_size = 0;
+  *cursor += p->size;
+  for(int i=0;i<p->size;++i) {
+    const Mono* m = &(p->monos[i]);
+    result.monos[i] = (Mono) { .exp = m->exp, .p = PolyCloneToBlock(&(m->p), cursor, arena) };
+  }
+  return result;
 }
 
 /*
-* Deep-copies polynomial
+* Deep-copies polynomial into the arena
 */
-Poly PolyClone(const Poly *p) {
+Poly PolyCloneToArena(const Poly *p, MemArena* arena) {
   assert(p!=NULL);
-  return (Poly) { .c = p->c, .monos = ListDeepCopy(&(p->monos), polyCopier) };
+  assert(arena!=NULL);
+  const size_t count = PolyCountMonosRec(p);
+  if(count == 0) return PolyFromCoeff(PolyCoeffCloneToArena(p->c, arena));
+  Mono* block = ARENA_MALLOCATE_ARRAY(arena, Mono, count);
+  return PolyCloneToBlock(p, &block, arena);
+}
+
+/*
+* Hash of single level of polynomial (the constant term is not included).
+* Sub-polynomials must be interned, so they are identified by their arrays.
+* Equal large coefficients may be stored separately, so only their size is hashed.
+*/
+static inline size_t PolyInternHash(const Poly* p) {
+  uint64_t h = (uint64_t) p->size;
+  LOOP_POLY(p, m) {
+    h = (h ^ (uint64_t) m->exp) * 0x100000001B3ULL;
+    const poly_coeff_t c = PolyCoeffIsSmall(m->p.c) ? m->p.c : PolyCoeffBits(m->p.c);
+    h = (h ^ (uint64_t) c) * 0x100000001B3ULL;
+    h = (h ^ (uint64_t) (uintptr_t) m->p.monos) * 0x100000001B3ULL;
+  }
+  return (size_t) (h ^ (h >> 29));
+}
+
+/*
+* Compares single levels of polynomials with interned sub-polynomials
+*/
+static inline bool PolyInternLevelIsEq(const Poly* p, const Poly* q) {
+  if(p->size != q->size) return false;
+  for(int i=0;i<p->size;++i) {
+    const Mono* mp = &(p->monos[i]);
+    const Mono* mq = &(q->monos[i]);
+    if(mp->exp != mq->exp || !PolyCoeffIsEq(mp->p.c, mq->p.c)
+      || mp->p.monos != mq->p.monos || mp->p.size != mq->p.size) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+* Finds slot of the table entry equal to the level of @p p
+* (or the empty slot where it should be inserted)
+*/
+static inline PolyInternEntry* PolyInternFind(PolyInternTable* table, const Poly* p, size_t hash) {
+  const size_t mask = (size_t) table->alloc_size - 1;
+  for(size_t i = hash & mask;;i = (i + 1) & mask) {
+    PolyInternEntry* entry = &(table->entries[i]);
+    if(entry->level.size == 0) return entry;
+    if(entry->hash == hash && PolyInternLevelIsEq(&(entry->level), p)) return entry;
+  }
+}
+
+/*
+* Doubles capacity of the hash-consing table
+*/
+static void PolyInternTableGrow(PolyInternTable* table) {
+  PolyInternTable grown = {
+    .entries = MALLOCATE_ARRAY(PolyInternEntry, table->alloc_size * 2),
+    .size = table->size,
+    .alloc_size = table->alloc_size * 2
+  };
+  for(int i=0;i<table->alloc_size;++i) {
+    const PolyInternEntry* entry = &(table->entries[i]);
+    if(entry->level.size > 0) {
+      *PolyInternFind(&grown, &(entry->level), entry->hash) = *entry;
+    }
+  }
+  free(table->entries);
+  *table = grown;
 }
 
+/*
+* Creates empty hash-consing table
+*/
+PolyInternTable PolyInternTableNew(void) {
+  return (PolyInternTable) {
+    .entries = MALLOCATE_ARRAY(PolyInternEntry, POLY_INTERN_TABLE_INITIAL_SIZE),
+    .size = 0,
+    .alloc_size = POLY_INTERN_TABLE_INITIAL_SIZE
+  };
+}
+
+/*
+* Destroys hash-consing table releasing its references
+*/
+void PolyInternTableDestroy(PolyInternTable* table) {
+  assert(table!=NULL);
+  for(int i=0;i<table->alloc_size;++i) {
+    PolyDestroy(&(table->entries[i].level));
+  }
+  free(table->entries);
+  *table = (PolyInternTable) { .entries = NULL, .size = 0, .alloc_size = 0 };
+}
 
 /*
-* Deep-copies monomial and then allocates memory for it
-* and returns pointer to that memory.
+* Replaces all the levels of polynomial with the shared ones from the table
 */
-Mono* MonoClonePtr(const Mono *m) {
-  Mono* mono = MALLOCATE(Mono);
-  *mono = MonoClone(m);
-  return mono;
+static void PolyInternRec(Poly* p, PolyInternTable* table) {
+  // Arena arrays cannot outlive the arena, so they are never shared
+  if(p->size == 0 || PolyMonosBorrowed(p)) return;
+
+  // Interned level has all of its sub-polynomials interned
+  const PolyInternEntry* found = PolyInternFind(table, p, PolyInternHash(p));
+  if(found->level.monos == p->monos) return;
+
+  PolyMonosMakeOwned(p);
+  LOOP_POLY(p, m) {
+    PolyInternRec(&(m->p), table);
+  }
+
+  const size_t hash = PolyInternHash(p);
+  PolyInternEntry* entry = PolyInternFind(table, p, hash);
+  if(entry->level.size > 0) {
+    Poly shared = PolyClone(&(entry->level));
+    shared.c = p->c;
+    p->c = 0;
+    PolyReplace(p, shared);
+    return;
+  }
+  entry->level = PolyClone(p);
+  PolyCoeffReplace(&(entry->level.c), 0);
+  entry->hash = hash;
+  if(2 * (++(table->size)) > table->alloc_size) {
+    PolyInternTableGrow(table);
+  }
 }
 
+/*
+* Hash-conses polynomial (see poly.h)
+*/
+void PolyIntern(Poly* p, PolyInternTable* table) {
+  assert(p!=NULL);
+  assert(table!=NULL);
+  PolyInternRec(p, table);
+}
 
 /*
 * Multiplies all coefficients in polynomial by const factor c
 */
-void PolyScaleConst(Poly *p, const poly_coeff_t c) {
+void PolyScaleConst(Poly *p, poly_coeff_t c) {
   assert(p!=NULL);
+  c = PolyCoeffReduce(c);
   if(c == 1) return;
-  (p->c) *= c;
-  LOOP_LIST(&(p->monos), iter) {
-    Mono* m = (Mono*) ListGetValue(iter);
+  if(c == 0) {
+    PolyDestroy(p);
+    p->c = 0;
+    return;
+  }
+  PolyCoeffReplace(&(p->c), PolyCoeffMul(p->c, c));
+  // Coefficients may be reduced to zero, so zero monomials are removed
+  PolyMonosMakeOwned(p);
+  int size = 0;
+  LOOP_POLY(p, m) {
     PolyScaleConst(&(m->p), c);
+    if(PolyIsZero(&(m->p))) {
+      MonoDestroy(m);
+    } else {
+      p->monos[size++] = *m;
+    }
+  }
+  p->size = size;
+  if(p->size == 0) {
+    PolyMonosFree(p);
   }
 }
 
-Poly PolyAddScaled(const Poly *p, const Poly *q, const poly_coeff_t c);
-
 /*
-* Adding two polynomials with optional scaling of second parameter
+* Adds polynomial @p q to @p p taking ownership of all @p q data.
+* After the call @p q is a zero polynomial.
 */
-void PolyAddScaledInPlace(Poly *p, const Poly *q, const poly_coeff_t c) {
+void PolyAddTakeInPlace(Poly *p, Poly *q) {
   assert(p!=NULL);
   assert(q!=NULL);
-  List result = ListNew();
-
-  ListIterator iq = ListBegin(&(q->monos));
-  ListIterator ip = ListBegin(&(p->monos));
-  while(ip != NULL || iq != NULL) {
-    Mono* mp = (Mono*) ListGetValue(ip);
-    Mono* mq = (Mono*) ListGetValue(iq);
-    if(mp == NULL) {
-      Mono* new_mono = MonoClonePtr(mq);
-      PolyScaleConst(&(new_mono->p), c);
-      ListPushBack(&result, new_mono);
-      iq = ListNext(iq);
-    } else if(mq == NULL) {
-      //Skip clone
-      Mono* new_mono = mp;
-      ListPushBack(&result, new_mono);
-      ip = ListNext(ip);
-    } else if(mp->exp > mq->exp) {
-      Mono* new_mono = MonoClonePtr(mq);
-      PolyScaleConst(&(new_mono->p), c);
-      ListPushBack(&result, new_mono);
-      iq = ListNext(iq);
-    } else if(mp->exp < mq->exp) {
-      //Skip clone
-      Mono* new_mono = mp;
-      ListPushBack(&result, new_mono);
-      ip = ListNext(ip);
-    } else {
-      PolyAddScaledInPlace(&(mp->p), &(mq->p), c);
+  assert(p!=q);
+  PolyCoeffReplace(&(p->c), PolyCoeffAdd(p->c, q->c));
+  PolyCoeffReplace(&(q->c), 0);
+  if(q->size == 0) return;
+  if(p->size == 0) {
+    PolyMonosFree(p);
+    *p = (Poly) { .c = p->c, .monos = q->monos, .size = q->size, .alloc_size = q->alloc_size };
+    *q = PolyZero();
+    return;
+  }
 
-      if(PolyIsCoeff(&(mp->p)) && PolyGetConstTerm(&(mp->p)) == 0) {
-        MonoDestroy(mp);
-        free(mp);
+  // Monomials are moved, so the arrays must not be shared
+  PolyMonosMakeOwned(p);
+  PolyMonosMakeOwned(q);
+  Poly result = PolyFromCoeff(p->c);
+  PolyMonosReserve(&result, p->size + q->size);
+
+  int ip = 0;
+  int iq = 0;
+  while(ip < p->size || iq < q->size) {
+    if(iq >= q->size || (ip < p->size && p->monos[ip].exp < q->monos[iq].exp)) {
+      result.monos[result.size++] = p->monos[ip++];
+    } else if(ip >= p->size || p->monos[ip].exp > q->monos[iq].exp) {
+      result.monos[result.size++] = q->monos[iq++];
+    } else {
+      Mono m = p->monos[ip++];
+      PolyAddTakeInPlace(&(m.p), &(q->monos[iq++].p));
+      if(PolyIsZero(&(m.p))) {
+        MonoDestroy(&m);
       } else {
-        ListPushBack(&result, mp);
+        result.monos[result.size++] = m;
       }
+    }
+  }
+
+  PolyMonosFree(p);
+  PolyMonosFree(q);
+  if(result.size == 0) {
+    PolyMonosFree(&result);
+  }
+  *p = result;
+}
+
+Poly PolyAddScaled(const Poly *p, const Poly *q, poly_coeff_t c);
+
+/*
+* Adding two polynomials with optional scaling of second parameter
+*/
+void PolyAddScaledInPlace(Poly *p, const Poly *q, poly_coeff_t c) {
+  assert(p!=NULL);
+  assert(q!=NULL);
+  c = PolyCoeffReduce(c);
+  if(c == 0) return;
+  if(p == q) {
+    const poly_coeff_t scale = PolyCoeffAdd(c, 1);
+    PolyScaleConst(p, scale);
+    PolyCoeffDestroy(scale);
+    return;
+  }
 
-      /*PolyAddScaledInPlace(&(mp->p), &(mq->p), c);
+  PolyMonosMakeOwned(p);
+  const poly_coeff_t product = PolyCoeffMul(q->c, c);
+  Poly result = PolyFromCoeff(PolyCoeffAdd(p->c, product));
+  PolyCoeffDestroy(product);
+  PolyCoeffDestroy(p->c);
+  if(p->size + q->size > 0) {
+    PolyMonosReserve(&result, p->size + q->size);
+  }
 
-      if(PolyIsCoeff(&(mp->p)) && PolyGetConstTerm(&(mp->p)) == 0) {
-        PolyDestroy(&(mp->p));
+  int ip = 0;
+  int iq = 0;
+  while(ip < p->size || iq < q->size) {
+    if(iq >= q->size || (ip < p->size && p->monos[ip].exp < q->monos[iq].exp)) {
+      //Skip clone
+      result.monos[result.size++] = p->monos[ip++];
+    } else if(ip >= p->size || p->monos[ip].exp > q->monos[iq].exp) {
+      Mono new_mono = MonoClone(&(q->monos[iq++]));
+      PolyScaleConst(&(new_mono.p), c);
+      // Scaled coefficient may be reduced to zero
+      if(PolyIsZero(&(new_mono.p))) {
+        MonoDestroy(&new_mono);
+      } else {
+        result.monos[result.size++] = new_mono;
+      }
+    } else {
+      Mono m = p->monos[ip++];
+      PolyAddScaledInPlace(&(m.p), &(q->monos[iq++].p), c);
+      if(PolyIsZero(&(m.p))) {
+        MonoDestroy(&m);
       } else {
-        Mono* partial_result = MALLOCATE(Mono);
-        *partial_result = (Mono) { .exp = mp->exp, .p = mp->p };
-        ListPushBack(&result, partial_result);
-      }*/
-      ip = ListNext(ip);
-      iq = ListNext(iq);
+        result.monos[result.size++] = m;
+      }
     }
   }
-  ListDestroy(&(p->monos));
-  *p = (Poly) { .c = p->c + (q->c)*c, .monos = result };
+
+  PolyMonosFree(p);
+  if(result.size == 0) {
+    PolyMonosFree(&result);
+  }
+  *p = result;
 }
 
 /*
 * Adding two polynomials with optional scaling of second parameter
 */
-Poly PolyAddScaled(const Poly *p, const Poly *q, const poly_coeff_t c) {
+Poly PolyAddScaled(const Poly *p, const Poly *q, poly_coeff_t c) {
   assert(p!=NULL);
   assert(q!=NULL);
-  List result = ListNew();
-
-  ListIterator iq = ListBegin(&(q->monos));
-  ListIterator ip = ListBegin(&(p->monos));
-  while(ip != NULL || iq != NULL) {
-    Mono* mp = (Mono*) ListGetValue(ip);
-    Mono* mq = (Mono*) ListGetValue(iq);
-    if(mp == NULL) {
-      Mono* new_mono = MonoClonePtr(mq);
-      PolyScaleConst(&(new_mono->p), c);
-      ListPushBack(&result, new_mono);
-      iq = ListNext(iq);
-    } else if(mq == NULL) {
-      Mono* new_mono = MonoClonePtr(mp);
-      ListPushBack(&result, new_mono);
-      ip = ListNext(ip);
-    } else if(mp->exp > mq->exp) {
-      Mono* new_mono = MonoClonePtr(mq);
-      PolyScaleConst(&(new_mono->p), c);
-      ListPushBack(&result, new_mono);
-      iq = ListNext(iq);
-    } else if(mp->exp < mq->exp) {
-      Mono* new_mono = MonoClonePtr(mp);
-      ListPushBack(&result, new_mono);
-      ip = ListNext(ip);
+  c = PolyCoeffReduce(c);
+  if(c == 0) return PolyClone(p);
+
+  const poly_coeff_t product = PolyCoeffMul(q->c, c);
+  Poly result = PolyFromCoeff(PolyCoeffAdd(p->c, product));
+  PolyCoeffDestroy(product);
+  if(p->size + q->size > 0) {
+    PolyMonosReserve(&result, p->size + q->size);
+  }
+
+  int ip = 0;
+  int iq = 0;
+  while(ip < p->size || iq < q->size) {
+    if(iq >= q->size || (ip < p->size && p->monos[ip].exp < q->monos[iq].exp)) {
+      result.monos[result.size++] = MonoClone(&(p->monos[ip++]));
+    } else if(ip >= p->size || p->monos[ip].exp > q->monos[iq].exp) {
+      Mono new_mono = MonoClone(&(q->monos[iq++]));
+      PolyScaleConst(&(new_mono.p), c);
+      // Scaled coefficient may be reduced to zero
+      if(PolyIsZero(&(new_mono.p))) {
+        MonoDestroy(&new_mono);
+      } else {
+        result.monos[result.size++] = new_mono;
+      }
     } else {
+      const Mono* mp = &(p->monos[ip++]);
+      const Mono* mq = &(q->monos[iq++]);
       Poly polyAddResult = PolyAddScaled(&(mp->p), &(mq->p), c);
 
-      if(PolyIsCoeff(&polyAddResult) && PolyGetConstTerm(&polyAddResult) == 0) {
+      if(PolyIsZero(&polyAddResult)) {
         PolyDestroy(&polyAddResult);
       } else {
-        Mono* partial_result = MALLOCATE(Mono);
-        *partial_result = (Mono) { .exp = mp->exp, .p = polyAddResult };
-        ListPushBack(&result, partial_result);
+        result.monos[result.size++] = MonoFromPoly(&polyAddResult, mp->exp);
       }
-      ip = ListNext(ip);
-      iq = ListNext(iq);
     }
   }
-  return (Poly) { .c = p->c + (q->c)*c, .monos = result };
+
+  if(result.size == 0) {
+    PolyMonosFree(&result);
+  }
+  return result;
 }
 
 /*
@@ -200,24 +574,43 @@ Poly PolyAdd(const Poly *p, const Poly *q) {
   return PolyAddScaled(p, q, 1);
 }
 
+/*
+* Adding polynomial to another one in place
+*/
+void PolyAddInPlace(Poly *p, const Poly *q) {
+  PolyAddScaledInPlace(p, q, 1);
+}
+
+/*
+* Adding product of polynomials to another one in place
+*/
+void PolyMulAddInPlace(Poly *p, const Poly *q, const Poly *r) {
+  assert(p!=NULL);
+  assert(q!=NULL);
+  assert(r!=NULL);
+  if(PolyIsCoeff(q)) {
+    PolyAddScaledInPlace(p, r, q->c);
+  } else if(PolyIsCoeff(r)) {
+    PolyAddScaledInPlace(p, q, r->c);
+  } else {
+    Poly product = PolyMul(q, r);
+    PolyAddTakeInPlace(p, &product);
+  }
+}
+
 /*
 * Getting const term of polynomial with setting all unnormalized
 * terms c*x^0 to 0.
 */
-int PolyExtractConstTermsRec(Poly* p) {
-  if(ListEmpty(&(p->monos))) {
-    const int result = p->c;
-    p->c = 0;
-    return result;
-  }
-  Mono* fst = (Mono*) ListFirst(&(p->monos));
-  if(fst->exp == 0) {
-    const int result = p->c;
-    p->c = 0;
-    return result + PolyExtractConstTermsRec(&(fst->p));
-  }
-  const int result = p->c;
+poly_coeff_t PolyExtractConstTermsRec(Poly* p) {
+  poly_coeff_t result = p->c;
   p->c = 0;
+  if(p->size > 0 && p->monos[0].exp == 0) {
+    PolyMonosMakeOwned(p);
+    const poly_coeff_t term = PolyExtractConstTermsRec(&(p->monos[0].p));
+    PolyCoeffReplace(&result, PolyCoeffAdd(result, term));
+    PolyCoeffDestroy(term);
+  }
   return result;
 }
 
@@ -225,485 +618,2184 @@ int PolyExtractConstTermsRec(Poly* p) {
 * Normalize const terms of polynomial
 */
 void PolyNormalizeConstTerms(Poly* p) {
-  const int top_term = PolyExtractConstTermsRec(p);
+  const poly_coeff_t top_term = PolyExtractConstTermsRec(p);
   p->c = top_term;
 }
 
 /*
 * Inserts given monomial to the given polynomial performing
 * all normalizing opertions (simplifying terms etc.).
-* If the function returns true then the monomial was inserted
-* succesfully, if false then from various reasons like:
-*
-* - simplifying (the monomial coefficient was set to zero after addition)
-*      when it would not exist in resulting polynomial
-* - the coefficient of monomial is already zero so there's no reason
-*      to insert it anywhere
-*
-* the monomial is not used and SHOULD BE DESTROYED.
+* Takes ownership of the monomial - if it's not inserted
+* (it was merged with existing one or is equal to zero)
+* then its memory is freed.
 */
-static inline int PolyTryInsertMono(Poly* p, Mono* new_mono) {
+static inline void PolyInsertMonoValue(Poly* p, Mono new_mono) {
 
-  if(PolyIsCoeff(&(new_mono->p)) && PolyGetConstTerm(&(new_mono->p))==0) {
-    return 0;
+  if(PolyIsZero(&(new_mono.p))) {
+    MonoDestroy(&new_mono);
+    return;
   }
 
-
-  if(new_mono->exp == 0) {
-
-    //const poly_coeff_t term = PolyExtractConstTermsRec(&(new_mono->p));
-    p->c += new_mono->p.c;
-    new_mono->p.c = 0;
-    if(PolyIsCoeff(&(new_mono->p))) {
-      return 0;
+  if(new_mono.exp == 0) {
+    PolyCoeffReplace(&(p->c), PolyCoeffAdd(p->c, new_mono.p.c));
+    PolyCoeffReplace(&(new_mono.p.c), 0);
+    if(PolyIsCoeff(&(new_mono.p))) {
+      MonoDestroy(&new_mono);
+      return;
     }
   }
 
-  if(ListEmpty(&(p->monos))) {
-    ListPushBack(&(p->monos), new_mono);
-    return 1;
-  }
-  if(((Mono*)ListLast(&(p->monos)))->exp < new_mono->exp) {
-    ListPushBack(&(p->monos), new_mono);
-    return 1;
-  }
-  if(((Mono*)ListFirst(&(p->monos)))->exp > new_mono->exp) {
-    ListPushFront(&(p->monos), new_mono);
-    return 1;
+  const int pos = PolyFindMonoPosition(p, new_mono.exp);
+  if(pos < p->size && p->monos[pos].exp == new_mono.exp) {
+    PolyMonosMakeOwned(p);
+    Mono* m = &(p->monos[pos]);
+    PolyAddTakeInPlace(&(m->p), &(new_mono.p));
+    MonoDestroy(&new_mono);
+    if(PolyIsZero(&(m->p))) {
+      MonoDestroy(m);
+      memmove(p->monos + pos, p->monos + pos + 1, (p->size - pos - 1) * sizeof(Mono));
+      --(p->size);
+      if(p->size == 0) {
+        PolyMonosFree(p);
+      }
+    }
+    return;
   }
 
-  LOOP_LIST(&(p->monos), i) {
-    ListIterator next = ListNext(i);
-    Mono* m = (Mono*) ListGetValue(i);
-    if(m->exp == new_mono->exp) {
+  PolyMonosReserve(p, p->size + 1);
+  memmove(p->monos + pos + 1, p->monos + pos, (p->size - pos) * sizeof(Mono));
+  p->monos[pos] = new_mono;
+  ++(p->size);
+}
 
-      //printf("@");fflush(stdout);
+void PolyInsertMono(Poly* p, Mono mono) {
+  PolyInsertMonoValue(p, mono);
+}
 
+int MonoHelperSorter(const void * p1, const void * p2) {
+    Mono e1 = *((Mono*)p1);
+    Mono e2 = *((Mono*)p2);
+    if (e1.exp > e2.exp) return  1;
+    if (e1.exp < e2.exp) return -1;
+    return 0;
+}
 
+/*
+* Adds monomial to the built polynomial
+* (constant terms are summed right away, see PolyInsertMonoValue)
+*/
+void PolyBuilderAdd(PolyBuilder* builder, Mono mono) {
+  assert(builder!=NULL);
+  Poly* p = &(builder->p);
 
-      //TODO: Potential performance issue
-      /*Poly pom = PolyAdd(&(m->p), &(new_mono->p));
-      if(PolyIsCoeff(&pom) && PolyGetConstTerm(&pom)==0) {
-        ListDetachElement(&(p->monos), i);
-        PolyDestroy(&pom);
-        MonoDestroy(m);
-        free(m);
-        return 0;
-      }
-      //Here: destroy poly
-      PolyDestroy(&(m->p));
-      m->p = pom;*/
+  if(PolyIsZero(&(mono.p))) {
+    MonoDestroy(&mono);
+    return;
+  }
 
+  if(mono.exp == 0) {
+    PolyCoeffReplace(&(p->c), PolyCoeffAdd(p->c, mono.p.c));
+    PolyCoeffReplace(&(mono.p.c), 0);
+    if(PolyIsCoeff(&(mono.p))) {
+      MonoDestroy(&mono);
+      return;
+    }
+  }
 
+  if(p->size > 0 && p->monos[p->size-1].exp >= mono.exp) {
+    builder->sorted = false;
+  }
+  PolyMonosReserve(p, p->size + 1);
+  p->monos[p->size++] = mono;
+}
 
-      //printf("#"); fflush(stdout);
-      PolyAddScaledInPlace(&(m->p), &(new_mono->p), 1);
-      if(PolyIsCoeff(&(m->p)) && PolyGetConstTerm(&(m->p))==0) {
-        ListDetachElement(&(p->monos), i);
-        MonoDestroy(m);
-        free(m);
-        return 0;
-      }
+/*
+* Key of exponent used by radix sort
+* (unsigned keys are ordered as the exponents)
+*/
+static inline uint32_t PolyBuilderSortKey(poly_exp_t exp) {
+  return ((uint32_t) exp) ^ 0x80000000u;
+}
 
-      return 0;
-    } else if(new_mono->exp > m->exp) {
-      if(next == NULL) {
-        ListPushBack(&(p->monos), new_mono);
-        return 1;
-      } else if(new_mono->exp < ((Mono*)ListGetValue(next))->exp) {
-        ListInsertElementAt(&(p->monos), next, new_mono);
-        return 1;
-      }
+/*
+* Sorts monomials by exponents using insertion sort
+*/
+static void PolyBuilderInsertionSort(Mono* monos, int size) {
+  for(int i=1;i<size;++i) {
+    const Mono m = monos[i];
+    int j = i;
+    while(j > 0 && monos[j-1].exp > m.exp) {
+      monos[j] = monos[j-1];
+      --j;
     }
+    monos[j] = m;
   }
-  ListPushFront(&(p->monos), new_mono);
-  return 1;
 }
 
 /*
-* Allocates memory for monomial then tries to insert it
-* using PolyInsertMono if the function fails
-* then memory is automatically freed.
+* Sorts monomials by exponents using radix sort over bytes of exponents.
+* Bytes equal for all monomials (e.g. high bytes of small exponents)
+* are skipped.
 */
-static inline void PolyInsertMonoValue(Poly* p, Mono new_mono) {
-  Mono* new_mono_ptr = MALLOCATE(Mono);
-  *new_mono_ptr = new_mono;
-  if(!PolyTryInsertMono(p, new_mono_ptr)) {
-    MonoDestroy(new_mono_ptr);
-    free(new_mono_ptr);
+static void PolyBuilderRadixSort(Mono* monos, int size) {
+  int counts[4][256];
+  memset(counts, 0, sizeof(counts));
+  for(int i=0;i<size;++i) {
+    const uint32_t key = PolyBuilderSortKey(monos[i].exp);
+    for(int d=0;d<4;++d) {
+      ++counts[d][(key >> (8*d)) & 0xFF];
+    }
   }
 
+  Mono* buffer = MALLOCATE_ARRAY(Mono, size);
+  Mono* from = monos;
+  Mono* to = buffer;
+  for(int d=0;d<4;++d) {
+    const int shift = 8*d;
+    if(counts[d][(PolyBuilderSortKey(from[0].exp) >> shift) & 0xFF] == size) continue;
+
+    int offset = 0;
+    for(int b=0;b<256;++b) {
+      const int count = counts[d][b];
+      counts[d][b] = offset;
+      offset += count;
+    }
+    for(int i=0;i<size;++i) {
+      const int b = (PolyBuilderSortKey(from[i].exp) >> shift) & 0xFF;
+      to[counts[d][b]++] = from[i];
+    }
+    Mono* tmp = from;
+    from = to;
+    to = tmp;
+  }
+  if(from != monos) {
+    memcpy(monos, from, size * sizeof(Mono));
+  }
+  free(buffer);
 }
 
 /*
-* Allocates memory for monomial then tries to insert it
-* using PolyInsertMono if the function fails
-* then memory is automatically freed.
+* Creates polynomial from monomials added to the builder:
+* sorts them (if they were not added in order)
+* and merges the ones with the same exponents
 */
-static inline void PolyInsertMonoPtr(Poly* p, Mono* new_mono_ptr) {
-  if(!PolyTryInsertMono(p, new_mono_ptr)) {
-    MonoDestroy(new_mono_ptr);
-    free(new_mono_ptr);
+Poly PolyBuilderBuild(PolyBuilder* builder) {
+  assert(builder!=NULL);
+  Poly p = builder->p;
+  const bool sorted = builder->sorted;
+  *builder = PolyBuilderNew();
+
+  if(p.size == 0) {
+    PolyMonosFree(&p);
+    return p;
+  }
+  if(sorted) {
+    return p;
+  }
+
+  if(p.size < POLY_BUILDER_RADIX_THRESHOLD) {
+    PolyBuilderInsertionSort(p.monos, p.size);
+  } else {
+    PolyBuilderRadixSort(p.monos, p.size);
+  }
+
+  int size = 0;
+  for(int i=0;i<p.size;++i) {
+    if(size > 0 && p.monos[size-1].exp == p.monos[i].exp) {
+      PolyAddTakeInPlace(&(p.monos[size-1].p), &(p.monos[i].p));
+      MonoDestroy(&(p.monos[i]));
+      continue;
+    }
+    if(size > 0 && PolyIsZero(&(p.monos[size-1].p))) {
+      MonoDestroy(&(p.monos[--size]));
+    }
+    p.monos[size++] = p.monos[i];
+  }
+  if(PolyIsZero(&(p.monos[size-1].p))) {
+    MonoDestroy(&(p.monos[--size]));
+  }
+
+  p.size = size;
+  if(p.size == 0) {
+    PolyMonosFree(&p);
   }
+  return p;
 }
 
-void PolyInsertMono(Poly* p, Mono mono) {
-  PolyInsertMonoValue(p, mono);
+/*
+* Frees monomials added to the builder
+*/
+void PolyBuilderDestroy(PolyBuilder* builder) {
+  assert(builder!=NULL);
+  PolyDestroy(&(builder->p));
+  *builder = PolyBuilderNew();
 }
 
-int MonoHelperSorter(const void * p1, const void * p2) {
-    Mono e1 = *((Mono*)p1);
-    Mono e2 = *((Mono*)p2);
-    if (e1.exp > e2.exp) return  1;
-    if (e1.exp < e2.exp) return -1;
-    return 0;
+/*
+* Adds monos to create new polynomial.
+*/
+Poly PolyAddMonos(unsigned count, const Mono monos[]) {
+  PolyBuilder builder = PolyBuilderNew();
+  PolyMonosReserve(&(builder.p), (int) count);
+  for(unsigned int i=0;i<count;++i) {
+    PolyBuilderAdd(&builder, monos[i]);
+  };
+  return PolyBuilderBuild(&builder);
+}
+
+/*
+* Reduces coefficients of polynomial using current modulus (see poly.h)
+*/
+void PolyReduceCoeffs(Poly* p) {
+  assert(p!=NULL);
+  if(!PolyCoeffIsModular()) return;
+  Poly result = PolyFromCoeff(PolyCoeffReduce(p->c));
+  PolyCoeffDestroy(p->c);
+  PolyMonosMakeOwned(p);
+  LOOP_POLY(p, m) {
+    PolyReduceCoeffs(&(m->p));
+    PolyInsertMonoValue(&result, *m);
+  }
+  PolyMonosFree(p);
+  *p = result;
+}
+
+/*
+* Single term of polynomial seen by multiplication engine
+* (constant term is treated as term with exponent 0)
+*/
+typedef struct PolyMulTerm {
+  poly_exp_t exp; ///< Exponent of term
+  const Poly* p; ///< Coefficient of term
+} PolyMulTerm;
+
+/*
+* Entry of the multiplication heap - the product of
+* row term @p i with the @p j-th term of other polynomial
+*/
+typedef struct PolyMulHeapEntry {
+  poly_exp_t exp; ///< Exponent of product (heap key)
+  int i; ///< Index of row term
+  int j; ///< Index of column term
+} PolyMulHeapEntry;
+
+/*
+* Creates terms list of polynomial for multiplication engine.
+* The constant term is referenced through @p const_poly storage.
+* Returns number of created terms.
+*/
+static int PolyMulTermsOf(const Poly* p, Poly* const_poly, PolyMulTerm* terms) {
+  int count = 0;
+  if(p->c != 0) {
+    *const_poly = PolyFromCoeff(p->c);
+    terms[count++] = (PolyMulTerm) { .exp = 0, .p = const_poly };
+  }
+  LOOP_POLY(p, m) {
+    terms[count++] = (PolyMulTerm) { .exp = m->exp, .p = &(m->p) };
+  }
+  return count;
+}
+
+/*
+* Restores heap property going down from @p index
+*/
+static inline void PolyMulHeapSiftDown(PolyMulHeapEntry* heap, int size, int index) {
+  const PolyMulHeapEntry entry = heap[index];
+  while(true) {
+    int child = 2*index + 1;
+    if(child >= size) break;
+    if(child + 1 < size && heap[child+1].exp < heap[child].exp) {
+      ++child;
+    }
+    if(heap[child].exp >= entry.exp) break;
+    heap[index] = heap[child];
+    index = child;
+  }
+  heap[index] = entry;
+}
+
+/*
+* Adds product of two terms coefficients to the accumulator.
+* Products of constants are summed in @p coeffs
+* (which must be flushed to the accumulator with PolyCoeffAccFlush).
+*/
+static inline void PolyMulAccumulate(Poly* acc, PolyCoeffAcc* coeffs, const Poly* a, const Poly* b) {
+  if(PolyIsCoeff(a) && PolyIsCoeff(b)) {
+    PolyCoeffAccMulAdd(coeffs, a->c, b->c);
+  } else if(PolyIsCoeff(a)) {
+    PolyAddScaledInPlace(acc, b, a->c);
+  } else if(PolyIsCoeff(b)) {
+    PolyAddScaledInPlace(acc, a, b->c);
+  } else {
+    Poly product = PolyMul(a, b);
+    PolyAddTakeInPlace(acc, &product);
+  }
+}
+
+/*
+* Appends accumulated coefficient of term with exponent @p exp
+* to the result of multiplication.
+* The accumulator is then reset to zero.
+*/
+static inline void PolyMulFlush(Poly* result, Poly* acc, poly_exp_t exp) {
+  if(exp == 0) {
+    PolyCoeffReplace(&(result->c), PolyCoeffAdd(result->c, acc->c));
+    PolyCoeffReplace(&(acc->c), 0);
+  }
+  if(PolyIsZero(acc)) {
+    return;
+  }
+  if(exp == 0 && PolyIsCoeff(acc)) {
+    return;
+  }
+  PolyPushMono(result, MonoFromPoly(acc, exp));
+  *acc = PolyZero();
+}
+
+/*
+* Dense multiplication works on arrays of coefficients,
+* where i-th element is the coefficient of x^i (zero polynomials for gaps).
+* All dense kernels accumulate their result: r += a * b,
+* where r has at least na + nb - 1 elements.
+*/
+static void PolyDenseMulAcc(Poly* r, const Poly* a, int na, const Poly* b, int nb);
+
+/*
+* Creates array of all zero polynomials
+*/
+static inline Poly* PolyDenseNew(int len) {
+  Poly* result = MALLOCATE_ARRAY(Poly, len);
+  for(int i=0;i<len;++i) {
+    result[i] = PolyZero();
+  }
+  return result;
+}
+
+/*
+* Destroys dense array with all its coefficients
+*/
+static inline void PolyDenseFree(Poly* a, int len) {
+  for(int i=0;i<len;++i) {
+    PolyDestroy(&a[i]);
+  }
+  free(a);
+}
+
+/*
+* Performs dst += src * scale on dense arrays
+* (only first @p len elements of @p dst are modified).
+*/
+static inline void PolyDenseAddScaled(Poly* dst, int len, const Poly* src, int src_len, poly_coeff_t scale) {
+  if(src_len > len) src_len = len;
+  for(int i=0;i<src_len;++i) {
+    PolyAddScaledInPlace(&dst[i], &src[i], scale);
+  }
+}
+
+/*
+* Performs dst += src on dense arrays, taking ownership of @p src elements
+* (only first @p len elements of @p dst are modified).
+*/
+static inline void PolyDenseAddTake(Poly* dst, int len, Poly* src, int src_len) {
+  for(int i=0;i<src_len;++i) {
+    if(i < len) {
+      PolyAddTakeInPlace(&dst[i], &src[i]);
+    } else {
+      PolyDestroy(&src[i]);
+    }
+  }
+}
+
+/*
+* Creates dense array a + b * scale (of length max(na, nb))
+*/
+static inline Poly* PolyDenseSum(const Poly* a, int na, const Poly* b, int nb, poly_coeff_t scale) {
+  const int len = (na > nb) ? na : nb;
+  Poly* result = MALLOCATE_ARRAY(Poly, len);
+  for(int i=0;i<len;++i) {
+    result[i] = (i < na) ? PolyClone(&a[i]) : PolyZero();
+  }
+  PolyDenseAddScaled(result, len, b, nb, scale);
+  return result;
+}
+
+/*
+* Divides all coefficients of polynomial by 2.
+* The coefficients must be even.
+*/
+static void PolyHalveRec(Poly* p) {
+  PolyMonosMakeOwned(p);
+  PolyCoeffReplace(&(p->c), PolyCoeffDivExact(p->c, 2));
+  LOOP_POLY(p, m) {
+    PolyHalveRec(&(m->p));
+  }
+}
+
+/*
+* Divides all coefficients of polynomial by 3.
+* The coefficients must be divisible by 3.
+*/
+static void PolyDivExact3Rec(Poly* p) {
+  PolyMonosMakeOwned(p);
+  PolyCoeffReplace(&(p->c), PolyCoeffDivExact(p->c, 3));
+  LOOP_POLY(p, m) {
+    PolyDivExact3Rec(&(m->p));
+  }
+}
+
+/*
+* Term by term multiplication of dense arrays.
+* Every term of the result is summed at once (so the sums of
+* constant products are kept in machine integers).
+*/
+static void PolyDenseMulBasecase(Poly* r, const Poly* a, int na, const Poly* b, int nb) {
+  PolyCoeffAcc coeffs = PolyCoeffAccZero();
+  for(int k=0;k<na+nb-1;++k) {
+    const int i_end = (k < na) ? k : na - 1;
+    for(int i=(k < nb) ? 0 : k-nb+1;i<=i_end;++i) {
+      if(PolyIsZero(&a[i]) || PolyIsZero(&b[k-i])) continue;
+      PolyMulAccumulate(&r[k], &coeffs, &a[i], &b[k-i]);
+    }
+    PolyCoeffAccFlush(&coeffs, &(r[k].c));
+  }
+}
+
+/*
+* Karatsuba multiplication of dense arrays
+* (the lengths must satisfy na/2 < nb <= na)
+*/
+static void PolyDenseMulKaratsuba(Poly* r, const Poly* a, int na, const Poly* b, int nb) {
+  const int m = (na + 1) / 2;
+  const int na1 = na - m;
+  const int nb0 = (nb < m) ? nb : m;
+  const int nb1 = nb - nb0;
+
+  if(nb1 == 0) {
+    PolyDenseMulAcc(r, a, m, b, nb0);
+    PolyDenseMulAcc(r + m, a + m, na1, b, nb0);
+    return;
+  }
+
+  // z0 = a0*b0, z2 = a1*b1, z1 = (a0+a1)*(b0+b1) - z0 - z2
+  const int nz0 = m + nb0 - 1;
+  const int nz2 = na1 + nb1 - 1;
+  const int nz1 = 2*m - 1;
+  Poly* z0 = PolyDenseNew(nz0);
+  Poly* z1 = PolyDenseNew(nz1);
+  Poly* z2 = PolyDenseNew(nz2);
+  PolyDenseMulAcc(z0, a, m, b, nb0);
+  PolyDenseMulAcc(z2, a + m, na1, b + m, nb1);
+
+  Poly* sa = PolyDenseSum(a, m, a + m, na1, 1);
+  Poly* sb = PolyDenseSum(b, nb0, b + m, nb1, 1);
+  PolyDenseMulAcc(z1, sa, m, sb, nb0);
+  PolyDenseFree(sa, m);
+  PolyDenseFree(sb, nb0);
+
+  PolyDenseAddScaled(z1, nz1, z0, nz0, -1);
+  PolyDenseAddScaled(z1, nz1, z2, nz2, -1);
+
+  const int nr = na + nb - 1;
+  PolyDenseAddTake(r, nr, z0, nz0);
+  PolyDenseAddTake(r + m, nr - m, z1, nz1);
+  PolyDenseAddTake(r + 2*m, nr - 2*m, z2, nz2);
+  free(z0);
+  free(z1);
+  free(z2);
+}
+
+/*
+* Evaluates dense polynomial split into three parts at points
+* 0, 1, -1, -2 and infinity (results are stored in @p values).
+* Part 0 and 1 have length k, part 2 has length @p n2.
+*/
+static void PolyDenseToom3Evaluate(const Poly* a, int k, int n2, Poly* values[5]) {
+  const Poly* a0 = a;
+  const Poly* a1 = a + k;
+  const Poly* a2 = a + 2*k;
+
+  Poly* s = PolyDenseSum(a0, k, a2, n2, 1);
+  values[0] = NULL;
+  values[1] = PolyDenseSum(s, k, a1, k, 1);
+  values[2] = PolyDenseSum(s, k, a1, k, -1);
+  // (a0 - a1 + a2)*2 + 2*a2 - a0 = a0 - 2*a1 + 4*a2
+  values[3] = PolyDenseSum(values[2], k, a2, n2, 1);
+  for(int i=0;i<k;++i) {
+    PolyScaleConst(&values[3][i], 2);
+  }
+  PolyDenseAddScaled(values[3], k, a0, k, -1);
+  values[4] = NULL;
+  PolyDenseFree(s, k);
+}
+
+/*
+* Toom-3 multiplication of dense arrays
+* (both arrays must be longer than 2*ceil(na/3))
+*
+* The interpolation follows Bodrato's sequence, that uses
+* only exact divisions by 2 and 3.
+*/
+static void PolyDenseMulToom3(Poly* r, const Poly* a, int na, const Poly* b, int nb) {
+  const int k = (na + 2) / 3;
+  const int na2 = na - 2*k;
+  const int nb2 = nb - 2*k;
+  const int nw = 2*k - 1;
+  const int nwinf = na2 + nb2 - 1;
+
+  Poly* va[5];
+  Poly* vb[5];
+  PolyDenseToom3Evaluate(a, k, na2, va);
+  PolyDenseToom3Evaluate(b, k, nb2, vb);
+
+  Poly* w0 = PolyDenseNew(nw);
+  Poly* w1 = PolyDenseNew(nw);
+  Poly* wm1 = PolyDenseNew(nw);
+  Poly* wm2 = PolyDenseNew(nw);
+  Poly* winf = PolyDenseNew(nwinf);
+  PolyDenseMulAcc(w0, a, k, b, k);
+  PolyDenseMulAcc(w1, va[1], k, vb[1], k);
+  PolyDenseMulAcc(wm1, va[2], k, vb[2], k);
+  PolyDenseMulAcc(wm2, va[3], k, vb[3], k);
+  PolyDenseMulAcc(winf, a + 2*k, na2, b + 2*k, nb2);
+  for(int i=1;i<=3;++i) {
+    PolyDenseFree(va[i], k);
+    PolyDenseFree(vb[i], k);
+  }
+
+  // w3 = (wm2 - w1) / 3
+  Poly* w3 = wm2;
+  PolyDenseAddScaled(w3, nw, w1, nw, -1);
+  for(int i=0;i<nw;++i) {
+    PolyDivExact3Rec(&w3[i]);
+  }
+  // w1 = (w1 - wm1) / 2
+  PolyDenseAddScaled(w1, nw, wm1, nw, -1);
+  for(int i=0;i<nw;++i) {
+    PolyHalveRec(&w1[i]);
+  }
+  // w2 = wm1 - w0
+  Poly* w2 = wm1;
+  PolyDenseAddScaled(w2, nw, w0, nw, -1);
+  // w3 = (w2 - w3) / 2 + 2*winf
+  for(int i=0;i<nw;++i) {
+    PolyScaleConst(&w3[i], -1);
+  }
+  PolyDenseAddScaled(w3, nw, w2, nw, 1);
+  for(int i=0;i<nw;++i) {
+    PolyHalveRec(&w3[i]);
+  }
+  PolyDenseAddScaled(w3, nw, winf, nwinf, 2);
+  // w2 = w2 + w1 - winf
+  PolyDenseAddScaled(w2, nw, w1, nw, 1);
+  PolyDenseAddScaled(w2, nw, winf, nwinf, -1);
+  // w1 = w1 - w3
+  PolyDenseAddScaled(w1, nw, w3, nw, -1);
+
+  const int nr = na + nb - 1;
+  PolyDenseAddTake(r, nr, w0, nw);
+  PolyDenseAddTake(r + k, nr - k, w1, nw);
+  PolyDenseAddTake(r + 2*k, nr - 2*k, w2, nw);
+  PolyDenseAddTake(r + 3*k, nr - 3*k, w3, nw);
+  PolyDenseAddTake(r + 4*k, nr - 4*k, winf, nwinf);
+  free(w0);
+  free(w1);
+  free(w2);
+  free(w3);
+  free(winf);
+}
+
+/*
+* Multiplication of dense arrays - chooses the algorithm
+*/
+static void PolyDenseMulAcc(Poly* r, const Poly* a, int na, const Poly* b, int nb) {
+  if(na < nb) {
+    const Poly* tmp = a;
+    a = b;
+    b = tmp;
+    const int tmp_len = na;
+    na = nb;
+    nb = tmp_len;
+  }
+  if(nb < POLY_MUL_KARATSUBA_THRESHOLD) {
+    PolyDenseMulBasecase(r, a, na, b, nb);
+    return;
+  }
+  if(2*nb <= na) {
+    // Unbalanced operands - split the longer one into chunks
+    for(int offset=0;offset<na;offset+=nb) {
+      const int chunk = (na - offset < nb) ? (na - offset) : nb;
+      PolyDenseMulAcc(r + offset, a + offset, chunk, b, nb);
+    }
+    return;
+  }
+  // Toom-3 divides by 2 and 3, what is not possible modulo some numbers
+  if(nb >= POLY_MUL_TOOM3_THRESHOLD && nb > 2*((na + 2) / 3) && !PolyCoeffIsModular()) {
+    PolyDenseMulToom3(r, a, na, b, nb);
+    return;
+  }
+  PolyDenseMulKaratsuba(r, a, na, b, nb);
+}
+
+/*
+* Checks if polynomial level is dense enough to be multiplied
+* using dense algorithms
+*/
+static inline bool PolyIsDense(const Poly* p) {
+  if(p->size == 0) return false;
+  const long long terms = p->size + (p->c != 0);
+  const long long len = (long long)(p->monos[p->size-1].exp) + 1;
+  return terms * POLY_MUL_DENSE_RATIO >= len;
+}
+
+/*
+* Creates dense array of coefficients of polynomial.
+* The array elements are shallow views of @p p coefficients,
+* so it must be released only with free().
+*/
+static Poly* PolyToDenseView(const Poly* p, int len) {
+  Poly* result = MALLOCATE_ARRAY(Poly, len);
+  for(int i=0;i<len;++i) {
+    result[i] = PolyZero();
+  }
+  LOOP_POLY(p, m) {
+    result[m->exp] = m->p;
+  }
+  result[0].c = p->c;
+  return result;
+}
+
+/*
+* Checks if all coefficients of polynomial are constant
+*/
+static inline bool PolyHasCoeffMonos(const Poly* p) {
+  LOOP_POLY(p, m) {
+    if(!PolyIsCoeff(&(m->p))) return false;
+  }
+  return true;
+}
+
+/*
+* Counts bits of the largest constant coefficient of polynomial level
+*/
+static inline int PolyMaxCoeffBits(const Poly* p) {
+  int bits = PolyCoeffBits(p->c);
+  LOOP_POLY(p, m) {
+    const int mono_bits = PolyCoeffBits(m->p.c);
+    if(mono_bits > bits) bits = mono_bits;
+  }
+  return bits;
+}
+
+/*
+* Checks if sums of at most @p terms products of coefficients
+* of @p bits_p and @p bits_q bits are stored inline.
+* Then they can be computed in wrapping machine arithmetic
+* (what NTT and Kronecker substitution do).
+*/
+static inline bool PolyMulFitsInline(int bits_p, int bits_q, long long terms) {
+  int bits_terms = 0;
+  while((1LL << bits_terms) < terms) ++bits_terms;
+  return bits_p + bits_q + bits_terms <= 62;
+}
+
+/*
+* Multiply two dense polynomials with constant coefficients using NTT.
+* Returns false if the NTT could not be used.
+*/
+static bool PolyMulNTT(const Poly *p, const Poly *q, Poly* result) {
+  const int np = p->monos[p->size-1].exp + 1;
+  const int nq = q->monos[q->size-1].exp + 1;
+  const int nr = np + nq - 1;
+  if(!PolyMulFitsInline(PolyMaxCoeffBits(p), PolyMaxCoeffBits(q), (np < nq) ? np : nq)) {
+    return false;
+  }
+  long* a = MALLOCATE_ARRAY(long, np);
+  long* b = MALLOCATE_ARRAY(long, nq);
+  long* r = MALLOCATE_ARRAY(long, nr);
+  a[0] = p->c;
+  b[0] = q->c;
+  LOOP_POLY(p, m) {
+    a[m->exp] = m->p.c;
+  }
+  LOOP_POLY(q, m) {
+    b[m->exp] = m->p.c;
+  }
+
+  const bool computed = NTTMultiply(a, np, b, nq, r);
+  if(computed) {
+    *result = PolyFromCoeff(r[0]);
+    for(int i=1;i<nr;++i) {
+      if(r[i] != 0) {
+        PolyPushMono(result, MonoFromCoeff(r[i], i));
+      }
+    }
+  }
+
+  free(a);
+  free(b);
+  free(r);
+  return computed;
+}
+
+/*
+* Multiply two dense polynomials
+*/
+static Poly PolyMulDense(const Poly *p, const Poly *q) {
+  const int np = p->monos[p->size-1].exp + 1;
+  const int nq = q->monos[q->size-1].exp + 1;
+  const int nr = np + nq - 1;
+  Poly* a = PolyToDenseView(p, np);
+  Poly* b = PolyToDenseView(q, nq);
+  Poly* r = PolyDenseNew(nr);
+
+  PolyDenseMulAcc(r, a, np, b, nq);
+  free(a);
+  free(b);
+
+  Poly result = PolyFromCoeff(r[0].c);
+  r[0].c = 0;
+  for(int i=0;i<nr;++i) {
+    if(PolyIsCoeff(&r[i]) && (i == 0 || r[i].c == 0)) {
+      PolyDestroy(&r[i]);
+    } else {
+      PolyPushMono(&result, MonoFromPoly(&r[i], i));
+    }
+  }
+  free(r);
+  return result;
+}
+
+/*
+* Layout of polynomials packed with Kronecker substitution.
+* Exponent of x_0^e_0 * ... * x_(n-1)^e_(n-1) is mapped to
+* sum of e_i * stride[i] (the outer variable is the most significant one).
+*/
+typedef struct PolyKroneckerLayout {
+  int vars; ///< Number of variables
+  long long terms; ///< Number of nonzero constant terms
+  int bits; ///< Number of bits of the largest constant term
+  long long length; ///< Length of packed polynomial
+  long long stride[POLY_MUL_KRONECKER_MAX_VARS]; ///< Strides of variables
+  poly_exp_t bound[POLY_MUL_KRONECKER_MAX_VARS]; ///< Exponents bounds of variables
+} PolyKroneckerLayout;
+
+/*
+* Counts variables and nonzero constant terms of polynomial.
+* Returns false if polynomial has too many variables.
+*/
+static bool PolyKroneckerCountRec(const Poly* p, int var, PolyKroneckerLayout* layout) {
+  if(p->c != 0) {
+    ++(layout->terms);
+    const int bits = PolyCoeffBits(p->c);
+    if(bits > layout->bits) layout->bits = bits;
+  }
+  if(p->size == 0) {
+    return true;
+  }
+  if(var >= POLY_MUL_KRONECKER_MAX_VARS) {
+    return false;
+  }
+  if(var + 1 > layout->vars) {
+    layout->vars = var + 1;
+  }
+  LOOP_POLY(p, m) {
+    if(!PolyKroneckerCountRec(&(m->p), var + 1, layout)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+* Computes layout for packing product of @p p and @p q.
+* Returns false if Kronecker substitution should not be used.
+*/
+static bool PolyKroneckerLayoutOf(const Poly* p, const Poly* q, PolyKroneckerLayout* layout) {
+  PolyKroneckerLayout lp = { .vars = 0, .terms = 0, .bits = 0 };
+  PolyKroneckerLayout lq = { .vars = 0, .terms = 0, .bits = 0 };
+  if(!PolyKroneckerCountRec(p, 0, &lp) || !PolyKroneckerCountRec(q, 0, &lq)) {
+    return false;
+  }
+  if(!PolyMulFitsInline(lp.bits, lq.bits, (lp.terms < lq.terms) ? lp.terms : lq.terms)) {
+    return false;
+  }
+  layout->vars = (lp.vars > lq.vars) ? lp.vars : lq.vars;
+  layout->terms = lp.terms * lq.terms;
+  if(layout->vars < 2 || layout->terms < POLY_MUL_KRONECKER_THRESHOLD) {
+    return false;
+  }
+
+  // Product degree by each variable is the sum of degrees of factors
+  for(int var=0;var<layout->vars;++var) {
+    const poly_exp_t deg_p = PolyDegBy(p, var);
+    const poly_exp_t deg_q = PolyDegBy(q, var);
+    layout->bound[var] = ((deg_p > 0) ? deg_p : 0) + ((deg_q > 0) ? deg_q : 0) + 1;
+  }
+  long long length = 1;
+  for(int var=layout->vars-1;var>=0;--var) {
+    layout->stride[var] = length;
+    length *= layout->bound[var];
+    if(length > POLY_MUL_KRONECKER_MAX_LENGTH) {
+      return false;
+    }
+  }
+  layout->length = length;
+
+  // The packed product must not be much sparser than the term by term one
+  return layout->length * POLY_MUL_KRONECKER_RATIO <= layout->terms;
+}
+
+/*
+* Packs polynomial into array of coefficients
+*/
+static void PolyKroneckerPackRec(const Poly* p, int var, long long offset,
+                                 const PolyKroneckerLayout* layout, long* packed) {
+  packed[offset] += p->c;
+  LOOP_POLY(p, m) {
+    PolyKroneckerPackRec(&(m->p), var + 1, offset + m->exp * layout->stride[var], layout, packed);
+  }
+}
+
+/*
+* Creates polynomial from packed array of coefficients
+*/
+static Poly PolyKroneckerUnpackRec(int var, long long offset,
+                                   const PolyKroneckerLayout* layout, const long* packed) {
+  if(var == layout->vars) {
+    return PolyFromCoeff(packed[offset]);
+  }
+  Poly result = PolyZero();
+  for(poly_exp_t exp=0;exp<layout->bound[var];++exp) {
+    Poly coeff = PolyKroneckerUnpackRec(var + 1, offset + exp * layout->stride[var], layout, packed);
+    PolyMulFlush(&result, &coeff, exp);
+    PolyDestroy(&coeff);
+  }
+  return result;
+}
+
+/*
+* Multiply two multivariate polynomials using Kronecker substitution.
+* The polynomials are packed into univariate ones, multiplied
+* using NTT and unpacked.
+* Returns false if the substitution could not be used.
+*/
+static bool PolyMulKronecker(const Poly *p, const Poly *q, Poly* result) {
+  PolyKroneckerLayout layout;
+  if(!NTT_SUPPORTED || PolyCoeffIsModular() || !PolyKroneckerLayoutOf(p, q, &layout)) {
+    return false;
+  }
+
+  // Packed factors are never longer than the product
+  const int length = (int)layout.length;
+  long* a = MALLOCATE_ARRAY(long, length);
+  long* b = MALLOCATE_ARRAY(long, length);
+  PolyKroneckerPackRec(p, 0, 0, &layout, a);
+  PolyKroneckerPackRec(q, 0, 0, &layout, b);
+  int na = length;
+  int nb = length;
+  while(na > 1 && a[na-1] == 0) --na;
+  while(nb > 1 && b[nb-1] == 0) --nb;
+
+  long* r = MALLOCATE_ARRAY(long, length);
+  const bool computed = NTTMultiply(a, na, b, nb, r);
+  free(a);
+  free(b);
+  if(computed) {
+    *result = PolyKroneckerUnpackRec(0, 0, &layout, r);
+  }
+  free(r);
+  return computed;
+}
+
+/*
+* Multiply two polynomials using heap over the terms of shorter polynomial
+* (Johnson's algorithm).
+* Each heap entry points to the next product of its row.
+* The products are popped in rising exponents order, so the terms
+* with the same exponent are summed up as they come and the result
+* is built by appending only.
+*/
+static Poly PolyMulHeap(const Poly *p, const Poly *q) {
+  if(p->size > q->size) {
+    const Poly* tmp = p;
+    p = q;
+    q = tmp;
+  }
+
+  Poly p_const;
+  Poly q_const;
+  PolyMulTerm* rows = MALLOCATE_ARRAY(PolyMulTerm, p->size + 1);
+  PolyMulTerm* cols = MALLOCATE_ARRAY(PolyMulTerm, q->size + 1);
+  const int rows_count = PolyMulTermsOf(p, &p_const, rows);
+  const int cols_count = PolyMulTermsOf(q, &q_const, cols);
+
+  PolyMulHeapEntry* heap = MALLOCATE_ARRAY(PolyMulHeapEntry, rows_count);
+  int heap_size = 0;
+  for(int i=0;i<rows_count;++i) {
+    heap[heap_size++] = (PolyMulHeapEntry) { .exp = rows[i].exp + cols[0].exp, .i = i, .j = 0 };
+  }
+  // Rows are sorted so the initial array is already a heap
+
+  Poly result = PolyZero();
+  Poly acc = PolyZero();
+  PolyCoeffAcc acc_coeffs = PolyCoeffAccZero();
+  poly_exp_t acc_exp = heap[0].exp;
+
+  while(heap_size > 0) {
+    PolyMulHeapEntry* top = &heap[0];
+    if(top->exp != acc_exp) {
+      PolyCoeffAccFlush(&acc_coeffs, &(acc.c));
+      PolyMulFlush(&result, &acc, acc_exp);
+      acc_exp = top->exp;
+    }
+
+    PolyMulAccumulate(&acc, &acc_coeffs, rows[top->i].p, cols[top->j].p);
+
+    if(top->j + 1 < cols_count) {
+      ++(top->j);
+      top->exp = rows[top->i].exp + cols[top->j].exp;
+    } else {
+      heap[0] = heap[--heap_size];
+    }
+    if(heap_size > 0) {
+      PolyMulHeapSiftDown(heap, heap_size, 0);
+    }
+  }
+  PolyCoeffAccFlush(&acc_coeffs, &(acc.c));
+  PolyMulFlush(&result, &acc, acc_exp);
+  PolyDestroy(&acc);
+
+  free(heap);
+  free(rows);
+  free(cols);
+
+  if(result.size == 0) {
+    PolyMonosFree(&result);
+  }
+  return result;
+}
+
+/*
+* Pair of polynomials added by the reduction task
+*/
+typedef struct PolySumTask {
+  Poly* dst; ///< Sum destination
+  Poly* src; ///< Added polynomial (taken by the task)
+} PolySumTask;
+
+/*
+* Adds polynomials of the reduction pair
+*/
+static void PolySumTaskRun(void* arg) {
+  PolySumTask* task = arg;
+  PolyAddTakeInPlace(task->dst, task->src);
+}
+
+/*
+* Sums polynomials with parallel tree reduction.
+* The sum is placed in the first polynomial.
+*/
+static void PolySumParallel(Poly* polys, int len, ThreadPool* pool) {
+  PolySumTask* tasks = MALLOCATE_ARRAY(PolySumTask, len);
+  for(int step=1;step<len;step*=2) {
+    ThreadPoolGroup group = ThreadPoolGroupNew();
+    int submitted = 0;
+    for(int i=0;i+step<len;i+=2*step) {
+      tasks[submitted] = (PolySumTask) { .dst = &polys[i], .src = &polys[i+step] };
+      ThreadPoolSubmit(pool, &group, PolySumTaskRun, &tasks[submitted]);
+      ++submitted;
+    }
+    ThreadPoolWait(pool, &group);
+  }
+  free(tasks);
+}
+
+/*
+* Multiplication of slice of monomials by polynomial
+* executed as a task of the thread pool
+*/
+typedef struct PolyMulTask {
+  Poly slice; ///< View of the slice of monomials
+  const Poly* q; ///< Second factor
+  Poly result; ///< Product
+} PolyMulTask;
+
+/*
+* Multiplies the slice by the second factor
+*/
+static void PolyMulTaskRun(void* arg) {
+  PolyMulTask* task = arg;
+  task->result = PolyMulHeap(&(task->slice), task->q);
+}
+
+/*
+* Multiply two polynomials using heap, splitting the longer one into slices
+* multiplied in parallel. The partial products are merged with parallel
+* tree reduction.
+*/
+static Poly PolyMulHeapParallel(const Poly *p, const Poly *q, ThreadPool* pool) {
+  if(p->size < q->size) {
+    const Poly* tmp = p;
+    p = q;
+    q = tmp;
+  }
+  if(p->size < 2 || PolyCountMonosRec(p) * PolyCountMonosRec(q) < POLY_MUL_PARALLEL_THRESHOLD) {
+    return PolyMulHeap(p, q);
+  }
+
+  // Few slices per thread balance the load (rows differ in cost)
+  int slices = 2 * ThreadPoolThreads(pool);
+  if(slices > p->size) slices = p->size;
+  PolyMulTask* tasks = MALLOCATE_ARRAY(PolyMulTask, slices);
+  Poly* results = MALLOCATE_ARRAY(Poly, slices);
+  ThreadPoolGroup group = ThreadPoolGroupNew();
+  for(int i=0;i<slices;++i) {
+    const int begin = (int)((long long)(p->size) * i / slices);
+    const int end = (int)((long long)(p->size) * (i+1) / slices);
+    // Slices are read only views (not owned arrays)
+    tasks[i] = (PolyMulTask) {
+      .slice = { .c = (i == 0) ? p->c : 0, .monos = p->monos + begin, .size = end - begin, .alloc_size = 0 },
+      .q = q,
+      .result = PolyZero()
+    };
+    ThreadPoolSubmit(pool, &group, PolyMulTaskRun, &tasks[i]);
+  }
+  ThreadPoolWait(pool, &group);
+
+  for(int i=0;i<slices;++i) {
+    results[i] = tasks[i].result;
+  }
+  free(tasks);
+  PolySumParallel(results, slices, pool);
+  Poly result = results[0];
+  free(results);
+  return result;
+}
+
+/*
+* Multiply two polynomials (using the thread pool if it's not NULL)
+*
+* Products of two dense levels are computed using Karatsuba or Toom-3
+* (see PolyDenseMulAcc) or NTT if all coefficients are constant.
+* Large products of multivariate polynomials are computed using
+* Kronecker substitution (see PolyMulKronecker).
+* NTT and Kronecker substitution are used only if all the coefficients
+* of the product are small (see PolyMulFitsInline).
+* Otherwise uses heap (see PolyMulHeap and PolyMulHeapParallel).
+*/
+static Poly PolyMulWith(const Poly *p, const Poly *q, ThreadPool* pool) {
+  assert(p!=NULL);
+  assert(q!=NULL);
+
+  if(PolyIsCoeff(p)) {
+    Poly result = PolyClone(q);
+    PolyScaleConst(&result, p->c);
+    return result;
+  }
+  if(PolyIsCoeff(q)) {
+    Poly result = PolyClone(p);
+    PolyScaleConst(&result, q->c);
+    return result;
+  }
+
+  Poly kronecker_result;
+  if(PolyMulKronecker(p, q, &kronecker_result)) {
+    return kronecker_result;
+  }
+
+  if(PolyIsDense(p) && PolyIsDense(q)) {
+    const poly_exp_t min_deg = (p->monos[p->size-1].exp < q->monos[q->size-1].exp)
+      ? p->monos[p->size-1].exp : q->monos[q->size-1].exp;
+    if(NTT_SUPPORTED && !PolyCoeffIsModular() && min_deg >= POLY_MUL_NTT_THRESHOLD
+       && PolyHasCoeffMonos(p) && PolyHasCoeffMonos(q)) {
+      Poly result;
+      if(PolyMulNTT(p, q, &result)) {
+        return result;
+      }
+    }
+    if(min_deg >= POLY_MUL_KARATSUBA_THRESHOLD) {
+      return PolyMulDense(p, q);
+    }
+  }
+
+  if(pool != NULL) {
+    return PolyMulHeapParallel(p, q, pool);
+  }
+  return PolyMulHeap(p, q);
+}
+
+/*
+* Multiply two polynomials
+*/
+Poly PolyMul(const Poly *p, const Poly *q) {
+  return PolyMulWith(p, q, NULL);
+}
+
+/*
+* Multiply two polynomials using the thread pool
+*/
+Poly PolyMulParallel(const Poly *p, const Poly *q, ThreadPool* pool) {
+  return PolyMulWith(p, q, pool);
+}
+
+/*
+* Recursively negate polynomial
+*/
+void PolyNegRec(Poly *p) {
+  PolyMonosMakeOwned(p);
+  PolyCoeffReplace(&(p->c), PolyCoeffNeg(p->c));
+  LOOP_POLY(p, m) {
+    PolyNegRec(&(m->p));
+  }
+}
+
+/*
+* Negate polynomial
+*/
+Poly PolyNeg(const Poly *p) {
+  Poly ret = PolyClone(p);
+  PolyNegRec(&ret);
+  return ret;
+}
+
+/*
+* Substract two polynomials
+*/
+Poly PolySub(const Poly *p, const Poly *q) {
+  return PolyAddScaled(p, q, -1);
+}
+
+/*
+* Negate polynomial in place
+*/
+void PolyNegInPlace(Poly *p) {
+  assert(p!=NULL);
+  PolyNegRec(p);
+}
+
+/*
+* Substract polynomial in place taking ownership of it
+*/
+void PolySubTakeInPlace(Poly *p, Poly *q) {
+  assert(p!=NULL);
+  assert(q!=NULL);
+  PolyNegRec(q);
+  PolyAddTakeInPlace(p, q);
+}
+
+/*
+* Multiply polynomial in place taking ownership of the other one
+* (using the thread pool if it's not NULL)
+*/
+static void PolyMulTakeInPlaceWith(Poly *p, Poly *q, ThreadPool* pool) {
+  assert(p!=NULL);
+  assert(q!=NULL);
+  if(PolyIsCoeff(q)) {
+    PolyScaleConst(p, q->c);
+  } else if(PolyIsCoeff(p)) {
+    const poly_coeff_t c = p->c;
+    *p = *q;
+    PolyScaleConst(p, c);
+    PolyCoeffDestroy(c);
+    *q = PolyZero();
+    return;
+  } else {
+    PolyReplace(p, PolyMulWith(p, q, pool));
+  }
+  PolyDestroy(q);
+  *q = PolyZero();
+}
+
+/*
+* Multiply polynomial in place taking ownership of the other one
+*/
+void PolyMulTakeInPlace(Poly *p, Poly *q) {
+  PolyMulTakeInPlaceWith(p, q, NULL);
+}
+
+/*
+* Multiply polynomial in place taking ownership of the other one
+* using the thread pool
+*/
+void PolyMulTakeInPlaceParallel(Poly *p, Poly *q, ThreadPool* pool) {
+  PolyMulTakeInPlaceWith(p, q, pool);
+}
+
+/*
+* Find degree of polynomial with respect to the given variable index.
+* Recursive helper.
+*/
+poly_exp_t PolyDegByRec(const Poly *p, unsigned var_idcur, unsigned var_idx,
+  int sum_all) {
+
+  poly_exp_t ret = -1;
+  if(p->c != 0) ret = 0;
+  LOOP_POLY(p, m) {
+    poly_exp_t temp = PolyDegByRec(&(m->p), var_idcur+1, var_idx, sum_all);
+    if(var_idcur == var_idx || sum_all) {
+      temp += m->exp;
+    }
+    if(temp > ret) {
+      ret = temp;
+    }
+  }
+  return ret;
+}
+
+/*
+* Find degree of polynomial with respect to the given variable index.
+*/
+poly_exp_t PolyDegBy(const Poly *p, unsigned var_idx) {
+  return PolyDegByRec(p, 0, var_idx, 0);
+}
+
+/*
+* Find degree of polynomial assuming that all variables are equal.
+*/
+poly_exp_t PolyDeg(const Poly *p) {
+  return PolyDegByRec(p, 0, 0, 1);
+}
+
+/*
+* Recursive equality test for polynomials
+*/
+bool PolyIsEqRec(const Poly *p, const Poly *q) {
+  if(p == q) return true;
+  if(!PolyCoeffIsEq(p->c, q->c)) {
+    return false;
+  }
+  if(p->size != q->size) {
+    return false;
+  }
+  // Clones and interned polynomials share their arrays
+  if(p->monos == q->monos) {
+    return true;
+  }
+
+  for(int i=0;i<p->size;++i) {
+    const Mono* mp = &(p->monos[i]);
+    const Mono* mq = &(q->monos[i]);
+    if(mp->exp != mq->exp) {
+      return false;
+    }
+    if(!PolyIsEqRec(&(mp->p), &(mq->p))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+* Equality test for polynomials
+*/
+bool PolyIsEq(const Poly *p, const Poly *q) {
+  return PolyIsEqRec(p, q);
+}
+
+/*
+* Calculate polynomial exponent in place
+* (using the thread pool if it's not NULL)
+*/
+static void PolyPowInPlaceWith(Poly* p, poly_exp_t exp, ThreadPool* pool) {
+  assert(p!=NULL);
+
+  if(exp == 0) {
+    PolyReplace(p, PolyFromCoeff(1));
+    return;
+  }
+  if(exp == 1) return;
+
+  if(PolyIsCoeff(p)) {
+    if(p->c == 0) return;
+    if(p->c == 1) return;
+    if(p->c == -1) {
+      if(exp % 2 == 0) p->c = 1;
+      return;
+    }
+  }
+
+  // The result is not materialized until the first set bit is found,
+  // and base is not squared after the last one
+  Poly result = PolyZero();
+  bool result_set = false;
+  Poly base = *p;
+
+  while (exp) {
+    if (exp & 1) {
+      if(result_set) {
+        PolyReplace(&result, PolyMulWith(&result, &base, pool));
+      } else {
+        result = PolyClone(&base);
+        result_set = true;
+      }
+    }
+    exp >>= 1;
+    if(exp) {
+      PolyReplace(&base, PolyMulWith(&base, &base, pool));
+    }
+  }
+  PolyDestroy(&base);
+
+  *p = result;
+}
+
+/*
+* Calculate polynomial exponent in place
+*/
+void PolyPowInPlace(Poly* p, poly_exp_t exp) {
+  PolyPowInPlaceWith(p, exp, NULL);
+}
+
+/*
+* Calculate polynomial exponent in place using the thread pool
+*/
+void PolyPowInPlaceParallel(Poly* p, poly_exp_t exp, ThreadPool* pool) {
+  PolyPowInPlaceWith(p, exp, pool);
+}
+
+/*
+* Calculate polynomial exponent
+*/
+Poly PolyPow(const Poly* p, poly_exp_t exp) {
+  assert(p!=NULL);
+  if(exp == 0) return PolyFromCoeff(1);
+  Poly result = PolyClone(p);
+  PolyPowInPlace(&result, exp);
+  return result;
+}
+
+/*
+* Creates cache of powers of @p base
+*/
+PolyPowCache PolyPowCacheNew(const Poly* base) {
+  assert(base!=NULL);
+  PolyPowCache cache = {
+    .squares = MALLOCATE_ARRAY(Poly, 1),
+    .squares_count = 1,
+    .powers = NULL,
+    .size = 0,
+    .alloc_size = 0
+  };
+  cache.squares[0] = PolyClone(base);
+  return cache;
+}
+
+/*
+* Destroys cache of powers
+*/
+void PolyPowCacheDestroy(PolyPowCache* cache) {
+  assert(cache!=NULL);
+  for(int i=0;i<cache->squares_count;++i) {
+    PolyDestroy(&(cache->squares[i]));
+  }
+  for(int i=0;i<cache->size;++i) {
+    MonoDestroy(&(cache->powers[i]));
+  }
+  free(cache->squares);
+  free(cache->powers);
+  *cache = (PolyPowCache) { .squares = NULL, .squares_count = 0, .powers = NULL, .size = 0, .alloc_size = 0 };
+}
+
+/*
+* Gets base^(2^i) from the ladder of squares extending it if needed
+*/
+static const Poly* PolyPowCacheSquare(PolyPowCache* cache, int i) {
+  if(i >= cache->squares_count) {
+    cache->squares = MREALLOCATE_ARRAY(Poly, i + 1, cache->squares);
+    while(cache->squares_count <= i) {
+      const Poly* last = &(cache->squares[cache->squares_count - 1]);
+      cache->squares[cache->squares_count] = PolyMul(last, last);
+      ++(cache->squares_count);
+    }
+  }
+  return &(cache->squares[i]);
+}
+
+/*
+* Finds index of the first cached power with exponent not lower than @p exp
+*/
+static inline int PolyPowCacheFind(const PolyPowCache* cache, poly_exp_t exp) {
+  int lo = 0;
+  int hi = cache->size;
+  while(lo < hi) {
+    const int mid = lo + (hi - lo) / 2;
+    if(cache->powers[mid].exp < exp) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/*
+* Calculate polynomial exponent using cache (see poly.h)
+*/
+Poly PolyPowCached(PolyPowCache* cache, poly_exp_t exp) {
+  assert(cache!=NULL);
+  assert(cache->squares_count > 0);
+  assert(exp >= 0);
+  const Poly* base = &(cache->squares[0]);
+  if(exp == 0) return PolyFromCoeff(1);
+  if(exp == 1 || PolyIsCoeff(base)) return PolyPow(base, exp);
+
+  const int pos = PolyPowCacheFind(cache, exp);
+  if(pos < cache->size && cache->powers[pos].exp == exp) {
+    return PolyClone(&(cache->powers[pos].p));
+  }
+
+  // Start from the highest cached power lower than requested one
+  // and multiply it by the squares from the ladder
+  Poly result = PolyZero();
+  bool result_set = false;
+  poly_exp_t rest = exp;
+  if(pos > 0) {
+    result = PolyClone(&(cache->powers[pos - 1].p));
+    result_set = true;
+    rest -= cache->powers[pos - 1].exp;
+  }
+  for(int i=0;rest;++i, rest >>= 1) {
+    if(rest & 1) {
+      const Poly* square = PolyPowCacheSquare(cache, i);
+      if(result_set) {
+        PolyReplace(&result, PolyMul(&result, square));
+      } else {
+        result = PolyClone(square);
+        result_set = true;
+      }
+    }
+  }
+
+  if(cache->size >= cache->alloc_size) {
+    cache->alloc_size = (cache->alloc_size < 4) ? 8 : cache->alloc_size * 2;
+    cache->powers = MREALLOCATE_ARRAY(Mono, cache->alloc_size, cache->powers);
+  }
+  memmove(cache->powers + pos + 1, cache->powers + pos, (cache->size - pos) * sizeof(Mono));
+  cache->powers[pos] = (Mono) { .exp = exp, .p = PolyClone(&result) };
+  ++(cache->size);
+  return result;
+}
+
+/*
+* Evaluate polynomial at a given point
+*/
+Poly PolyAt(const Poly *p, poly_coeff_t x) {
+
+  assert(p!=NULL);
+
+  Poly result = PolyFromCoeff(PolyCoeffClone(p->c));
+  x = PolyCoeffReduce(x);
+
+  LOOP_POLY(p, m) {
+    poly_coeff_t factValue = PolyCoeffPow(x, m->exp);
+    PolyAddScaledInPlace(&result, &(m->p), factValue);
+    PolyCoeffDestroy(factValue);
+  }
+
+  return result;
+}
+
+/*
+* Evaluate polynomial at a given point in place
+*/
+void PolyAtInPlace(Poly *p, poly_coeff_t x) {
+
+  assert(p!=NULL);
+
+  Poly result = PolyFromCoeff(p->c);
+  PolyMonosMakeOwned(p);
+  x = PolyCoeffReduce(x);
+
+  LOOP_POLY(p, m) {
+    poly_coeff_t factValue = PolyCoeffPow(x, m->exp);
+    PolyScaleConst(&(m->p), factValue);
+    PolyCoeffDestroy(factValue);
+    PolyAddTakeInPlace(&result, &(m->p));
+  }
+
+  PolyMonosFree(p);
+  *p = result;
+}
+
+/*
+* Finds index of the first program power not lower than (@p var, @p exp)
+*/
+static inline int PolyProgramPowerFind(const PolyProgram* program, int var, poly_exp_t exp) {
+  int lo = 0;
+  int hi = program->powers_size;
+  while(lo < hi) {
+    const int mid = lo + (hi - lo) / 2;
+    const PolyProgramPower* power = &(program->powers[mid]);
+    if(power->var < var || (power->var == var && power->exp < exp)) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/*
+* Adds power of variable to the program (if it's not already there)
+*/
+static void PolyProgramPowerAdd(PolyProgram* program, int* alloc_size, int var, poly_exp_t exp) {
+  const int pos = PolyProgramPowerFind(program, var, exp);
+  if(pos < program->powers_size && program->powers[pos].var == var && program->powers[pos].exp == exp) {
+    return;
+  }
+  if(program->powers_size >= *alloc_size) {
+    *alloc_size = (*alloc_size < 4) ? 8 : *alloc_size * 2;
+    program->powers = MREALLOCATE_ARRAY(PolyProgramPower, *alloc_size, program->powers);
+  }
+  memmove(program->powers + pos + 1, program->powers + pos, (program->powers_size - pos) * sizeof(PolyProgramPower));
+  program->powers[pos] = (PolyProgramPower) { .var = var, .exp = exp };
+  ++(program->powers_size);
 }
 
 /*
-* Adds monos to create new polynomial.
+* Collects powers of variables used by Horner scheme
+* and counts an upper bound of number of steps
 */
-Poly PolyAddMonos(unsigned count, const Mono monos[]) {
-  Poly p = PolyFromCoeff(0);
-  for(unsigned int i=0;i<count;++i) {
-    PolyInsertMonoValue(&p, monos[i]);
-  };
-  return p;
+static int PolyProgramCollectRec(const Poly* p, int var, PolyProgram* program, int* alloc_size) {
+  int steps = 2;
+  for(int i=p->size-1;i>=0;--i) {
+    const poly_exp_t gap = p->monos[i].exp - ((i > 0) ? p->monos[i-1].exp : 0);
+    if(gap > 0) {
+      PolyProgramPowerAdd(program, alloc_size, var, gap);
+    }
+    steps += PolyProgramCollectRec(&(p->monos[i].p), var+1, program, alloc_size) + 2;
+  }
+  return steps;
 }
 
 /*
-* Multiply two polynomials
+* Appends step to the program. Steps which only modify the top of the stack
+* are merged with the previous step if possible.
 */
-Poly PolyMul(const Poly *p, const Poly *q) {
-  assert(p!=NULL);
-  assert(q!=NULL);
-
-  Poly result = PolyFromCoeff(0);
+static void PolyProgramEmit(PolyProgram* program, PolyProgramStep step) {
+  PolyProgramStep* last = (program->size > 0) ? &(program->steps[program->size-1]) : NULL;
+  if(last != NULL && step.op == POLY_PROGRAM_MUL_POW && last->op == POLY_PROGRAM_CONST) {
+    last->op = POLY_PROGRAM_CONST_POW;
+    last->arg = step.arg;
+    return;
+  }
+  if(last != NULL && step.op == POLY_PROGRAM_ADD_CONST && last->op == POLY_PROGRAM_MUL_POW) {
+    last->op = POLY_PROGRAM_MUL_POW_ADD_CONST;
+    last->c = step.c;
+    return;
+  }
+  program->steps[program->size++] = step;
+}
 
-  if(q->c != 0) {
-    LOOP_LIST(&(p->monos), pIter) {
-      Mono* partialResult = MonoClonePtr( (Mono*)ListGetValue(pIter) );
-      PolyScaleConst(&(partialResult->p), q->c);
-      PolyInsertMonoPtr(&result, partialResult);
+/*
+* Emits steps of Horner scheme evaluating polynomial
+* which pushes its value on the top of the stack
+*/
+static void PolyProgramEmitRec(const Poly* p, int var, int stack, PolyProgram* program) {
+  if(stack > program->depth) program->depth = stack;
+  if(p->size == 0) {
+    PolyProgramEmit(program, (PolyProgramStep) { .op = POLY_PROGRAM_CONST, .c = PolyCoeffClone(p->c) });
+    return;
+  }
+  for(int i=p->size-1;i>=0;--i) {
+    const Poly* child = &(p->monos[i].p);
+    const poly_exp_t gap = p->monos[i].exp - ((i > 0) ? p->monos[i-1].exp : 0);
+    if(i == p->size-1) {
+      PolyProgramEmitRec(child, var+1, stack, program);
+    } else if(child->size == 0) {
+      PolyProgramEmit(program, (PolyProgramStep) { .op = POLY_PROGRAM_ADD_CONST, .c = PolyCoeffClone(child->c) });
+    } else {
+      PolyProgramEmitRec(child, var+1, stack+1, program);
+      PolyProgramEmit(program, (PolyProgramStep) { .op = POLY_PROGRAM_ADD });
+    }
+    if(gap > 0) {
+      PolyProgramEmit(program, (PolyProgramStep) { .op = POLY_PROGRAM_MUL_POW,
+        .arg = PolyProgramPowerFind(program, var, gap) });
     }
   }
-
   if(p->c != 0) {
-    LOOP_LIST(&(q->monos), qIter) {
-      Mono* partialResult = MonoClonePtr( (Mono*)ListGetValue(qIter) );
-      PolyScaleConst(&(partialResult->p), p->c);
-      PolyInsertMonoPtr(&result, partialResult);
-    }
+    PolyProgramEmit(program, (PolyProgramStep) { .op = POLY_PROGRAM_ADD_CONST, .c = PolyCoeffClone(p->c) });
   }
+}
 
-  LOOP_LIST(&(p->monos), pIter) {
-    LOOP_LIST(&(q->monos), qIter) {
-      Mono* mp = (Mono*) ListGetValue(pIter);
-      Mono* mq = (Mono*) ListGetValue(qIter);
-      Poly factPartialResult = PolyMul(&(mp->p), &(mq->p));
-      Mono partialResult = MonoFromPoly(&factPartialResult, mp->exp + mq->exp);
-      PolyInsertMonoValue(&result, partialResult);
-    }
+/*
+* Compiles polynomial to evaluation program (see poly.h)
+*/
+PolyProgram PolyCompile(const Poly* p) {
+  assert(p!=NULL);
+  PolyProgram program = { .steps = NULL, .size = 0, .powers = NULL, .powers_size = 0, .depth = 1,
+    .bits = 0, .big_consts = false, .degree = PolyDeg(p) };
+  int powers_alloc_size = 0;
+  const int steps = PolyProgramCollectRec(p, 0, &program, &powers_alloc_size);
+  program.steps = MALLOCATE_ARRAY(PolyProgramStep, steps);
+  PolyProgramEmitRec(p, 0, 1, &program);
+
+  // Sum of absolute values of all the constants has at most that many bits
+  int bits_terms = 0;
+  while((1 << bits_terms) < program.size) ++bits_terms;
+  for(int s=0;s<program.size;++s) {
+    const int step_bits = PolyCoeffBits(program.steps[s].c);
+    if(step_bits > program.bits) program.bits = step_bits;
+    if(!PolyCoeffIsSmall(program.steps[s].c)) program.big_consts = true;
   }
-
-  result.c += q->c * p->c;
-  return result;
+  program.bits += bits_terms;
+  return program;
 }
 
 /*
-* Recursively negate polynomial
+* Frees the program
 */
-void PolyNegRec(Poly *p) {
-  p->c *= -1;
-  LOOP_LIST(&(p->monos), i) {
-    Mono* m = (Mono*) ListGetValue(i);
-    PolyNegRec(&(m->p));
+void PolyProgramDestroy(PolyProgram* program) {
+  assert(program!=NULL);
+  for(int s=0;s<program->size;++s) {
+    PolyCoeffDestroy(program->steps[s].c);
   }
+  free(program->steps);
+  free(program->powers);
+  program->steps = NULL;
+  program->powers = NULL;
+  program->size = 0;
+  program->powers_size = 0;
 }
 
 /*
-* Negate polynomial
+* Adds two values of @p i-th point of block (modulo @p mod if it's not NULL).
+* Without modulus the overflow is marked in @p overflow if it's not NULL
+* and otherwise values wrap around (the blocks are run this way only
+* if the values are known to be small, see PolyProgramBlockBits).
 */
-Poly PolyNeg(const Poly *p) {
-  Poly ret = PolyClone(p);
-  PolyNegRec(&ret);
-  return ret;
+static inline unsigned long PolyProgramAdd(const PolyCoeffModulus* mod, bool* restrict overflow, int i,
+  unsigned long a, unsigned long b) {
+  if(mod != NULL) return (unsigned long) PolyCoeffAddMod(mod, (poly_coeff_t) a, (poly_coeff_t) b);
+  if(overflow == NULL) return a + b;
+  long sum;
+  overflow[i] |= __builtin_add_overflow((long) a, (long) b, &sum);
+  return (unsigned long) sum;
 }
 
 /*
-* Substract two polynomials
+* Multiplies two values of @p i-th point of block (see PolyProgramAdd)
 */
-Poly PolySub(const Poly *p, const Poly *q) {
-  return PolyAddScaled(p, q, -1);
+static inline unsigned long PolyProgramMul(const PolyCoeffModulus* mod, bool* restrict overflow, int i,
+  unsigned long a, unsigned long b) {
+  if(mod != NULL) return (unsigned long) PolyCoeffMulMod(mod, (poly_coeff_t) a, (poly_coeff_t) b);
+  if(overflow == NULL) return a * b;
+  long product;
+  overflow[i] |= __builtin_mul_overflow((long) a, (long) b, &product);
+  return (unsigned long) product;
 }
 
 /*
-* Find degree of polynomial with respect to the given variable index.
-* Recursive helper.
+* Sets block of values to @p values times @p points to the power of @p exp
+* (@p values may be NULL meaning ones)
 */
-poly_exp_t PolyDegByRec(const Poly *p, unsigned var_idcur, unsigned var_idx,
-  int sum_all) {
-
-  poly_exp_t ret = -1;
-  if(p->c != 0) ret = 0;
-  LOOP_LIST(&(p->monos), i) {
-    Mono* m = (Mono*) ListGetValue(i);
-    poly_exp_t temp = PolyDegByRec(&(m->p), var_idcur+1, var_idx, sum_all);
-    if(var_idcur == var_idx || sum_all) {
-      temp += m->exp;
+static inline void PolyProgramBlockPow(const PolyCoeffModulus* mod, bool* restrict overflow, unsigned long* restrict result,
+  const unsigned long* restrict values, const unsigned long* restrict points, unsigned long* restrict base,
+  int count, poly_exp_t exp) {
+  for(int i=0;i<count;++i) result[i] = (values == NULL) ? 1 : values[i];
+  for(int i=0;i<count;++i) base[i] = points[i];
+  while(exp) {
+    if(exp & 1) {
+      for(int i=0;i<count;++i) result[i] = PolyProgramMul(mod, overflow, i, result[i], base[i]);
     }
-    if(temp > ret) {
-      ret = temp;
+    exp >>= 1;
+    if(exp) {
+      for(int i=0;i<count;++i) base[i] = PolyProgramMul(mod, overflow, i, base[i], base[i]);
     }
   }
-  return ret;
 }
 
 /*
-* Find degree of polynomial with respect to the given variable index.
+* Runs the program for block of at most POLY_EVAL_BATCH_BLOCK points
+* (modulo @p mod if it's not NULL, marking overflows in @p overflow if it's not NULL).
+* The @p scratch holds `program->depth + program->powers_size + 2` blocks.
 */
-poly_exp_t PolyDegBy(const Poly *p, unsigned var_idx) {
-  return PolyDegByRec(p, 0, var_idx, 0);
+static inline void PolyProgramRunBlock(const PolyProgram* program, const PolyCoeffModulus* mod, bool* restrict overflow,
+  const unsigned long* const* points, int count, unsigned long* restrict scratch, poly_coeff_t* results) {
+  unsigned long* restrict base = scratch;
+  unsigned long* restrict powers = scratch + POLY_EVAL_BATCH_BLOCK;
+  unsigned long* restrict stack = powers + POLY_EVAL_BATCH_BLOCK * program->powers_size;
+
+  // Every power is computed once from the previous power of the same variable
+  for(int k=0;k<program->powers_size;++k) {
+    const PolyProgramPower* power = &(program->powers[k]);
+    unsigned long* restrict result = powers + POLY_EVAL_BATCH_BLOCK * k;
+    if(power->exp == 1) {
+      for(int i=0;i<count;++i) result[i] = points[power->var][i];
+    } else if(k > 0 && program->powers[k-1].var == power->var) {
+      PolyProgramBlockPow(mod, overflow, result, result - POLY_EVAL_BATCH_BLOCK, points[power->var], base,
+        count, power->exp - program->powers[k-1].exp);
+    } else {
+      PolyProgramBlockPow(mod, overflow, result, NULL, points[power->var], base, count, power->exp);
+    }
+  }
+
+  unsigned long* restrict top = stack - POLY_EVAL_BATCH_BLOCK;
+  for(int s=0;s<program->size;++s) {
+    const PolyProgramStep* step = &(program->steps[s]);
+    const unsigned long c = (unsigned long) step->c;
+    const unsigned long* restrict power = powers + POLY_EVAL_BATCH_BLOCK * step->arg;
+    switch(step->op) {
+      case POLY_PROGRAM_CONST:
+        top += POLY_EVAL_BATCH_BLOCK;
+        for(int i=0;i<count;++i) top[i] = c;
+        break;
+      case POLY_PROGRAM_CONST_POW:
+        top += POLY_EVAL_BATCH_BLOCK;
+        for(int i=0;i<count;++i) top[i] = PolyProgramMul(mod, overflow, i, c, power[i]);
+        break;
+      case POLY_PROGRAM_ADD:
+        top -= POLY_EVAL_BATCH_BLOCK;
+        for(int i=0;i<count;++i) top[i] = PolyProgramAdd(mod, overflow, i, top[i], top[i + POLY_EVAL_BATCH_BLOCK]);
+        break;
+      case POLY_PROGRAM_ADD_CONST:
+        for(int i=0;i<count;++i) top[i] = PolyProgramAdd(mod, overflow, i, top[i], c);
+        break;
+      case POLY_PROGRAM_MUL_POW:
+        for(int i=0;i<count;++i) top[i] = PolyProgramMul(mod, overflow, i, top[i], power[i]);
+        break;
+      case POLY_PROGRAM_MUL_POW_ADD_CONST:
+        for(int i=0;i<count;++i) top[i] = PolyProgramAdd(mod, overflow, i, PolyProgramMul(mod, overflow, i, top[i], power[i]), c);
+        break;
+    }
+  }
+  assert(top == stack);
+  for(int i=0;i<count;++i) results[i] = (poly_coeff_t) stack[i];
 }
 
 /*
-* Find degree of polynomial assuming that all variables are equal.
+* Bounds number of bits of all the values computed by the program
+* for the block of points (or returns -1 if any point or constant
+* is not small, as the blocks use machine integers).
+* Every value is bounded by sum of absolute values of constants
+* times the largest absolute value of variable to the power of the degree.
 */
-poly_exp_t PolyDeg(const Poly *p) {
-  return PolyDegByRec(p, 0, 0, 1);
+static inline long long PolyProgramBlockBits(const PolyProgram* program,
+  const unsigned long* const* points, int program_vars, int count) {
+  if(program->big_consts) return -1;
+  int bits = 1;
+  for(int var=0;var<program_vars;++var) {
+    for(int i=0;i<count;++i) {
+      const poly_coeff_t x = (poly_coeff_t) points[var][i];
+      if(!PolyCoeffIsSmall(x)) return -1;
+      const int x_bits = PolyCoeffBits(x);
+      if(x_bits > bits) bits = x_bits;
+    }
+  }
+  // Powers of -1, 0 and 1 do not grow
+  const long long power_bits = (bits > 1) ? (long long) program->degree * bits : 0;
+  return program->bits + power_bits;
 }
 
 /*
-* Recursive equality test for polynomials
+* Evaluates @p i-th point of block exactly
 */
-bool PolyIsEqRec(const Poly *p, const Poly *q) {
-  if(p == q) return true;
-  if(p->c != q->c) {
-    return false;
+static inline poly_coeff_t PolyProgramEvalLane(const PolyProgram* program, const unsigned long* const* points,
+  int program_vars, int i, poly_coeff_t* values) {
+  for(int var=0;var<program_vars;++var) {
+    values[var] = (poly_coeff_t) points[var][i];
   }
+  return PolyProgramEval(program, program_vars, values);
+}
 
-  ListIterator iq = ListBegin(&(q->monos));
-  LOOP_LIST(&(p->monos), ip) {
-    Mono* mp = (Mono*) ListGetValue(ip);
-    Mono* mq = (Mono*) ListGetValue(iq);
-    if(mp!=mq) {
-      if((ip == NULL && iq != NULL) || (ip != NULL && iq == NULL)) {
-        return false;
+/*
+* Runs the program for many points (see poly.h)
+*/
+void PolyProgramRun(const PolyProgram* program, int vars, const poly_coeff_t* const* points,
+  int count, poly_coeff_t* results) {
+  assert(program!=NULL);
+  assert(vars >= 0);
+  assert(count >= 0);
+  assert(vars == 0 || points != NULL);
+  assert(count == 0 || results != NULL);
+
+  const int program_vars = (program->powers_size > 0) ? program->powers[program->powers_size-1].var + 1 : 0;
+  const int lanes = (program_vars > 0) ? program_vars : 1;
+  unsigned long* scratch = MALLOCATE_ARRAY(unsigned long,
+    POLY_EVAL_BATCH_BLOCK * (program->depth + program->powers_size + 2));
+  const unsigned long** block_points = MALLOCATE_ARRAY(const unsigned long*, lanes);
+
+  // Variables missing in the points are substituted with zeros
+  unsigned long* zeros = MALLOCATE_ARRAY(unsigned long, POLY_EVAL_BATCH_BLOCK);
+  memset(zeros, 0, POLY_EVAL_BATCH_BLOCK * sizeof(unsigned long));
+
+  // In modular arithmetic the points are reduced block by block
+  const bool modular = PolyCoeffIsModular();
+  const PolyCoeffModulus mod = PolyCoeffCurrentModulus;
+  unsigned long* reduced = modular ? MALLOCATE_ARRAY(unsigned long, POLY_EVAL_BATCH_BLOCK * lanes) : NULL;
+
+  // Blocks which may overflow are run with checked arithmetic
+  // and only the overflowed points are evaluated exactly
+  bool* overflow = MALLOCATE_ARRAY(bool, POLY_EVAL_BATCH_BLOCK);
+  poly_coeff_t* exact_values = MALLOCATE_ARRAY(poly_coeff_t, lanes);
+
+  for(int begin=0;begin<count;begin+=POLY_EVAL_BATCH_BLOCK) {
+    const int block = (count - begin < POLY_EVAL_BATCH_BLOCK) ? count - begin : POLY_EVAL_BATCH_BLOCK;
+    for(int var=0;var<program_vars;++var) {
+      block_points[var] = (var < vars) ? (const unsigned long*) (points[var] + begin) : zeros;
+    }
+    if(modular) {
+      for(int var=0;var<program_vars && var<vars;++var) {
+        unsigned long* values = reduced + POLY_EVAL_BATCH_BLOCK * var;
+        for(int i=0;i<block;++i) {
+          values[i] = (unsigned long) PolyCoeffReduceMod(&mod, points[var][begin + i]);
+        }
+        block_points[var] = values;
       }
-      if(mp->exp != mq->exp) {
-        return false;
+      PolyProgramRunBlock(program, &mod, NULL, block_points, block, scratch, results + begin);
+      continue;
+    }
+    const long long bits = PolyProgramBlockBits(program, block_points, program_vars, block);
+    if(bits < 0) {
+      for(int i=0;i<block;++i) {
+        results[begin + i] = PolyProgramEvalLane(program, block_points, program_vars, i, exact_values);
       }
-      if(!PolyIsEqRec(&(mp->p), &(mq->p))) {
-        return false;
+    } else if(bits <= 62) {
+      PolyProgramRunBlock(program, NULL, NULL, block_points, block, scratch, results + begin);
+    } else {
+      memset(overflow, 0, block * sizeof(bool));
+      PolyProgramRunBlock(program, NULL, overflow, block_points, block, scratch, results + begin);
+      for(int i=0;i<block;++i) {
+        if(overflow[i] || !PolyCoeffIsSmall(results[begin + i])) {
+          results[begin + i] = PolyProgramEvalLane(program, block_points, program_vars, i, exact_values);
+        }
       }
     }
-    iq = ListNext(iq);
   }
-  return true;
+
+  free(exact_values);
+  free(overflow);
+  free(reduced);
+  free(zeros);
+  free(block_points);
+  free(scratch);
 }
 
 /*
-* Equality test for polynomials
+* Runs the program for single point (see poly.h)
 */
-bool PolyIsEq(const Poly *p, const Poly *q) {
-  return PolyIsEqRec(p, q);
-}
-
-
-
-Poly PolyPow(const Poly* p, poly_exp_t exp) {
-  
-  if(exp == 0) return PolyFromCoeff(1);
-  if(exp == 1) return PolyClone(p);
-
-  if(PolyIsCoeff(p)) {
-    if(p->c == 0) return PolyZero();
-    if(p->c == 1) return PolyFromCoeff(1);
-    if(p->c == -1) {
-      if(exp % 2 == 0) return PolyFromCoeff(1);
-      return PolyFromCoeff(-1);
+poly_coeff_t PolyProgramEval(const PolyProgram* program, int vars, const poly_coeff_t* values) {
+  assert(program!=NULL);
+  assert(vars >= 0);
+  assert(vars == 0 || values != NULL);
+  poly_coeff_t* powers = MALLOCATE_ARRAY(poly_coeff_t, program->powers_size + program->depth);
+  poly_coeff_t* stack = powers + program->powers_size;
+
+  for(int k=0;k<program->powers_size;++k) {
+    const PolyProgramPower* power = &(program->powers[k]);
+    const poly_coeff_t x = (power->var < vars) ? PolyCoeffReduce(values[power->var]) : 0;
+    if(k > 0 && program->powers[k-1].var == power->var) {
+      const poly_coeff_t step = PolyCoeffPow(x, power->exp - program->powers[k-1].exp);
+      powers[k] = PolyCoeffMul(powers[k-1], step);
+      PolyCoeffDestroy(step);
+    } else {
+      powers[k] = PolyCoeffPow(x, power->exp);
     }
   }
 
-  Poly result = PolyFromCoeff(1);
-  Poly base = PolyClone(p);
-
-  while (exp) {
-    if (exp & 1) {
-      PolyReplace(&result, PolyMul(&result, &base));
+  poly_coeff_t* top = stack - 1;
+  for(int s=0;s<program->size;++s) {
+    const PolyProgramStep* step = &(program->steps[s]);
+    switch(step->op) {
+      case POLY_PROGRAM_CONST: *(++top) = PolyCoeffClone(step->c); break;
+      case POLY_PROGRAM_CONST_POW: *(++top) = PolyCoeffMul(step->c, powers[step->arg]); break;
+      case POLY_PROGRAM_ADD: --top; PolyCoeffReplace(top, PolyCoeffAdd(*top, top[1])); PolyCoeffDestroy(top[1]); break;
+      case POLY_PROGRAM_ADD_CONST: PolyCoeffReplace(top, PolyCoeffAdd(*top, step->c)); break;
+      case POLY_PROGRAM_MUL_POW: PolyCoeffReplace(top, PolyCoeffMul(*top, powers[step->arg])); break;
+      case POLY_PROGRAM_MUL_POW_ADD_CONST:
+        PolyCoeffReplace(top, PolyCoeffMul(*top, powers[step->arg]));
+        PolyCoeffReplace(top, PolyCoeffAdd(*top, step->c));
+        break;
     }
-    exp >>= 1;
-    PolyReplace(&base, PolyMul(&base, &base));
   }
-  PolyDestroy(&base);
-
+  assert(top == stack);
+  const poly_coeff_t result = *stack;
+  for(int k=0;k<program->powers_size;++k) {
+    PolyCoeffDestroy(powers[k]);
+  }
+  free(powers);
   return result;
 }
 
 /*
-* Evaluate polynomial at a given point
+* Evaluates polynomial at many points (see poly.h)
 */
-Poly PolyAt(const Poly *p, poly_coeff_t x) {
-
+poly_coeff_t* PolyEvalBatch(const Poly* p, int vars, const poly_coeff_t* const* points, int count) {
   assert(p!=NULL);
+  PolyProgram program = PolyCompile(p);
+  poly_coeff_t* results = MALLOCATE_ARRAY(poly_coeff_t, (count > 0) ? count : 1);
+  PolyProgramRun(&program, vars, points, count, results);
+  PolyProgramDestroy(&program);
+  return results;
+}
 
-  Poly result = PolyFromCoeff(0);
-  result.c += p->c;
+/*
+* Pairs of decimal digits used by PolyPrintFormatLong
+*/
+static const char POLY_PRINT_DIGIT_PAIRS[] =
+  "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+  "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+  "8081828384858687888990919293949596979899";
+
+/*
+* Formats integer in decimal to @p dest (without null terminator).
+* Digits are generated two at a time from the end.
+* Returns number of written characters (at most 20).
+*/
+static inline int PolyPrintFormatLong(char* dest, long value) {
+  char digits[24];
+  char* end = digits + sizeof(digits);
+  char* begin = end;
+  unsigned long magnitude = (value < 0) ? -(unsigned long) value : (unsigned long) value;
+  while(magnitude >= 100) {
+    const unsigned pair = (unsigned) (magnitude % 100);
+    magnitude /= 100;
+    begin -= 2;
+    memcpy(begin, POLY_PRINT_DIGIT_PAIRS + 2 * pair, 2);
+  }
+  if(magnitude >= 10) {
+    begin -= 2;
+    memcpy(begin, POLY_PRINT_DIGIT_PAIRS + 2 * magnitude, 2);
+  } else {
+    *(--begin) = (char) ('0' + magnitude);
+  }
+  if(value < 0) {
+    *(--begin) = '-';
+  }
+  memcpy(dest, begin, end - begin);
+  return (int) (end - begin);
+}
 
-  LOOP_LIST(&(p->monos), i) {
-    Mono* m = (Mono*) ListGetValue(i);
-    poly_coeff_t factValue = MathFastPowLong(x, m->exp);
+/*
+* State of polynomial printer.
+* Output is collected in chunk passed to the writer when full.
+* Prefix holds variables part of currently printed term (e.g. `a^2*b`),
+* it's extended when entering monomial and truncated when leaving it.
+*/
+typedef struct PolyPrinter {
+  PolyPrintWriter writer; ///< Function receiving the output
+  void* data; ///< Data passed to the writer
+  bool empty; ///< Nothing was printed yet
+  size_t out_size; ///< Number of characters in output chunk
+  char out[POLY_PRINT_CHUNK_SIZE]; ///< Output chunk
+  char* prefix; ///< Variables part of printed term
+  size_t prefix_size; ///< Length of prefix
+  size_t prefix_alloc; ///< Capacity of prefix
+  char prefix_local[POLY_PRINT_PREFIX_SIZE]; ///< Initial prefix buffer
+} PolyPrinter;
 
-    Poly partialResult = PolyClone(&(m->p));
-    PolyScaleConst(&partialResult, factValue);
-    result.c += partialResult.c;
-    partialResult.c = 0;
-    LOOP_LIST(&(partialResult.monos), j) {
-      Mono* submono = (Mono*) ListGetValue(j);
-      Poly pcln = PolyClone(&(submono->p));
-      Mono cln = MonoFromPoly(&pcln, submono->exp);
+/*
+* Passes collected output to the writer
+*/
+static inline void PolyPrinterFlush(PolyPrinter* printer) {
+  if(printer->out_size > 0) {
+    printer->writer(printer->data, printer->out, printer->out_size);
+    printer->out_size = 0;
+  }
+}
 
-      PolyInsertMonoValue(&result, cln);
+/*
+* Appends characters to the output
+*/
+static inline void PolyPrinterWrite(PolyPrinter* printer, const char* str, size_t length) {
+  if(printer->out_size + length > POLY_PRINT_CHUNK_SIZE) {
+    PolyPrinterFlush(printer);
+    if(length > POLY_PRINT_CHUNK_SIZE) {
+      printer->writer(printer->data, str, length);
+      return;
     }
-    PolyDestroy(&partialResult);
-
   }
+  memcpy(printer->out + printer->out_size, str, length);
+  printer->out_size += length;
+}
 
-  return result;
+/*
+* Makes sure that @p length characters can be appended to the prefix
+*/
+static inline void PolyPrinterPrefixReserve(PolyPrinter* printer, size_t length) {
+  if(printer->prefix_size + length <= printer->prefix_alloc) return;
+  size_t alloc = printer->prefix_alloc * 2;
+  if(alloc < printer->prefix_size + length) alloc = printer->prefix_size + length;
+  if(printer->prefix == printer->prefix_local) {
+    printer->prefix = MALLOCATE_ARRAY(char, alloc);
+    memcpy(printer->prefix, printer->prefix_local, printer->prefix_size);
+  } else {
+    printer->prefix = MREALLOCATE_ARRAY(char, alloc, printer->prefix);
+  }
+  printer->prefix_alloc = alloc;
 }
 
 /*
-* Translate variable index to its human readable form.
-* Helper function for PolyPrint function family.
+* Appends variable ^ exp to the prefix.
+* Variables are named a, b, ..., then with up to 3 letters
+* (digits of index in base 25, the least significant first).
 */
-char* PolyTranslateVarID(int varid) {
-  char* str = MALLOCATE_ARRAY(char, 3);
-  for(int i=0;i<3;++i) str[i]='\0';
+static inline void PolyPrinterPrefixPush(PolyPrinter* printer, int varid, poly_exp_t exp) {
+  if(exp == 0) return;
+  // "*" + name + "^" + exponent
+  PolyPrinterPrefixReserve(printer, 1 + 3 + 1 + 20);
+  char* dest = printer->prefix + printer->prefix_size;
+  if(printer->prefix_size > 0) {
+    *(dest++) = '*';
+  }
   for(int i=0;i<3;++i) {
-    str[i] = (varid % ('z'-'a')) + 'a';
+    *(dest++) = (char) ((varid % ('z'-'a')) + 'a');
     varid /= ('z'-'a');
     if(varid == 0) break;
   }
-  return str;
+  if(exp != 1) {
+    *(dest++) = '^';
+    dest += PolyPrintFormatLong(dest, exp);
+  }
+  printer->prefix_size = dest - printer->prefix;
 }
 
 /*
-* Prints variable ^ exp
-* to the given accumulators.
-* Helper function for PolyPrint function family.
+* Prints coefficient (the sign is printed by the caller)
 */
-void PolyPrintSingleExp(char** wordAccumulatorBeg, char** wordAccumulator,
-  int varid, poly_exp_t exp) {
-  char* varname = PolyTranslateVarID(varid);
-  if(exp == 0) {
-    //DO NOTHING
-  } else if(exp == 1) {
-    if(*wordAccumulatorBeg != *wordAccumulator) {
-      *wordAccumulator += sprintf(*wordAccumulator, "*");
-    }
-    *wordAccumulator += sprintf(*wordAccumulator, "%s", varname);
-  } else {
-    if(*wordAccumulatorBeg != *wordAccumulator) {
-      *wordAccumulator += sprintf(*wordAccumulator, "*");
-    }
-    *wordAccumulator += sprintf(*wordAccumulator, "%s^%d", varname, (int)exp);
+static inline void PolyPrinterWriteMagnitude(PolyPrinter* printer, poly_coeff_t c) {
+  if(PolyCoeffIsSmall(c)) {
+    char str[24];
+    PolyPrinterWrite(printer, str, PolyPrintFormatLong(str, (c < 0) ? -c : c));
+    return;
   }
-  free(varname);
+  const poly_coeff_t magnitude = (c < 0) ? PolyCoeffNegExact(c) : PolyCoeffClone(c);
+  // Every 3 bits take less than one decimal digit
+  char* str = MALLOCATE_ARRAY(char, PolyCoeffBits(magnitude) / 3 + 3);
+  PolyPrinterWrite(printer, str, PolyCoeffSprintf(str, magnitude));
+  free(str);
+  PolyCoeffDestroy(magnitude);
 }
 
 /*
-* Prints c * variable ^ exp
-* to the given accumulators.
-* Helper function for PolyPrint function family.
+* Prints term: coefficient @p c multiplied by the prefix.
+* Coefficient 1 is skipped (unless it's the first term).
 */
-void PolyPrintSingleWord(char** wordAccumulatorBeg, char** wordAccumulator,
-  int varid, poly_exp_t exp, poly_coeff_t coeffAccumulator) {
-
-  int wordBufferEmpty = (*wordAccumulatorBeg == *wordAccumulator);
-
-  if(coeffAccumulator == 0) {
-    // DO NOTHING
-  } else if(2 == 3) {
-    PolyPrintSingleExp(wordAccumulatorBeg, wordAccumulator, varid, exp);
-  } else if(coeffAccumulator < 0) {
-    if(!wordBufferEmpty) {
-      *wordAccumulator += sprintf(*wordAccumulator, " - ");
-    } else {
-      *wordAccumulator += sprintf(*wordAccumulator, "-");
-    }
-    if(coeffAccumulator != -1) {
-      *wordAccumulator += sprintf(*wordAccumulator, "%ld", -coeffAccumulator);
-    } else if(wordBufferEmpty) {
-      *wordAccumulator += sprintf(*wordAccumulator, "1");
+static void PolyPrinterWriteTerm(PolyPrinter* printer, poly_coeff_t c) {
+  const bool first = printer->empty;
+  printer->empty = false;
+  if(c < 0) {
+    PolyPrinterWrite(printer, first ? "-" : " - ", first ? 1 : 3);
+    if(c != -1) {
+      PolyPrinterWriteMagnitude(printer, c);
+    } else if(first) {
+      PolyPrinterWrite(printer, "1", 1);
     }
-    PolyPrintSingleExp(wordAccumulatorBeg, wordAccumulator, varid, exp);
   } else {
-
-    if(!wordBufferEmpty) {
-      *wordAccumulator += sprintf(*wordAccumulator, " + ");
+    if(!first) {
+      PolyPrinterWrite(printer, " + ", 3);
     }
-    if(coeffAccumulator != 1) {
-      *wordAccumulator += sprintf(*wordAccumulator, "%ld", coeffAccumulator);
-    } else if(wordBufferEmpty) {
-      *wordAccumulator += sprintf(*wordAccumulator, "1");
+    if(c != 1 || first) {
+      PolyPrinterWriteMagnitude(printer, c);
     }
-    PolyPrintSingleExp(wordAccumulatorBeg, wordAccumulator, varid, exp);
   }
+  PolyPrinterWrite(printer, printer->prefix, printer->prefix_size);
 }
 
 /*
-* Recursively prints polynomial human-readable representation to the given accumulator.
-* Helper function for PolyPrint function family.
+* Recursively prints polynomial of variable @p varid
 */
-void PolyPrintRec(char** accumulatorBeg, char** accumulator,
-  char** wordAccumulatorBeg, char** wordAccumulator,
-  poly_coeff_t coeffAccumulator, const Poly *p, int varid) {
-
-  if(p==NULL) return;
-
+static void PolyPrintRec(PolyPrinter* printer, const Poly* p, int varid) {
   if(PolyGetConstTerm(p) != 0) {
-    PolyPrintSingleWord( accumulatorBeg, accumulator,
-      varid, 0, PolyGetConstTerm(p) );
-    *accumulator += sprintf(*accumulator, "%s", *wordAccumulatorBeg);
+    PolyPrinterWriteTerm(printer, PolyGetConstTerm(p));
   }
+  LOOP_POLY(p, m) {
+    const size_t prefix_size = printer->prefix_size;
+    PolyPrinterPrefixPush(printer, varid, m->exp);
+    PolyPrintRec(printer, &(m->p), varid+1);
+    printer->prefix_size = prefix_size;
+  }
+}
 
-  LOOP_LIST(&(p->monos), i) {
-    const Mono* m = (Mono*) ListGetValue(i);
-    char* wordAccumulatorCp = MALLOCATE_ARRAY(char, POLY_TO_STRING_BUF_SIZE);
-    char* wordAccumulatorCpBegin = wordAccumulatorCp;
-    for(int i=0;i<POLY_TO_STRING_BUF_SIZE;++i) {
-      wordAccumulatorCpBegin[i] = (*wordAccumulatorBeg)[i];
-    }
+/*
+* Prints polynomial human-readable representation using the writer
+*/
+void PolyPrintTo(const Poly* p, PolyPrintWriter writer, void* data) {
+  assert(p!=NULL);
+  assert(writer!=NULL);
+  PolyPrinter printer;
+  printer.writer = writer;
+  printer.data = data;
+  printer.empty = true;
+  printer.out_size = 0;
+  printer.prefix = printer.prefix_local;
+  printer.prefix_size = 0;
+  printer.prefix_alloc = POLY_PRINT_PREFIX_SIZE;
+
+  PolyPrintRec(&printer, p, 0);
+  if(printer.empty) {
+    PolyPrinterWrite(&printer, "0", 1);
+  }
+  PolyPrinterFlush(&printer);
+  if(printer.prefix != printer.prefix_local) {
+    free(printer.prefix);
+  }
+}
 
-    wordAccumulatorCp += (*wordAccumulator-*wordAccumulatorBeg);
-    PolyPrintSingleExp(&wordAccumulatorCpBegin,
-      &wordAccumulatorCp, varid, m->exp);
+/*
+* Buffer written by PolySnprintf
+*/
+typedef struct PolyPrintBuffer {
+  char* dest; ///< Destination buffer
+  size_t size; ///< Size of destination buffer
+  size_t length; ///< Length of the whole output
+} PolyPrintBuffer;
 
-    PolyPrintRec(accumulatorBeg, accumulator, &wordAccumulatorCpBegin,
-      &wordAccumulatorCp, coeffAccumulator, &(m->p), varid+1);
+/*
+* Writer copying output to the fixed size buffer
+* (output not fitting in the buffer is only counted)
+*/
+static void PolyPrintBufferWriter(void* data, const char* str, size_t length) {
+  PolyPrintBuffer* buffer = data;
+  if(buffer->length + 1 < buffer->size) {
+    size_t copied = buffer->size - 1 - buffer->length;
+    if(copied > length) copied = length;
+    memcpy(buffer->dest + buffer->length, str, copied);
+  }
+  buffer->length += length;
+}
 
-    free(wordAccumulatorCpBegin);
+/*
+* Prints polynomial human-readable representation to the buffer of given size
+*/
+size_t PolySnprintf(char* dest, size_t size, const Poly *p) {
+  PolyPrintBuffer buffer = { .dest = dest, .size = size, .length = 0 };
+  PolyPrintTo(p, PolyPrintBufferWriter, &buffer);
+  if(size > 0) {
+    dest[(buffer.length < size) ? buffer.length : size - 1] = '\0';
   }
+  return buffer.length;
 }
 
 /*
 * Prints polynomial human-readable representation to the given buffer.
 */
 void PolySprintf(char* dest, const Poly *p) {
-   char* wordAccumulator = MALLOCATE_ARRAY(char, POLY_TO_STRING_BUF_SIZE);
-   char* wordAccumulatorBegin = wordAccumulator;
-
-   char* accumulator = dest;
-   char* accumulatorBegin = dest;
+  PolySnprintf(dest, SIZE_MAX, p);
+}
 
-   accumulator[0] = '\0';
-   wordAccumulator[0] = '\0';
+/*
+* Growable string written by PolyToString
+*/
+typedef struct PolyPrintString {
+  char* str; ///< Written string
+  size_t length; ///< Length of string
+  size_t alloc_size; ///< Capacity of string
+} PolyPrintString;
 
-   PolyPrintRec(&accumulatorBegin, &accumulator, &wordAccumulatorBegin,
-     &wordAccumulator, (poly_coeff_t)1, p, 0);
-   if(accumulatorBegin == accumulator) {
-     sprintf(accumulatorBegin, "0");
-   }
-   free(wordAccumulatorBegin);
+/*
+* Writer appending output to the growable string
+*/
+static void PolyPrintStringWriter(void* data, const char* str, size_t length) {
+  PolyPrintString* string = data;
+  if(string->length + length + 1 > string->alloc_size) {
+    size_t alloc_size = string->alloc_size * 2;
+    if(alloc_size < string->length + length + 1) alloc_size = string->length + length + 1;
+    string->str = MREALLOCATE_ARRAY(char, alloc_size, string->str);
+    string->alloc_size = alloc_size;
+  }
+  memcpy(string->str + string->length, str, length);
+  string->length += length;
 }
 
 /*
@@ -711,18 +2803,37 @@ void PolySprintf(char* dest, const Poly *p) {
 * Then returns pointer to that newly created buffer.
 */
 char* PolyToString(const Poly* p) {
-  char* str = MALLOCATE_ARRAY(char, POLY_TO_STRING_BUF_SIZE);
-  PolySprintf(str, p);
-  return str;
+  PolyPrintString string = { .str = MALLOCATE_ARRAY(char, 16), .length = 0, .alloc_size = 16 };
+  PolyPrintTo(p, PolyPrintStringWriter, &string);
+  string.str[string.length] = '\0';
+  return string.str;
+}
+
+/*
+* Writer printing output to the stdout
+*/
+static void PolyPrintStdoutWriter(void* data, const char* str, size_t length) {
+  (void) data;
+  printf("%.*s", (int) length, str);
 }
 
 /*
 * Prints polynomial human-readable representation to the stdout.
 */
 void PolyPrint(const Poly* p) {
-  char* str = PolyToString(p);
-  printf("%s", str);
-  free(str);
+  PolyPrintTo(p, PolyPrintStdoutWriter, NULL);
+}
+
+/*
+* Counts variables of polynomial (its nesting depth)
+*/
+static unsigned PolyVarsCountRec(const Poly *p) {
+  unsigned result = 0;
+  LOOP_POLY(p, m) {
+    const unsigned vars = PolyVarsCountRec(&(m->p)) + 1;
+    if(vars > result) result = vars;
+  }
+  return result;
 }
 
 /*
@@ -731,35 +2842,259 @@ void PolyPrint(const Poly* p) {
 * The index is number of currently substituted variable
 * (index in list x which is considered)
 * as the list is parsed from left to right (indexing from 0).
+* The level is evaluated with Horner's rule going from the highest exponent:
+* the accumulator is multiplied by x[index] to the power of the gap between
+* consecutive exponents. Powers of substituted polynomials are taken
+* from @p caches (the caches are created on the first use).
 */
-Poly PolyComposeRec(const Poly *p, unsigned count, unsigned index, const Poly x[]) {
+Poly PolyComposeRec(const Poly *p, unsigned count, unsigned index, const Poly x[],
+  PolyPowCache caches[]) {
 
   if(PolyIsCoeff(p)) return PolyClone(p);
   if(count == 0) return PolyClone(p);
   if(index>=count) return PolyZero();
 
-  Poly result = PolyZero();
-
-  LOOP_LIST(&(p->monos), i) {
-    Mono* m = (Mono*) ListGetValue(i);
+  if(caches[index].squares_count == 0) {
+    caches[index] = PolyPowCacheNew(&x[index]);
+  }
 
-    Poly partial_result = PolyComposeRec(&(m->p), count, index+1, x);
-    Poly pow_result = PolyPow(&x[index], m->exp);
-    PolyReplace(&partial_result, PolyMul(&partial_result, &pow_result));
-    PolyDestroy(&pow_result);
+  Poly result = PolyZero();
 
-    PolyReplace(&result, PolyAdd(&result, &partial_result));
-    PolyDestroy(&partial_result);
+  for(int i=p->size-1;i>=0;--i) {
+    const Mono* m = &(p->monos[i]);
+    Poly partial_result = PolyComposeRec(&(m->p), count, index+1, x, caches);
+    PolyAddTakeInPlace(&result, &partial_result);
+    const poly_exp_t gap = m->exp - ((i > 0) ? p->monos[i-1].exp : 0);
+    if(gap > 0 && !PolyIsZero(&result)) {
+      Poly pow_result = PolyPowCached(&caches[index], gap);
+      PolyMulTakeInPlace(&result, &pow_result);
+    }
   }
 
-  result.c += p->c;
+  PolyCoeffReplace(&(result.c), PolyCoeffAdd(result.c, p->c));
   return result;
 }
 
 
+
+/*
+* Creates (empty) caches of powers for composition of polynomial @p p
+* substituted from variable @p index
+*/
+static PolyPowCache* PolyComposeCachesNew(const Poly *p, unsigned count, unsigned index, unsigned* length) {
+  const unsigned vars = index + PolyVarsCountRec(p);
+  *length = (vars < count) ? vars : count;
+  if(*length == 0) return NULL;
+  return MALLOCATE_ARRAY(PolyPowCache, *length);
+}
+
+/*
+* Destroys caches created by PolyComposeCachesNew
+*/
+static void PolyComposeCachesDestroy(PolyPowCache* caches, unsigned length) {
+  for(unsigned i=0;i<length;++i) {
+    if(caches[i].squares_count > 0) {
+      PolyPowCacheDestroy(&caches[i]);
+    }
+  }
+  free(caches);
+}
+
 /*
 * Compose given polynomials to one polynomial.
 */
 Poly PolyCompose(const Poly *p, unsigned count, const Poly x[]) {
-  return PolyComposeRec(p, count, 0, x);
+  if(count == 0 || PolyIsCoeff(p)) return PolyClone(p);
+  // Only variables present in p are substituted
+  unsigned length = 0;
+  PolyPowCache* caches = PolyComposeCachesNew(p, count, 0, &length);
+  Poly result = PolyComposeRec(p, count, 0, x, caches);
+  PolyComposeCachesDestroy(caches, length);
+  return result;
+}
+
+/*
+* Composition of range of monomials of single level
+* executed as a task of the thread pool
+*/
+typedef struct PolyComposeTask {
+  const Poly* p; ///< Composed level
+  unsigned count; ///< Length of substitution list
+  unsigned index; ///< Index of variable of the level
+  const Poly* x; ///< Substitution list
+  PolyPowCache* caches; ///< Prepared caches of powers shared by all tasks
+  ThreadPool* pool; ///< Pool executing the task
+  int begin; ///< Index of the first monomial of the range
+  int end; ///< Index after the last monomial of the range
+  Poly result; ///< Composed range
+} PolyComposeTask;
+
+/*
+* Preparation of cache of powers of single substituted variable
+* executed as a task of the thread pool
+*/
+typedef struct PolyComposeLadderTask {
+  const Poly* p; ///< Composed polynomial
+  unsigned index; ///< Index of the variable
+  PolyPowCache* cache; ///< Cache of powers of the variable
+  ThreadPool* pool; ///< Pool composing the polynomial
+} PolyComposeLadderTask;
+
+/*
+* Gets number of ranges the level is split into when composed in parallel
+* (zero when the level is too small to be split)
+*/
+static int PolyComposeRanges(const Poly *p, ThreadPool* pool) {
+  const int threads = ThreadPoolThreads(pool);
+  if(p->size < threads * POLY_COMPOSE_PARALLEL_THRESHOLD) return 0;
+  // Few ranges per thread balance the load
+  const int ranges = 2 * threads;
+  return (ranges > p->size) ? p->size : ranges;
+}
+
+/*
+* Gets index of the first monomial of the given range of the level
+*/
+static inline int PolyComposeRangeBegin(const Poly *p, int range, int ranges) {
+  return (int)((long long)(p->size) * range / ranges);
+}
+
+/*
+* Puts power of the variable in the cache (powers computed without
+* the cache are skipped)
+*/
+static void PolyComposeLadderPower(PolyPowCache* cache, poly_exp_t exp) {
+  if(exp <= 1 || PolyIsCoeff(&(cache->squares[0]))) return;
+  Poly power = PolyPowCached(cache, exp);
+  PolyDestroy(&power);
+}
+
+/*
+* Puts in the cache all powers of variable @p index used when composing
+* polynomial @p p of variable @p depth. Levels split into ranges
+* (only when all enclosing levels are split) also need the full powers
+* at the beginnings of the ranges.
+*/
+static void PolyComposeLadderRec(const Poly *p, unsigned depth, unsigned index,
+  PolyPowCache* cache, ThreadPool* pool, bool parallel) {
+
+  if(PolyIsCoeff(p)) return;
+  const int ranges = parallel ? PolyComposeRanges(p, pool) : 0;
+  if(depth < index) {
+    LOOP_POLY(p, m) {
+      PolyComposeLadderRec(&(m->p), depth+1, index, cache, pool, ranges > 0);
+    }
+    return;
+  }
+
+  for(int i=0;i<p->size;++i) {
+    PolyComposeLadderPower(cache, p->monos[i].exp - ((i > 0) ? p->monos[i-1].exp : 0));
+  }
+  for(int i=1;i<ranges;++i) {
+    PolyComposeLadderPower(cache, p->monos[PolyComposeRangeBegin(p, i, ranges)].exp);
+  }
+}
+
+/*
+* Fills cache of powers of single variable
+*/
+static void PolyComposeLadderTaskRun(void* arg) {
+  PolyComposeLadderTask* task = arg;
+  PolyComposeLadderRec(task->p, 0, task->index, task->cache, task->pool, true);
+}
+
+static Poly PolyComposeParallelRec(const Poly *p, unsigned count, unsigned index, const Poly x[],
+  PolyPowCache caches[], ThreadPool* pool);
+
+/*
+* Composes range of monomials with Horner's rule (see PolyComposeRec).
+* Sub-polynomials big enough to be split are composed in parallel.
+* The caches are only read as they already contain all needed powers.
+*/
+static void PolyComposeRangeTask(void* arg) {
+  PolyComposeTask* task = arg;
+  const Poly* p = task->p;
+  PolyPowCache* caches = task->caches;
+
+  Poly result = PolyZero();
+  for(int i=task->end-1;i>=task->begin;--i) {
+    const Mono* m = &(p->monos[i]);
+    Poly partial_result = (PolyComposeRanges(&(m->p), task->pool) > 0)
+      ? PolyComposeParallelRec(&(m->p), task->count, task->index+1, task->x, caches, task->pool)
+      : PolyComposeRec(&(m->p), task->count, task->index+1, task->x, caches);
+    PolyAddTakeInPlace(&result, &partial_result);
+    const poly_exp_t gap = m->exp - ((i > task->begin) ? p->monos[i-1].exp : 0);
+    if(gap > 0 && !PolyIsZero(&result)) {
+      Poly pow_result = PolyPowCached(&caches[task->index], gap);
+      PolyMulTakeInPlace(&result, &pow_result);
+    }
+  }
+
+  task->result = result;
+}
+
+/*
+* Composes polynomial splitting its level into ranges of monomials
+* composed in parallel. The caches of powers are prepared
+* by PolyComposeParallel and shared (read-only) by all ranges.
+*/
+static Poly PolyComposeParallelRec(const Poly *p, unsigned count, unsigned index, const Poly x[],
+  PolyPowCache caches[], ThreadPool* pool) {
+
+  if(PolyIsCoeff(p)) return PolyClone(p);
+  if(index>=count) return PolyZero();
+  const int ranges = PolyComposeRanges(p, pool);
+  if(ranges == 0) return PolyComposeRec(p, count, index, x, caches);
+
+  PolyComposeTask* tasks = MALLOCATE_ARRAY(PolyComposeTask, ranges);
+  Poly* results = MALLOCATE_ARRAY(Poly, ranges);
+  ThreadPoolGroup group = ThreadPoolGroupNew();
+  for(int i=0;i<ranges;++i) {
+    tasks[i] = (PolyComposeTask) {
+      .p = p, .count = count, .index = index, .x = x, .caches = caches, .pool = pool,
+      .begin = PolyComposeRangeBegin(p, i, ranges),
+      .end = PolyComposeRangeBegin(p, i+1, ranges),
+      .result = PolyZero()
+    };
+    ThreadPoolSubmit(pool, &group, PolyComposeRangeTask, &tasks[i]);
+  }
+  ThreadPoolWait(pool, &group);
+
+  for(int i=0;i<ranges;++i) {
+    results[i] = tasks[i].result;
+  }
+  free(tasks);
+  PolySumParallel(results, ranges, pool);
+  Poly result = results[0];
+  free(results);
+
+  PolyCoeffReplace(&(result.c), PolyCoeffAdd(result.c, p->c));
+  return result;
+}
+
+/*
+* Compose given polynomials to one polynomial using the thread pool.
+* Caches of powers of all variables are filled once (one task per variable)
+* before the ranges are composed, so that the ranges can share them.
+*/
+Poly PolyComposeParallel(const Poly *p, unsigned count, const Poly x[], ThreadPool* pool) {
+  if(pool == NULL) return PolyCompose(p, count, x);
+  if(count == 0 || PolyIsCoeff(p)) return PolyClone(p);
+  if(PolyComposeRanges(p, pool) == 0) return PolyCompose(p, count, x);
+
+  unsigned length = 0;
+  PolyPowCache* caches = PolyComposeCachesNew(p, count, 0, &length);
+  PolyComposeLadderTask* ladders = MALLOCATE_ARRAY(PolyComposeLadderTask, length);
+  ThreadPoolGroup group = ThreadPoolGroupNew();
+  for(unsigned i=0;i<length;++i) {
+    caches[i] = PolyPowCacheNew(&x[i]);
+    ladders[i] = (PolyComposeLadderTask) { .p = p, .index = i, .cache = &caches[i], .pool = pool };
+    ThreadPoolSubmit(pool, &group, PolyComposeLadderTaskRun, &ladders[i]);
+  }
+  ThreadPoolWait(pool, &group);
+  free(ladders);
+
+  Poly result = PolyComposeParallelRec(p, count, 0, x, caches, pool);
+  PolyComposeCachesDestroy(caches, length);
+  return result;
 }
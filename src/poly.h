@@ -16,15 +16,144 @@
 #include <stdlib.h>
 #include <stdarg.h>
 #include "memalloc.h"
-#include "dynamic_lists.h"
+#include "thread_pool.h"
+#include "poly_coeff.h"
 
 /**
-* @def POLY_TO_STRING_BUF_SIZE
+* @def POLY_PRINT_CHUNK_SIZE
 *
-* Maximum length of polynomial string representation
-* Used for buffer creation in PolyToStrnig family functions.
+* Size of chunk of output collected by printer (see PolyPrintTo)
+* before it's passed to the writer.
 */
-#define POLY_TO_STRING_BUF_SIZE 700
+#ifndef POLY_PRINT_CHUNK_SIZE
+#define POLY_PRINT_CHUNK_SIZE 4096
+#endif
+
+/**
+* @def POLY_PRINT_PREFIX_SIZE
+*
+* Initial capacity of variables part of printed term (on the stack).
+* Longer ones are moved to the heap.
+*/
+#ifndef POLY_PRINT_PREFIX_SIZE
+#define POLY_PRINT_PREFIX_SIZE 256
+#endif
+
+/**
+* @def POLY_MUL_DENSE_RATIO
+*
+* Level of polynomial is considered dense when at least
+* 1/POLY_MUL_DENSE_RATIO of exponents 0..deg have nonzero terms.
+* Products of two dense levels are computed using dense algorithms.
+*/
+#ifndef POLY_MUL_DENSE_RATIO
+#define POLY_MUL_DENSE_RATIO 2
+#endif
+
+/**
+* @def POLY_MUL_KARATSUBA_THRESHOLD
+*
+* Minimal length of dense operands multiplied using Karatsuba algorithm.
+* Shorter ones are multiplied term by term.
+*/
+#ifndef POLY_MUL_KARATSUBA_THRESHOLD
+#define POLY_MUL_KARATSUBA_THRESHOLD 32
+#endif
+
+/**
+* @def POLY_MUL_TOOM3_THRESHOLD
+*
+* Minimal length of dense operands multiplied using Toom-3 algorithm.
+*/
+#ifndef POLY_MUL_TOOM3_THRESHOLD
+#define POLY_MUL_TOOM3_THRESHOLD 256
+#endif
+
+/**
+* @def POLY_MUL_NTT_THRESHOLD
+*
+* Minimal length of dense operands with constant coefficients
+* multiplied using number theoretic transform (see ntt.h).
+*/
+#ifndef POLY_MUL_NTT_THRESHOLD
+#define POLY_MUL_NTT_THRESHOLD 128
+#endif
+
+/**
+* @def POLY_MUL_KRONECKER_THRESHOLD
+*
+* Minimal number of term products of multivariate operands
+* multiplied using Kronecker substitution.
+*/
+#ifndef POLY_MUL_KRONECKER_THRESHOLD
+#define POLY_MUL_KRONECKER_THRESHOLD 4096
+#endif
+
+/**
+* @def POLY_MUL_KRONECKER_RATIO
+*
+* Kronecker substitution is used only if number of term products
+* is at least POLY_MUL_KRONECKER_RATIO times greater than
+* the length of packed polynomial.
+*/
+#ifndef POLY_MUL_KRONECKER_RATIO
+#define POLY_MUL_KRONECKER_RATIO 16
+#endif
+
+/**
+* @def POLY_MUL_KRONECKER_MAX_LENGTH
+*
+* Maximum length of univariate polynomial created
+* by Kronecker substitution.
+*/
+#ifndef POLY_MUL_KRONECKER_MAX_LENGTH
+#define POLY_MUL_KRONECKER_MAX_LENGTH (1 << 24)
+#endif
+
+/**
+* @def POLY_MUL_KRONECKER_MAX_VARS
+*
+* Maximum number of variables of polynomials
+* multiplied using Kronecker substitution.
+*/
+#define POLY_MUL_KRONECKER_MAX_VARS 16
+
+/**
+* @def POLY_COMPOSE_PARALLEL_THRESHOLD
+*
+* Minimum number of monomials of polynomial level per thread of the pool
+* for the level to be split into ranges composed in parallel
+* by PolyComposeParallel.
+*/
+#ifndef POLY_COMPOSE_PARALLEL_THRESHOLD
+#define POLY_COMPOSE_PARALLEL_THRESHOLD 64
+#endif
+
+/**
+* @def POLY_MUL_PARALLEL_THRESHOLD
+*
+* Minimum number of pairs of monomials (on all levels)
+* multiplied in parallel by PolyMulParallel.
+*/
+#ifndef POLY_MUL_PARALLEL_THRESHOLD
+#define POLY_MUL_PARALLEL_THRESHOLD 16384
+#endif
+
+/**
+* @def POLY_EVAL_BATCH_BLOCK
+*
+* Number of points evaluated together by PolyProgramRun.
+*/
+#ifndef POLY_EVAL_BATCH_BLOCK
+#define POLY_EVAL_BATCH_BLOCK 64
+#endif
+
+/**
+* @def POLY_INTERN_TABLE_INITIAL_SIZE
+*
+* Initial capacity of hash-consing table (must be power of 2).
+*/
+#define POLY_INTERN_TABLE_INITIAL_SIZE 64
 
 /**
 * @def PolyC
@@ -138,22 +267,59 @@
 */
 #define PolyL(...) ((Poly[]){__VA_ARGS__})
 
+/**
+* @def LOOP_POLY(POLY, VAR_NAME)
+* Macro for interating through monomials of polynomial
+* (from the lowest exponent to the highest one)
+*
+* Usage:
+*
+* @code
+*   LOOP_POLY(&p, i) {
+*         printf("exp = %d\n", i->exp);
+*    }
+* @endcode
+*
+* @param[in] POLY     : Pointer to polynomial to be iterated
+* @param[in] VAR_NAME : name of iterator variable (PolyIterator)
+*/
+#define LOOP_POLY(POLY, VAR_NAME) \
+  for(PolyIterator VAR_NAME = PolyBegin(POLY); \
+  VAR_NAME != PolyEnd(POLY); ++VAR_NAME)
 
 
-/** Type of polynomial coefficients */
-typedef long poly_coeff_t;
-
 /** Type of polynomial exponents */
 typedef int poly_exp_t;
 
+/** Type of monomial */
+typedef struct Mono Mono;
+
 /**
 * Representation of polynomial
 * All polynomials are build from their constant term
-* and list of monomials (of variable powers higher than 0)
+* and array of monomials (of variable powers higher than 0).
+*
+* Monomials are stored inline in one array sorted by rising exponents.
+* There are no two monomials with the same exponent and no monomials
+* with zero coefficient.
+* The constant term of the whole polynomial is always kept in @p c
+* (monomial with exponent 0 may exist only if its coefficient is not const
+* and then its own constant term is equal to 0).
+*
+* Heap allocated arrays are reference counted and shared between
+* copies of the polynomial (see PolyClone). Shared array is immutable -
+* all the operations copy it before modification (copy-on-write).
+*
+* Non-empty array with @p alloc_size equal to 0 is not owned by
+* the polynomial (it lives in MemArena - see PolyCloneToArena).
+* Such array and all the arrays of its sub-polynomials are never freed
+* by PolyDestroy.
 */
 typedef struct Poly {
   poly_coeff_t c; ///< Constant (free) term of polynomial
-  List monos; ///< Dynamically allocated list of monomials
+  Mono* monos; ///< Dynamically allocated array of monomials
+  int size; ///< Number of monomials in @p monos array
+  int alloc_size; ///< Allocation size of @p monos array (capacity)
 } Poly;
 
 /**
@@ -162,10 +328,10 @@ typedef struct Poly {
 * Coefficient `p` is a polynomial.
 * It's understood as a polynomial of another variable (not x).
 */
-typedef struct Mono {
+struct Mono {
   Poly p; ///< monomial coefficient
   poly_exp_t exp; ///< exponent of variable
-} Mono;
+};
 
 /** Iterator for iterating through monos of poly **/
 typedef Mono* PolyIterator;
@@ -187,12 +353,14 @@ typedef void (*PolyMonosInterator)(int index, Mono mono);
 
 /**
 * Creates a new const polynomial.
+* The polynomial takes ownership of @p c (numbers out of
+* the small range must be created with PolyCoeffFromLong).
 *
 * @param[in] c : const value of polynomial
 * @return polynomial
 */
 static inline Poly PolyFromCoeff(poly_coeff_t c) {
-  return (Poly){ .c = c, .monos = ListNew() };
+  return (Poly){ .c = c, .monos = NULL, .size = 0, .alloc_size = 0 };
 }
 
 /**
@@ -202,7 +370,7 @@ static inline Poly PolyFromCoeff(poly_coeff_t c) {
 * @return zero polynomial
 */
 static inline Poly PolyZero() {
-  return (Poly){ .c = 0, .monos = ListNew() };
+  return PolyFromCoeff(0);
 }
 
 /**
@@ -230,6 +398,37 @@ static inline Mono MonoFromPoly(const Poly *p, poly_exp_t e) {
     return (Mono) { .exp = e, .p = *p };
 }
 
+/**
+* Obtain iterator pointing to the first monomial of polynomial.
+*
+* @param[in] p : polynomial
+* @return PolyIterator
+*/
+static inline PolyIterator PolyBegin(const Poly *p) {
+  return p->monos;
+}
+
+/**
+* Obtain iterator pointing right after the last monomial of polynomial.
+*
+* @param[in] p : polynomial
+* @return PolyIterator
+*/
+static inline PolyIterator PolyEnd(const Poly *p) {
+  return p->monos + p->size;
+}
+
+/**
+* Obtain number of monomials stored in polynomial
+* (the constant term is not counted).
+*
+* @param[in] p : polynomial
+* @return number of monomials
+*/
+static inline int PolyMonosCount(const Poly *p) {
+  return p->size;
+}
+
 /**
 * Iterates over all monomials included in the given polynomial.
 *
@@ -248,8 +447,7 @@ static inline void PolyIterateMonos(Poly* p, PolyMonosInterator iterator) {
     iterator(j, (Mono){ .exp = 0, .p = PolyFromCoeff(p->c) });
     ++j;
   }
-  LOOP_LIST(&(p->monos), i) {
-    Mono* m = (Mono*) ListGetValue(i);
+  LOOP_POLY(p, m) {
     iterator(j, *m);
     ++j;
   }
@@ -264,7 +462,7 @@ static inline void PolyIterateMonos(Poly* p, PolyMonosInterator iterator) {
 */
 static inline bool PolyIsCoeff(const Poly *p) {
   assert(p != NULL);
-  return ListEmpty(&(p->monos));
+  return p->size == 0;
 }
 
 /**
@@ -354,7 +552,10 @@ static inline void PolyReplace(Poly* p, Poly newValue) {
 }
 
 /**
-* Performs deep-copy of a given polynomial.
+* Copies a given polynomial.
+* The copy shares monomials array with @p p (it's O(1) operation)
+* and the array is copied only when one of them is modified.
+* Polynomials allocated in arena are deep-copied to the heap.
 *
 * @param[in] p : polynomial
 * @return copy of a given polynomial
@@ -362,7 +563,100 @@ static inline void PolyReplace(Poly* p, Poly newValue) {
 Poly PolyClone(const Poly *p);
 
 /**
-* Performs deep-copy of a given monomial
+* Performs deep-copy of a given polynomial placing all of its monomials
+* (on every nesting level) in the memory arena @p arena.
+* The whole copy is taken from the arena as one bulk allocation.
+*
+* Such polynomial can be used as any other one, but:
+*   - PolyDestroy on it is O(1) (nothing is freed)
+*   - the memory is released all at once by MemArenaDestroy
+*     so the arena MUST outlive the polynomial
+*   - levels modified by insertion are transparently moved to the heap
+*     (so PolyDestroy is still needed for polynomials that were modified)
+*
+* Example:
+* @code
+*    MemArena arena = MemArenaNew();
+*    Poly p = PolyP( PolyP( PolyC(1), 2 ), 3 );
+*    Poly q = PolyCloneToArena(&p, &arena);
+*    PolyDestroy(&p);
+*
+*    // ... use q ...
+*
+*    PolyDestroy(&q);         // O(1)
+*    MemArenaDestroy(&arena); // Releases q memory
+* @endcode
+*
+* @param[in] p     : polynomial
+* @param[in] arena : memory arena
+* @return copy of a given polynomial
+*/
+Poly PolyCloneToArena(const Poly *p, MemArena* arena);
+
+/**
+* Entry of hash-consing table (single interned level of polynomial)
+*/
+typedef struct PolyInternEntry {
+  Poly level; ///< Interned level (empty if the slot is free)
+  size_t hash; ///< Hash of the level
+} PolyInternEntry;
+
+/**
+* Hash-consing table of polynomials.
+* It holds unique copies of all the polynomial levels interned so far
+* (so they are kept alive until the table is destroyed).
+*/
+typedef struct PolyInternTable {
+  PolyInternEntry* entries; ///< Open addressing hash table
+  int size; ///< Number of interned levels
+  int alloc_size; ///< Capacity of @p entries array
+} PolyInternTable;
+
+/**
+* Creates empty hash-consing table.
+*
+* @return PolyInternTable
+*/
+PolyInternTable PolyInternTableNew(void);
+
+/**
+* Destroys hash-consing table.
+* Interned polynomials stay valid (they hold their own references).
+*
+* @param[in] table : hash-consing table
+*/
+void PolyInternTableDestroy(PolyInternTable* table);
+
+/**
+* Hash-conses polynomial: replaces its arrays (on every nesting level)
+* with the equal ones already interned in the @p table.
+* After that identical subtrees of all the interned polynomials are shared
+* and comparing them with PolyIsEq is O(1).
+*
+* Example:
+* @code
+*    PolyInternTable table = PolyInternTableNew();
+*    Poly p = PolyP( PolyP( PolyC(1), 2 ), 3 );
+*    Poly q = PolyP( PolyP( PolyC(1), 2 ), 3 );
+*    PolyIntern(&p, &table);
+*    PolyIntern(&q, &table);
+*
+*    // p.monos == q.monos
+*
+*    PolyDestroy(&p);
+*    PolyDestroy(&q);
+*    PolyInternTableDestroy(&table);
+* @endcode
+*
+* Polynomials allocated in arena are not interned.
+*
+* @param[in] p     : polynomial
+* @param[in] table : hash-consing table
+*/
+void PolyIntern(Poly* p, PolyInternTable* table);
+
+/**
+* Performs copy of a given monomial (see PolyClone)
 *
 * @param[in] m : monomial
 * @return copy of a given monomial
@@ -382,9 +676,66 @@ static inline Mono MonoClone(const Mono *m) {
 */
 Poly PolyAdd(const Poly *p, const Poly *q);
 
+/**
+* Adds polynomial @p q to @p p in place (`p += q`).
+* Monomials of @p p that have no counterpart in @p q are reused
+* (not copied). @p q is not modified.
+*
+* Example:
+* @code
+*   Poly sum = PolyZero();
+*   for(int i=0;i<count;++i) {
+*     PolyAddInPlace(&sum, &parts[i]);
+*   }
+* @endcode
+*
+* @param[in,out] p : polynomial
+* @param[in]     q : polynomial
+*/
+void PolyAddInPlace(Poly *p, const Poly *q);
+
+/**
+* Adds polynomial @p q scaled by constant @p c to @p p in place
+* (`p += c * q`).
+* @p q is not modified.
+*
+* @param[in,out] p : polynomial
+* @param[in]     q : polynomial
+* @param[in]     c : scale of @p q
+*/
+void PolyAddScaledInPlace(Poly *p, const Poly *q, const poly_coeff_t c);
+
+/**
+* Adds polynomial @p q to @p p in place taking ownership of @p q data
+* (`p += q`). No monomials are copied.
+* After the call @p q is a zero polynomial.
+*
+* Example:
+* @code
+*   Poly part = PolyMul(&a, &b);
+*   PolyAddTakeInPlace(&sum, &part); // part is now 0
+* @endcode
+*
+* @param[in,out] p : polynomial
+* @param[in,out] q : polynomial (captured)
+*/
+void PolyAddTakeInPlace(Poly *p, Poly *q);
+
+/**
+* Adds product of polynomials @p q and @p r to @p p in place
+* (`p += q * r`).
+* @p q and @p r are not modified.
+*
+* @param[in,out] p : polynomial
+* @param[in]     q : polynomial
+* @param[in]     r : polynomial
+*/
+void PolyMulAddInPlace(Poly *p, const Poly *q, const Poly *r);
+
 /**
 * Sums array of monomials of size @p count.
 * Captures data pointed by @p monos array.
+* The monomials are summed with PolyBuilder.
 *
 * Note: Capturing data means that you cannot now
 *       reference/access objects of @p monos
@@ -398,6 +749,72 @@ Poly PolyAdd(const Poly *p, const Poly *q);
 */
 Poly PolyAddMonos(unsigned count, const Mono monos[]);
 
+/**
+* @def POLY_BUILDER_RADIX_THRESHOLD
+*
+* Minimal number of monomials collected by PolyBuilder
+* sorted with radix sort (fewer ones are sorted by insertion)
+*/
+#ifndef POLY_BUILDER_RADIX_THRESHOLD
+#define POLY_BUILDER_RADIX_THRESHOLD 64
+#endif
+
+/**
+* Builder of polynomial from monomials given in any order.
+*
+* Monomials are only appended to the buffer, then PolyBuilderBuild
+* sorts them once by exponents (radix sort) and merges the ones
+* with equal exponents, so building polynomial of n monomials takes
+* linear time (instead of inserting monomials one by one).
+*
+* Usage:
+* @code
+*   PolyBuilder builder = PolyBuilderNew();
+*   PolyBuilderAdd(&builder, MonoFromPoly(&p, 3));
+*   PolyBuilderAdd(&builder, MonoFromPoly(&q, 1));
+*   Poly r = PolyBuilderBuild(&builder); // q*x + p*x^3
+* @endcode
+*/
+typedef struct PolyBuilder {
+  Poly p; ///< Constant term and collected monomials (not sorted)
+  bool sorted; ///< Are collected monomials sorted (rising exponents)
+} PolyBuilder;
+
+/**
+* Create empty polynomial builder.
+*
+* @return polynomial builder
+*/
+static inline PolyBuilder PolyBuilderNew(void) {
+  return (PolyBuilder) { .p = PolyZero(), .sorted = true };
+}
+
+/**
+* Add monomial to the built polynomial.
+* Captures the monomial (see PolyInsertMono).
+*
+* @param[in,out] builder : polynomial builder
+* @param[in]     mono    : monomial
+*/
+void PolyBuilderAdd(PolyBuilder* builder, Mono mono);
+
+/**
+* Create polynomial from all monomials added to the builder.
+* The builder is empty afterwards.
+*
+* @param[in,out] builder : polynomial builder
+* @return sum of added monomials
+*/
+Poly PolyBuilderBuild(PolyBuilder* builder);
+
+/**
+* Free monomials added to the builder
+* (when the polynomial is not built).
+*
+* @param[in,out] builder : polynomial builder
+*/
+void PolyBuilderDestroy(PolyBuilder* builder);
+
 /**
 * Multiplicates two polynomials.
 * Returns standalone polynomial (deep-copied).
@@ -408,6 +825,23 @@ Poly PolyAddMonos(unsigned count, const Mono monos[]);
 */
 Poly PolyMul(const Poly *p, const Poly *q);
 
+/**
+* Multiplicates two polynomials using the thread pool.
+*
+* The result is the same as for PolyMul.
+* Products computed by the heap algorithm with at least
+* POLY_MUL_PARALLEL_THRESHOLD pairs of monomials (on all levels)
+* are split into slices of the longer polynomial multiplied in parallel.
+* The partial products are merged with parallel tree reduction.
+* If @p pool is NULL then PolyMul is used.
+*
+* @param[in] p    : polynomial
+* @param[in] q    : polynomial
+* @param[in] pool : Thread pool (may be NULL)
+* @return `p * q`
+*/
+Poly PolyMulParallel(const Poly *p, const Poly *q, ThreadPool* pool);
+
 /**
 * Returns a polynomial with changes sign.
 * It's standalone polynomial (deep-copied).
@@ -427,6 +861,52 @@ Poly PolyNeg(const Poly *p);
 */
 Poly PolySub(const Poly *p, const Poly *q);
 
+/**
+* Changes sign of polynomial in place (`p = -p`).
+*
+* @param[in,out] p : polynomial
+*/
+void PolyNegInPlace(Poly *p);
+
+/**
+* Substracts polynomial @p q from @p p in place taking ownership of
+* @p q data (`p -= q`). No monomials are copied.
+* After the call @p q is a zero polynomial.
+*
+* @param[in,out] p : polynomial
+* @param[in,out] q : polynomial (captured)
+*/
+void PolySubTakeInPlace(Poly *p, Poly *q);
+
+/**
+* Multiplies polynomial @p p by @p q in place taking ownership of
+* @p q data (`p *= q`).
+* If any of polynomials is constant the other one is scaled in place
+* without copying.
+* After the call @p q is a zero polynomial.
+*
+* Example:
+* @code
+*   Poly a = PolyP( PolyC(1), 1 ); // x
+*   Poly b = PolyC(3);
+*   PolyMulTakeInPlace(&a, &b);    // a = 3x, b = 0
+* @endcode
+*
+* @param[in,out] p : polynomial
+* @param[in,out] q : polynomial (captured)
+*/
+void PolyMulTakeInPlace(Poly *p, Poly *q);
+
+/**
+* Multiply polynomial @p p by @p q in place taking ownership of @p q
+* using the thread pool (see PolyMulTakeInPlace and PolyMulParallel).
+*
+* @param[in,out] p    : polynomial
+* @param[in,out] q    : polynomial (captured)
+* @param[in]     pool : Thread pool (may be NULL)
+*/
+void PolyMulTakeInPlaceParallel(Poly *p, Poly *q, ThreadPool* pool);
+
 /**
 * Determines the degree of polynomial with respect to the given variable
 * (-1 for zero polynomial).
@@ -471,6 +951,17 @@ poly_exp_t PolyDeg(const Poly *p);
 */
 bool PolyIsEq(const Poly *p, const Poly *q);
 
+/**
+* Reduces all coefficients of polynomial modulo current modulus
+* of coefficients (see poly_coeff.h). Monomials reduced to zero are removed.
+* Polynomials created with coefficients out of range [0, p)
+* must be reduced before they are used in modular arithmetic.
+* Without modulus the polynomial is not changed.
+*
+* @param[in,out] p : polynomial
+*/
+void PolyReduceCoeffs(Poly* p);
+
 /**
 * Calculates value of polynomial in point @p x.
 * It's done by substituting first (main) variable of polynomial with @p x.
@@ -487,6 +978,153 @@ bool PolyIsEq(const Poly *p, const Poly *q);
 */
 Poly PolyAt(const Poly *p, poly_coeff_t x);
 
+/**
+* Calculates value of polynomial in point @p x in place
+* (see PolyAt). Coefficients of @p p are reused.
+*
+* @param[in,out] p : polynomial
+* @param[in]     x : single value
+*/
+void PolyAtInPlace(Poly *p, poly_coeff_t x);
+
+/**
+* Kinds of steps of PolyProgram.
+* The steps operate on the stack of values (top is the last value).
+*/
+typedef enum PolyProgramOp {
+  POLY_PROGRAM_CONST, ///< Push `c`
+  POLY_PROGRAM_CONST_POW, ///< Push `c * powers[arg]`
+  POLY_PROGRAM_ADD, ///< Pop value and add it to the top
+  POLY_PROGRAM_ADD_CONST, ///< Add `c` to the top
+  POLY_PROGRAM_MUL_POW, ///< Multiply the top by `powers[arg]`
+  POLY_PROGRAM_MUL_POW_ADD_CONST ///< Multiply the top by `powers[arg]` and add `c`
+} PolyProgramOp;
+
+/**
+* Single step of PolyProgram
+*/
+typedef struct PolyProgramStep {
+  PolyProgramOp op; ///< Kind of the step
+  int arg; ///< Index of power used by the step
+  poly_coeff_t c; ///< Constant used by the step
+} PolyProgramStep;
+
+/**
+* Power of variable used by PolyProgram
+*/
+typedef struct PolyProgramPower {
+  int var; ///< Index of variable
+  poly_exp_t exp; ///< Exponent
+} PolyProgramPower;
+
+/**
+* Polynomial compiled for repeated evaluation.
+* The program is a nested Horner scheme flattened to the array of steps.
+* All the powers of variables it uses are computed once per point
+* (every one from the previous power of the same variable)
+* before the steps are executed.
+*/
+typedef struct PolyProgram {
+  PolyProgramStep* steps; ///< Steps of the program
+  int size; ///< Number of steps
+  PolyProgramPower* powers; ///< Used powers sorted by variables and exponents
+  int powers_size; ///< Number of used powers
+  int depth; ///< Maximum size of the stack
+  int bits; ///< Bound on number of bits of sum of absolute values of the constants
+  bool big_consts; ///< Whether any of the constants is not small
+  poly_exp_t degree; ///< Degree of the polynomial
+} PolyProgram;
+
+/**
+* Compiles polynomial to the program evaluating it.
+* The program does not reference @p p and must be freed
+* with PolyProgramDestroy.
+*
+* @param[in] p : polynomial
+* @return PolyProgram
+*/
+PolyProgram PolyCompile(const Poly* p);
+
+/**
+* Frees memory of the program.
+*
+* @param[in,out] program : PolyProgram
+*/
+void PolyProgramDestroy(PolyProgram* program);
+
+/**
+* Evaluates compiled polynomial in @p count points.
+* All the variables are substituted, so the results are numbers.
+* The points are processed in blocks of POLY_EVAL_BATCH_BLOCK values
+* and every step of the program is a loop over the block.
+* Blocks for which the values could be large (see PolyCoeffIsSmall)
+* are run with overflow checks and only the points which overflowed
+* are evaluated exactly (PolyProgramEval). Programs with large constants
+* and points which are not small are always evaluated exactly.
+*
+* The results are owned by the caller (see PolyCoeffDestroy).
+*
+* The points are given by variables: `points[var][i]` is value of variable
+* `var` in `i`-th point. Variables with indexes not lower than @p vars
+* are substituted with 0.
+*
+* @param[in]  program : PolyProgram
+* @param[in]  vars    : number of variables given in @p points
+* @param[in]  points  : values of variables (array of @p vars arrays of @p count values)
+* @param[in]  count   : number of points
+* @param[out] results : array of @p count values of the polynomial
+*/
+void PolyProgramRun(const PolyProgram* program, int vars, const poly_coeff_t* const* points,
+  int count, poly_coeff_t* results);
+
+/**
+* Evaluates compiled polynomial in a single point (see PolyProgramRun).
+* The result is owned by the caller (see PolyCoeffDestroy).
+*
+* @param[in] program : PolyProgram
+* @param[in] vars    : number of variables given in @p values
+* @param[in] values  : values of variables
+* @return @f$p(x_0, x_1, \ldots)@f$
+*/
+poly_coeff_t PolyProgramEval(const PolyProgram* program, int vars, const poly_coeff_t* values);
+
+/**
+* Calculates values of polynomial in @p count points.
+* The polynomial is compiled (PolyCompile) and the program
+* is run for all the points (PolyProgramRun).
+*
+* Returned array (of @p count values) must be freed by the caller
+* (together with the values, see PolyCoeffDestroy).
+*
+* @param[in] p      : polynomial
+* @param[in] vars   : number of variables given in @p points
+* @param[in] points : values of variables (array of @p vars arrays of @p count values)
+* @param[in] count  : number of points
+* @return array of @f$p(x_0^{(i)}, x_1^{(i)}, \ldots)@f$
+*/
+poly_coeff_t* PolyEvalBatch(const Poly* p, int vars, const poly_coeff_t* const* points, int count);
+
+/**
+* Function receiving output of polynomial printer.
+* The @p str is not null-terminated and it's valid only during the call.
+*
+* @param[in] data   : data given to PolyPrintTo
+* @param[in] str    : printed characters
+* @param[in] length : number of printed characters
+*/
+typedef void (*PolyPrintWriter)(void* data, const char* str, size_t length);
+
+/**
+* Prints polynomial @p p using PolySprintf format.
+* Output is passed to the @p writer in chunks
+* (see POLY_PRINT_CHUNK_SIZE), so it's not stored as a whole.
+*
+* @param[in] p      : polynomial
+* @param[in] writer : function receiving the output
+* @param[in] data   : data passed to the @p writer
+*/
+void PolyPrintTo(const Poly* p, PolyPrintWriter writer, void* data);
+
 /**
 * Prints polynomial @p p to standard output (stdout)
 * using PolySprintf format.
@@ -517,11 +1155,25 @@ poly_coeff_t PolyGetConstTerm(const Poly* p);
 * - do not print terms multiplied by 0
 * - do not print sign wherever possible
 *
+* The @p dest must hold `PolySnprintf(NULL, 0, p) + 1` characters.
+*
 * @param[in] dest : char array pointer
 * @param[in] p    : polynomial
 */
 void PolySprintf(char* dest, const Poly *p);
 
+/**
+* Converts polynomial @p p to human-readable char sequence
+* (see PolySprintf) writing at most @p size characters
+* (including terminating zero) to @p dest, like snprintf does.
+*
+* @param[in] dest : char array pointer (may be NULL if @p size is 0)
+* @param[in] size : size of @p dest
+* @param[in] p    : polynomial
+* @return length of the whole representation (without terminating zero)
+*/
+size_t PolySnprintf(char* dest, size_t size, const Poly *p);
+
 /**
  * Converts polynomial @p p to human-readable char sequence.
  * Uses PolySprintf formatting.
@@ -567,6 +1219,81 @@ void PolyInsertMono(Poly* p, Mono mono);
 */
 Poly PolyPow(const Poly* p, poly_exp_t exp);
 
+/**
+* Cache of powers of single polynomial.
+* It holds the ladder of squares `base^(2^i)` and all the powers
+* computed so far, so the repeated calls of PolyPowCached
+* do not recompute the same products.
+*/
+typedef struct PolyPowCache {
+  Poly* squares; ///< Powers base^(2^i) (the first one is the base)
+  int squares_count; ///< Number of computed squares
+  Mono* powers; ///< Computed powers sorted by exponents
+  int size; ///< Number of computed powers
+  int alloc_size; ///< Capacity of @p powers array
+} PolyPowCache;
+
+/**
+* Creates cache of powers of a given polynomial.
+* The cache holds its own copy of @p base.
+*
+* @param[in] base : Base of powers
+* @return PolyPowCache
+*/
+PolyPowCache PolyPowCacheNew(const Poly* base);
+
+/**
+* Destroys cache of powers.
+*
+* @param[in] cache : Cache of powers
+*/
+void PolyPowCacheDestroy(PolyPowCache* cache);
+
+/**
+* Calculate polynomial exponent using cache of powers.
+*
+* The power is computed from the highest cached power lower than @p exp
+* multiplied by the squares from the ladder. The result is stored
+* in the cache, so asking for it again is O(1).
+*
+* Example:
+* @code
+*    Poly x = PolyP( PolyC(1), 1, PolyC(1), 2 );
+*    PolyPowCache cache = PolyPowCacheNew(&x);
+*
+*    Poly a = PolyPowCached(&cache, 10);
+*    Poly b = PolyPowCached(&cache, 12); // x^10 * x^2
+*
+*    PolyDestroy(&a);
+*    PolyDestroy(&b);
+*    PolyPowCacheDestroy(&cache);
+* @endcode
+*
+* @param[in] cache : Cache of powers
+* @param[in] exp   : Exponent value
+* @return     Polynomial power.
+*/
+Poly PolyPowCached(PolyPowCache* cache, poly_exp_t exp);
+
+/**
+* Calculate polynomial exponent in place (`p = p ^ exp`).
+* The polynomial is used as a base without copying.
+*
+* @param[in,out] p   : Input polynomial
+* @param[in]     exp : Exponent value
+*/
+void PolyPowInPlace(Poly* p, poly_exp_t exp);
+
+/**
+* Calculate polynomial exponent in place using the thread pool
+* (see PolyPowInPlace and PolyMulParallel).
+*
+* @param[in,out] p    : Input polynomial
+* @param[in]     exp  : Exponent value
+* @param[in]     pool : Thread pool (may be NULL)
+*/
+void PolyPowInPlaceParallel(Poly* p, poly_exp_t exp, ThreadPool* pool);
+
 /**
 * Compose given polynomials to one polynomial.
 * Composition take place as follows:
@@ -627,6 +1354,25 @@ Poly PolyPow(const Poly* p, poly_exp_t exp);
 */
 Poly PolyCompose(const Poly *p, unsigned count, const Poly x[]);
 
+/**
+* Compose given polynomials to one polynomial using the thread pool.
+*
+* The result is the same as for PolyCompose.
+* The top level and its sub-levels with at least POLY_COMPOSE_PARALLEL_THRESHOLD
+* monomials per thread are split into ranges composed in parallel and
+* the partial results are summed with parallel tree reduction.
+* Powers of the substituted polynomials are computed once and shared
+* by all ranges.
+* If @p pool is NULL then PolyCompose is used.
+*
+* @param[in]  p     : Input polynomial
+* @param[in]  count : Length of substitution list
+* @param[in]  x     : Substitution list
+* @param[in]  pool  : Thread pool (may be NULL)
+* @return Poly composed from input polyonimal and the given list
+*/
+Poly PolyComposeParallel(const Poly *p, unsigned count, const Poly x[], ThreadPool* pool);
+
 /**
 * Variadic function to create poly from given input.
 * Input must be the form of:
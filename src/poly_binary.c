@@ -0,0 +1,278 @@
+/*
+*  Binary serialization of polynomials.
+*
+*  @author Piotr Styczyński <piotrsty1@gmail.com>
+*  @copyright MIT
+*  @date 2017-05-13
+*/
+#include "utils.h"
+#include <assert.h>
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+#include "memalloc.h"
+#include "poly_binary.h"
+
+/*
+* Magic bytes starting files of polynomials
+*/
+#define POLY_BINARY_MAGIC "POLY"
+
+/*
+* Length of magic bytes
+*/
+#define POLY_BINARY_MAGIC_SIZE 4
+
+/*
+* Number of frames of PolyLoad kept on the native stack
+* (deeper polynomials move them to the heap)
+*/
+#define POLY_BINARY_LOCAL_FRAMES 16
+
+/*
+* Writes varint (groups of 7 bits, the least significant first)
+*/
+static inline void PolyBinaryWriteVarint(OutputBuffer* out, uint64_t value) {
+  while(value >= 0x80) {
+    OutputBufferPut(out, (char) ((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  OutputBufferPut(out, (char) value);
+}
+
+/*
+* Reads varint of at most 64 bits
+*/
+static inline bool PolyBinaryReadVarint(InputBuffer* in, uint64_t* value) {
+  *value = 0;
+  for(int shift=0;shift<64;shift+=7) {
+    const int byte = InputBufferGet(in);
+    if(byte == EOF) return false;
+    if(shift == 63 && byte > 1) return false;
+    *value |= (uint64_t) (byte & 0x7F) << shift;
+    if((byte & 0x80) == 0) return true;
+  }
+  return false;
+}
+
+/*
+* Writes coefficient as varint of its magnitude shifted left
+* with the sign in the lowest bit.
+* Limbs of big coefficients are written 7 bits at a time.
+*/
+static void PolyBinaryWriteCoeff(OutputBuffer* out, poly_coeff_t c) {
+  if(PolyCoeffIsSmall(c)) {
+    PolyBinaryWriteVarint(out, (c < 0)
+      ? ((uint64_t) (0UL - (unsigned long) c) << 1) | 1
+      : (uint64_t) c << 1);
+    return;
+  }
+  const PolyCoeffBig* big = PolyCoeffBigOf(c);
+  uint64_t acc = (c < 0) ? 1 : 0;
+  int acc_bits = 1;
+  for(int i=0;i<big->size;++i) {
+    acc |= (uint64_t) big->limbs[i] << acc_bits;
+    acc_bits += 32;
+    // The highest limb is not zero, so the lower ones are followed by more bytes
+    while((i+1 < big->size) ? (acc_bits >= 7) : (acc >= 0x80)) {
+      OutputBufferPut(out, (char) ((acc & 0x7F) | 0x80));
+      acc >>= 7;
+      acc_bits -= 7;
+    }
+  }
+  OutputBufferPut(out, (char) acc);
+}
+
+/*
+* Appends limb to the growing magnitude
+*/
+static inline void PolyBinaryPushLimb(uint32_t** limbs, int* size, int* alloc_size, uint32_t limb) {
+  if(*size == *alloc_size) {
+    *alloc_size *= 2;
+    *limbs = MREALLOCATE_ARRAY(uint32_t, *alloc_size, *limbs);
+  }
+  (*limbs)[(*size)++] = limb;
+}
+
+/*
+* Reads rest of coefficient not fitting in the machine integer.
+* The @p acc holds @p acc_bits bits of the varint read so far.
+*/
+static bool PolyBinaryReadBigCoeff(InputBuffer* in, uint64_t acc, int acc_bits, poly_coeff_t* c) {
+  int alloc_size = 8;
+  int size = 0;
+  uint32_t* limbs = MALLOCATE_ARRAY(uint32_t, alloc_size);
+  int byte;
+  do {
+    byte = InputBufferGet(in);
+    if(byte == EOF) {
+      free(limbs);
+      return false;
+    }
+    while(acc_bits >= 32) {
+      PolyBinaryPushLimb(&limbs, &size, &alloc_size, (uint32_t) acc);
+      acc >>= 32;
+      acc_bits -= 32;
+    }
+    acc |= (uint64_t) (byte & 0x7F) << acc_bits;
+    acc_bits += 7;
+  } while(byte & 0x80);
+  for(;acc_bits>0;acc_bits-=32) {
+    PolyBinaryPushLimb(&limbs, &size, &alloc_size, (uint32_t) acc);
+    acc >>= 32;
+  }
+
+  // Drop the sign bit from the magnitude
+  const bool negative = limbs[0] & 1;
+  for(int i=0;i<size;++i) {
+    limbs[i] = (limbs[i] >> 1) | ((i+1 < size) ? limbs[i+1] << 31 : 0);
+  }
+  const poly_coeff_t value = PolyCoeffFromLimbs(limbs, size, negative);
+  free(limbs);
+  *c = PolyCoeffClone(PolyCoeffReduce(value));
+  PolyCoeffDestroy(value);
+  return true;
+}
+
+/*
+* Reads coefficient (see PolyBinaryWriteCoeff).
+* Varints of at most 63 bits are read into machine integer.
+*/
+static bool PolyBinaryReadCoeff(InputBuffer* in, poly_coeff_t* c) {
+  uint64_t acc = 0;
+  for(int acc_bits=0;acc_bits<63;acc_bits+=7) {
+    const int byte = InputBufferGet(in);
+    if(byte == EOF) return false;
+    acc |= (uint64_t) (byte & 0x7F) << acc_bits;
+    if((byte & 0x80) == 0) {
+      const long magnitude = (long) (acc >> 1);
+      *c = PolyCoeffReduce((acc & 1) ? -magnitude : magnitude);
+      return true;
+    }
+  }
+  return PolyBinaryReadBigCoeff(in, acc, 63, c);
+}
+
+/*
+* Writes header of file of polynomials
+*/
+void PolyBinaryWriteHeader(OutputBuffer* out, size_t count) {
+  OutputBufferWrite(out, POLY_BINARY_MAGIC, POLY_BINARY_MAGIC_SIZE);
+  OutputBufferPut(out, (char) POLY_BINARY_VERSION);
+  PolyBinaryWriteVarint(out, count);
+}
+
+/*
+* Reads header of file of polynomials
+*/
+bool PolyBinaryReadHeader(InputBuffer* in, size_t* count) {
+  for(int i=0;i<POLY_BINARY_MAGIC_SIZE;++i) {
+    if(InputBufferGet(in) != POLY_BINARY_MAGIC[i]) return false;
+  }
+  if(InputBufferGet(in) != POLY_BINARY_VERSION) return false;
+  uint64_t value;
+  if(!PolyBinaryReadVarint(in, &value) || value > SIZE_MAX) return false;
+  *count = (size_t) value;
+  return true;
+}
+
+/*
+* Writes polynomial in pre-order
+*/
+void PolySave(const Poly* p, OutputBuffer* out) {
+  assert(p!=NULL);
+  PolyBinaryWriteCoeff(out, p->c);
+  PolyBinaryWriteVarint(out, (uint64_t) PolyMonosCount(p));
+  LOOP_POLY(p, m) {
+    // Zigzag encoding keeps small negative exponents short
+    const uint32_t exp = (uint32_t) m->exp;
+    PolyBinaryWriteVarint(out, (exp << 1) ^ (uint32_t) -(int32_t) (exp >> 31));
+    PolySave(&(m->p), out);
+  }
+}
+
+/*
+* Polynomial being read by PolyLoad
+*/
+typedef struct PolyBinaryFrame {
+  PolyBuilder builder; ///< Already read part of polynomial
+  int remaining; ///< Number of monomials left to read
+  poly_exp_t exp; ///< Exponent of monomial the polynomial is coefficient of
+} PolyBinaryFrame;
+
+/*
+* Starts reading polynomial: pushes its frame and reads the constant term
+* and the number of monomials
+*/
+static bool PolyBinaryPushFrame(InputBuffer* in, PolyBinaryFrame** frames, int* depth, int* alloc_size, PolyBinaryFrame* local, poly_exp_t exp) {
+  if(*depth == *alloc_size) {
+    *alloc_size *= 2;
+    if(*frames == local) {
+      *frames = MALLOCATE_ARRAY(PolyBinaryFrame, *alloc_size);
+      memcpy(*frames, local, (*depth) * sizeof(PolyBinaryFrame));
+    } else {
+      *frames = MREALLOCATE_ARRAY(PolyBinaryFrame, *alloc_size, *frames);
+    }
+  }
+  PolyBinaryFrame* frame = &(*frames)[(*depth)++];
+  *frame = (PolyBinaryFrame) {
+    .builder = PolyBuilderNew(),
+    .remaining = 0,
+    .exp = exp
+  };
+
+  poly_coeff_t c;
+  uint64_t size;
+  if(!PolyBinaryReadCoeff(in, &c)) return false;
+  Poly constant = PolyFromCoeff(c);
+  PolyBuilderAdd(&(frame->builder), MonoFromPoly(&constant, 0));
+  if(!PolyBinaryReadVarint(in, &size) || size > INT_MAX) return false;
+  frame->remaining = (int) size;
+  return true;
+}
+
+/*
+* Reads polynomial written in binary format.
+* Monomials are appended to the builders in the order of exponents,
+* so every polynomial is built without sorting.
+*/
+bool PolyLoad(InputBuffer* in, Poly* p) {
+  PolyBinaryFrame local[POLY_BINARY_LOCAL_FRAMES];
+  PolyBinaryFrame* frames = local;
+  int alloc_size = POLY_BINARY_LOCAL_FRAMES;
+  int depth = 0;
+
+  bool valid = PolyBinaryPushFrame(in, &frames, &depth, &alloc_size, local, 0);
+  *p = PolyZero();
+  while(valid) {
+    PolyBinaryFrame* frame = &frames[depth-1];
+    if(frame->remaining == 0) {
+      Poly done = PolyBuilderBuild(&(frame->builder));
+      const poly_exp_t exp = frame->exp;
+      if(--depth == 0) {
+        *p = done;
+        break;
+      }
+      PolyBuilderAdd(&(frames[depth-1].builder), MonoFromPoly(&done, exp));
+      continue;
+    }
+
+    --(frame->remaining);
+    uint64_t exp;
+    if(!PolyBinaryReadVarint(in, &exp) || exp > UINT32_MAX) {
+      valid = false;
+      break;
+    }
+    valid = PolyBinaryPushFrame(in, &frames, &depth, &alloc_size, local,
+      (poly_exp_t) ((uint32_t) (exp >> 1) ^ -(uint32_t) (exp & 1)));
+  }
+
+  // Free partially read polynomials
+  for(int i=0;i<depth;++i) {
+    PolyBuilderDestroy(&(frames[i].builder));
+  }
+  if(frames != local) {
+    free(frames);
+  }
+  return valid;
+}
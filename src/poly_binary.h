@@ -0,0 +1,102 @@
+/** @file
+*  Binary serialization of polynomials.
+*
+*  Polynomials are written in pre-order, every one of them as:
+*  @code
+*     POLY := COEFF SIZE (EXP POLY)*SIZE
+*  @endcode
+*  where COEFF is the constant term, SIZE is the number of monomials
+*  and every monomial is its exponent followed by its coefficient.
+*  All the numbers are varints (little-endian groups of 7 bits,
+*  the highest bit of byte is set if more bytes follow):
+*    - SIZE is written as it is
+*    - EXP is zigzag encoded (0, -1, 1, -2, ... are 0, 1, 2, 3, ...)
+*    - COEFF is its magnitude shifted left by one bit with the sign
+*      in the lowest bit (the magnitude is not limited, see poly_coeff.h)
+*
+*  Files of polynomials start with the header:
+*  @code
+*     FILE := "POLY" VERSION COUNT POLY*COUNT
+*  @endcode
+*  where VERSION is single byte (POLY_BINARY_VERSION)
+*  and COUNT is varint number of polynomials.
+*
+*  Usage:
+*  @code
+*     #include <poly_binary.h>
+*      ...
+*     OutputBuffer out;
+*     OutputBufferOpen(&out, "polys.bin", OUTPUT_BUFFER_BLOCK_SIZE);
+*     PolyBinaryWriteHeader(&out, 1);
+*     PolySave(&p, &out);
+*     OutputBufferDestroy(&out);
+*
+*     InputBuffer in;
+*     InputBufferOpen(&in, "polys.bin", INPUT_BUFFER_BLOCK_SIZE);
+*     size_t count;
+*     Poly q;
+*     if(PolyBinaryReadHeader(&in, &count) && count == 1 && PolyLoad(&in, &q)) {
+*       ...
+*     }
+*     InputBufferDestroy(&in);
+*  @endcode
+*
+*  @author Piotr Styczyński <piotrsty1@gmail.com>
+*  @copyright MIT
+*  @date 2017-05-13
+*/
+#include "utils.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include "poly.h"
+#include "input_buffer.h"
+#include "output_buffer.h"
+
+#ifndef __STY_COMMON_POLY_BINARY_H__
+#define __STY_COMMON_POLY_BINARY_H__
+
+/**
+* @def POLY_BINARY_VERSION
+*
+* Version of binary format written to the header of files
+*/
+#define POLY_BINARY_VERSION 1
+
+/**
+* Write header of file of @p count polynomials.
+*
+* @param[in] out   : Output buffer
+* @param[in] count : Number of polynomials written after the header
+*/
+void PolyBinaryWriteHeader(OutputBuffer* out, size_t count);
+
+/**
+* Read header of file of polynomials.
+*
+* @param[in]  in    : Input buffer
+* @param[out] count : Number of polynomials following the header
+* @return is the header valid (of known version)?
+*/
+bool PolyBinaryReadHeader(InputBuffer* in, size_t* count);
+
+/**
+* Write polynomial in binary format.
+*
+* @param[in] p   : Polynomial
+* @param[in] out : Output buffer
+*/
+void PolySave(const Poly* p, OutputBuffer* out);
+
+/**
+* Read polynomial written in binary format.
+* The polynomial is built while reading (nested polynomials
+* are read using explicit stack, so they can be nested arbitrarily deep).
+* Coefficients are reduced (see PolyCoeffReduce).
+*
+* @param[in]  in : Input buffer
+* @param[out] p  : Read polynomial (zero if the input is not valid)
+* @return is the input valid?
+*/
+bool PolyLoad(InputBuffer* in, Poly* p);
+
+#endif /* __STY_COMMON_POLY_BINARY_H__ */
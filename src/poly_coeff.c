@@ -0,0 +1,399 @@
+/*
+*  Arithmetic of polynomial coefficients.
+*
+*  @author Piotr Styczyński <piotrsty1@gmail.com>
+*  @copyright MIT
+*  @date 2017-05-13
+*/
+#include "utils.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "poly_coeff.h"
+
+_Static_assert(sizeof(long) == 8 && sizeof(uintptr_t) == 8,
+  "Tagged coefficients need 64-bit machine words");
+
+/*
+* Number of bits of (positive) modulus
+*/
+#define POLY_COEFF_BITS(P) (int)(8 * sizeof(unsigned long) - __builtin_clzl((unsigned long)(P)))
+
+#if defined(__SIZEOF_INT128__)
+/*
+* Barrett reduction factor of (positive) modulus
+*/
+#define POLY_COEFF_BARRETT(P) \
+  (unsigned long)((((PolyCoeffWide) 1) << (2 * POLY_COEFF_BITS(P))) / (unsigned long)(P))
+#else
+#define POLY_COEFF_BARRETT(P) 0UL
+#endif
+
+/*
+* Number of bits of single limb of big coefficient
+*/
+#define POLY_COEFF_LIMB_BITS 32
+
+/*
+* Base of decimal chunks printed at once (10^9 fits in a limb)
+*/
+#define POLY_COEFF_DECIMAL_BASE 1000000000U
+
+#if POLY_COEFF_MODULUS == 0
+PolyCoeffModulus PolyCoeffCurrentModulus = { .value = 0, .barrett = 0, .bits = 0 };
+#else
+PolyCoeffModulus PolyCoeffCurrentModulus = {
+  .value = POLY_COEFF_MODULUS,
+  .barrett = POLY_COEFF_BARRETT(POLY_COEFF_MODULUS),
+  .bits = POLY_COEFF_BITS(POLY_COEFF_MODULUS)
+};
+#endif
+
+/*
+* Set modulus of coefficients arithmetic (see poly_coeff.h)
+*/
+void PolyCoeffSetModulus(poly_coeff_t modulus) {
+  assert(modulus == 0 || (modulus >= 2 && modulus <= POLY_COEFF_MODULUS_MAX));
+  if(modulus == 0) {
+    PolyCoeffCurrentModulus = (PolyCoeffModulus) { .value = 0, .barrett = 0, .bits = 0 };
+    return;
+  }
+  PolyCoeffCurrentModulus = (PolyCoeffModulus) {
+    .value = modulus,
+    .barrett = POLY_COEFF_BARRETT(modulus),
+    .bits = POLY_COEFF_BITS(modulus)
+  };
+}
+
+/*
+* Sign and magnitude of any coefficient.
+* Magnitudes of small numbers are kept in the view itself.
+*/
+typedef struct PolyCoeffView {
+  bool negative; ///< Sign of the number
+  int size; ///< Number of limbs (0 for zero)
+  const uint32_t* limbs; ///< Limbs of magnitude (the least significant first)
+  uint32_t buffer[2]; ///< Limbs of small number
+} PolyCoeffView;
+
+/*
+* Fills view of coefficient
+*/
+static inline void PolyCoeffViewOf(poly_coeff_t c, PolyCoeffView* view) {
+  view->negative = (c < 0);
+  if(PolyCoeffIsSmall(c)) {
+    const unsigned long magnitude = (c < 0) ? 0UL - (unsigned long) c : (unsigned long) c;
+    view->buffer[0] = (uint32_t) magnitude;
+    view->buffer[1] = (uint32_t) (magnitude >> POLY_COEFF_LIMB_BITS);
+    view->size = (view->buffer[1] != 0) ? 2 : (view->buffer[0] != 0);
+    view->limbs = view->buffer;
+    return;
+  }
+  const PolyCoeffBig* big = PolyCoeffBigOf(c);
+  view->size = big->size;
+  view->limbs = big->limbs;
+}
+
+/*
+* Allocates magnitude of @p size limbs (with the reference count set to 1)
+*/
+static inline PolyCoeffBig* PolyCoeffBigNew(int size) {
+  PolyCoeffBig* big = MALLOCATE_BLOCKS(sizeof(PolyCoeffBig) + size * sizeof(uint32_t), 1);
+  atomic_init(&(big->refs), 1);
+  big->size = size;
+  return big;
+}
+
+/*
+* Frees magnitude of big coefficient (see poly_coeff.h)
+*/
+void PolyCoeffBigFree(PolyCoeffBig* big) {
+  free(big);
+}
+
+/*
+* Creates tagged word referencing the magnitude
+*/
+static inline poly_coeff_t PolyCoeffBigHandle(const PolyCoeffBig* big, bool negative) {
+  assert(((uintptr_t) big & 1) == 0 && ((uintptr_t) big >> 63) == 0);
+  const unsigned long word = (1UL << 62) | ((uintptr_t) big >> 1);
+  return (poly_coeff_t) (negative ? ~word : word);
+}
+
+/*
+* Creates coefficient from freshly computed magnitude.
+* Leading zero limbs are dropped and numbers fitting
+* in small range are stored inline (the magnitude is then freed).
+*/
+static poly_coeff_t PolyCoeffBigNormalize(PolyCoeffBig* big, bool negative) {
+  while(big->size > 0 && big->limbs[big->size-1] == 0) {
+    --(big->size);
+  }
+  if(big->size <= 2) {
+    unsigned long magnitude = 0;
+    for(int i=big->size-1;i>=0;--i) {
+      magnitude = (magnitude << POLY_COEFF_LIMB_BITS) | big->limbs[i];
+    }
+    if(magnitude <= (unsigned long) POLY_COEFF_SMALL_MAX || (negative && magnitude == 1UL << 62)) {
+      free(big);
+      return (poly_coeff_t) (negative ? 0UL - magnitude : magnitude);
+    }
+  }
+  return PolyCoeffBigHandle(big, negative);
+}
+
+/*
+* Copies magnitude of big coefficient living in arena to the heap
+*/
+poly_coeff_t PolyCoeffBigCopy(poly_coeff_t c) {
+  const PolyCoeffBig* big = PolyCoeffBigOf(c);
+  PolyCoeffBig* copy = PolyCoeffBigNew(big->size);
+  memcpy(copy->limbs, big->limbs, big->size * sizeof(uint32_t));
+  return PolyCoeffBigHandle(copy, c < 0);
+}
+
+/*
+* Copies coefficient into the arena (see poly_coeff.h)
+*/
+poly_coeff_t PolyCoeffCloneToArena(poly_coeff_t c, MemArena* arena) {
+  if(PolyCoeffIsSmall(c)) return c;
+  const PolyCoeffBig* big = PolyCoeffBigOf(c);
+  PolyCoeffBig* copy = MemArenaAllocate(arena, sizeof(PolyCoeffBig) + big->size * sizeof(uint32_t));
+  atomic_init(&(copy->refs), -1);
+  copy->size = big->size;
+  memcpy(copy->limbs, big->limbs, big->size * sizeof(uint32_t));
+  return PolyCoeffBigHandle(copy, c < 0);
+}
+
+/*
+* Creates big coefficient from machine integer
+*/
+poly_coeff_t PolyCoeffBigFromLong(long value) {
+  const unsigned long magnitude = (value < 0) ? 0UL - (unsigned long) value : (unsigned long) value;
+  PolyCoeffBig* big = PolyCoeffBigNew(2);
+  big->limbs[0] = (uint32_t) magnitude;
+  big->limbs[1] = (uint32_t) (magnitude >> POLY_COEFF_LIMB_BITS);
+  return PolyCoeffBigNormalize(big, value < 0);
+}
+
+/*
+* Creates coefficient from magnitude given as limbs
+*/
+poly_coeff_t PolyCoeffFromLimbs(const uint32_t* limbs, int size, bool negative) {
+  assert(size >= 0);
+  PolyCoeffBig* big = PolyCoeffBigNew(size);
+  memcpy(big->limbs, limbs, size * sizeof(uint32_t));
+  return PolyCoeffBigNormalize(big, negative);
+}
+
+/*
+* Creates big coefficient from the machine integer of accumulator
+*/
+poly_coeff_t PolyCoeffBigFromAccValue(PolyCoeffAccValue value) {
+#if defined(__SIZEOF_INT128__)
+  const PolyCoeffWide magnitude = (value < 0) ? 0 - (PolyCoeffWide) value : (PolyCoeffWide) value;
+  PolyCoeffBig* big = PolyCoeffBigNew(4);
+  for(int i=0;i<4;++i) {
+    big->limbs[i] = (uint32_t) (magnitude >> (i * POLY_COEFF_LIMB_BITS));
+  }
+  return PolyCoeffBigNormalize(big, value < 0);
+#else
+  return PolyCoeffFromLong(value);
+#endif
+}
+
+/*
+* Compares magnitudes
+*/
+static int PolyCoeffMagnitudeCompare(const PolyCoeffView* a, const PolyCoeffView* b) {
+  if(a->size != b->size) return (a->size < b->size) ? -1 : 1;
+  for(int i=a->size-1;i>=0;--i) {
+    if(a->limbs[i] != b->limbs[i]) return (a->limbs[i] < b->limbs[i]) ? -1 : 1;
+  }
+  return 0;
+}
+
+/*
+* Add two coefficients without modulus
+*/
+poly_coeff_t PolyCoeffAddExact(poly_coeff_t a, poly_coeff_t b) {
+  PolyCoeffView va;
+  PolyCoeffView vb;
+  PolyCoeffViewOf(a, &va);
+  PolyCoeffViewOf(b, &vb);
+
+  if(va.negative == vb.negative) {
+    if(va.size < vb.size) {
+      return PolyCoeffAddExact(b, a);
+    }
+    PolyCoeffBig* sum = PolyCoeffBigNew(va.size + 1);
+    uint64_t carry = 0;
+    for(int i=0;i<va.size;++i) {
+      carry += (uint64_t) va.limbs[i] + ((i < vb.size) ? vb.limbs[i] : 0);
+      sum->limbs[i] = (uint32_t) carry;
+      carry >>= POLY_COEFF_LIMB_BITS;
+    }
+    sum->limbs[va.size] = (uint32_t) carry;
+    return PolyCoeffBigNormalize(sum, va.negative);
+  }
+
+  // Numbers of different signs - the smaller magnitude is subtracted
+  const int cmp = PolyCoeffMagnitudeCompare(&va, &vb);
+  if(cmp == 0) return 0;
+  const PolyCoeffView* big = (cmp > 0) ? &va : &vb;
+  const PolyCoeffView* small = (cmp > 0) ? &vb : &va;
+  PolyCoeffBig* difference = PolyCoeffBigNew(big->size);
+  int64_t borrow = 0;
+  for(int i=0;i<big->size;++i) {
+    borrow += (int64_t) big->limbs[i] - ((i < small->size) ? small->limbs[i] : 0);
+    difference->limbs[i] = (uint32_t) borrow;
+    borrow = (borrow < 0) ? -1 : 0;
+  }
+  return PolyCoeffBigNormalize(difference, big->negative);
+}
+
+/*
+* Negate coefficient without modulus
+*/
+poly_coeff_t PolyCoeffNegExact(poly_coeff_t a) {
+  if(PolyCoeffIsSmall(a)) {
+    return PolyCoeffFromLong(-a);
+  }
+  // Only -2^62 is small among negations of large numbers
+  const PolyCoeffBig* big = PolyCoeffBigOf(a);
+  if(a > 0 && big->size == 2 && big->limbs[0] == 0 && big->limbs[1] == 1U << (62 - POLY_COEFF_LIMB_BITS)) {
+    return POLY_COEFF_SMALL_MIN;
+  }
+  // Sign is kept in the word, so the magnitude is shared
+  return ~PolyCoeffClone(a);
+}
+
+/*
+* Multiply two coefficients without modulus
+*/
+poly_coeff_t PolyCoeffMulExact(poly_coeff_t a, poly_coeff_t b) {
+  PolyCoeffView va;
+  PolyCoeffView vb;
+  PolyCoeffViewOf(a, &va);
+  PolyCoeffViewOf(b, &vb);
+  if(va.size == 0 || vb.size == 0) return 0;
+
+  PolyCoeffBig* product = PolyCoeffBigNew(va.size + vb.size);
+  memset(product->limbs, 0, product->size * sizeof(uint32_t));
+  for(int i=0;i<va.size;++i) {
+    uint64_t carry = 0;
+    for(int j=0;j<vb.size;++j) {
+      carry += (uint64_t) va.limbs[i] * vb.limbs[j] + product->limbs[i+j];
+      product->limbs[i+j] = (uint32_t) carry;
+      carry >>= POLY_COEFF_LIMB_BITS;
+    }
+    product->limbs[i+vb.size] = (uint32_t) carry;
+  }
+  return PolyCoeffBigNormalize(product, va.negative != vb.negative);
+}
+
+/*
+* Divides magnitude in place by small number returning the remainder
+*/
+static inline uint32_t PolyCoeffMagnitudeDivSmall(uint32_t* limbs, int size, uint32_t d) {
+  uint64_t remainder = 0;
+  for(int i=size-1;i>=0;--i) {
+    remainder = (remainder << POLY_COEFF_LIMB_BITS) | limbs[i];
+    limbs[i] = (uint32_t) (remainder / d);
+    remainder %= d;
+  }
+  return (uint32_t) remainder;
+}
+
+/*
+* Divide big coefficient by small positive number
+*/
+poly_coeff_t PolyCoeffBigDivExact(poly_coeff_t a, long d) {
+  assert(d > 0 && d <= (long) UINT32_MAX);
+  const PolyCoeffBig* big = PolyCoeffBigOf(a);
+  PolyCoeffBig* quotient = PolyCoeffBigNew(big->size);
+  memcpy(quotient->limbs, big->limbs, big->size * sizeof(uint32_t));
+  const uint32_t remainder = PolyCoeffMagnitudeDivSmall(quotient->limbs, quotient->size, (uint32_t) d);
+  assert(remainder == 0);
+  (void) remainder;
+  return PolyCoeffBigNormalize(quotient, a < 0);
+}
+
+/*
+* Compares magnitudes of two big coefficients of the same sign
+*/
+bool PolyCoeffBigIsEq(poly_coeff_t a, poly_coeff_t b) {
+  const PolyCoeffBig* ba = PolyCoeffBigOf(a);
+  const PolyCoeffBig* bb = PolyCoeffBigOf(b);
+  return ba->size == bb->size && memcmp(ba->limbs, bb->limbs, ba->size * sizeof(uint32_t)) == 0;
+}
+
+/*
+* Reduce big coefficient modulo @p mod
+*/
+poly_coeff_t PolyCoeffBigReduceMod(const PolyCoeffModulus* mod, poly_coeff_t value) {
+  const PolyCoeffBig* big = PolyCoeffBigOf(value);
+  const poly_coeff_t base = PolyCoeffReduceMod(mod, 1L << POLY_COEFF_LIMB_BITS);
+  poly_coeff_t result = 0;
+  for(int i=big->size-1;i>=0;--i) {
+    result = PolyCoeffAddMod(mod, PolyCoeffMulMod(mod, result, base),
+      PolyCoeffReduceMod(mod, big->limbs[i]));
+  }
+  return (value < 0 && result != 0) ? mod->value - result : result;
+}
+
+/*
+* Counts bits of magnitude of big coefficient
+*/
+int PolyCoeffBigBits(poly_coeff_t c) {
+  const PolyCoeffBig* big = PolyCoeffBigOf(c);
+  return big->size * POLY_COEFF_LIMB_BITS - __builtin_clz(big->limbs[big->size-1]);
+}
+
+/*
+* Prints decimal representation of coefficient to the given buffer
+*/
+int PolyCoeffSprintf(char* dest, poly_coeff_t c) {
+  if(PolyCoeffIsSmall(c)) {
+    return sprintf(dest, "%ld", c);
+  }
+
+  // Magnitude is split into decimal chunks (the least significant first)
+  const PolyCoeffBig* big = PolyCoeffBigOf(c);
+  uint32_t* limbs = MALLOCATE_ARRAY(uint32_t, big->size);
+  uint32_t* chunks = MALLOCATE_ARRAY(uint32_t, big->size * 2);
+  memcpy(limbs, big->limbs, big->size * sizeof(uint32_t));
+  int size = big->size;
+  int chunks_count = 0;
+  while(size > 0) {
+    chunks[chunks_count++] = PolyCoeffMagnitudeDivSmall(limbs, size, POLY_COEFF_DECIMAL_BASE);
+    while(size > 0 && limbs[size-1] == 0) --size;
+  }
+
+  int length = 0;
+  if(c < 0) {
+    dest[length++] = '-';
+  }
+  length += sprintf(dest + length, "%u", (unsigned) chunks[chunks_count-1]);
+  for(int i=chunks_count-2;i>=0;--i) {
+    length += sprintf(dest + length, "%09u", (unsigned) chunks[i]);
+  }
+  free(chunks);
+  free(limbs);
+  return length;
+}
+
+/*
+* Prints decimal representation of coefficient to the stdout
+*/
+void PolyCoeffPrint(poly_coeff_t c) {
+  if(PolyCoeffIsSmall(c)) {
+    printf("%ld", c);
+    return;
+  }
+  // Every limb takes less than 10 decimal digits
+  char* str = MALLOCATE_ARRAY(char, PolyCoeffBigOf(c)->size * 10 + 2);
+  PolyCoeffSprintf(str, c);
+  printf("%s", str);
+  free(str);
+}
@@ -0,0 +1,619 @@
+/** @file
+*  Arithmetic of polynomial coefficients.
+*
+*  Coefficients are integers of arbitrary precision, so the results
+*  of operations never overflow. The coefficients may be also computed
+*  modulo chosen number p (usually prime), so the results of large
+*  computations are exact in Z/pZ without any big numbers.
+*
+*  Every coefficient is a tagged machine word (poly_coeff_t).
+*  Numbers from range [POLY_COEFF_SMALL_MIN, POLY_COEFF_SMALL_MAX]
+*  are stored inline as plain integers, so they take no memory
+*  and the operations on them cost a few cycles more than on machine
+*  integers. Bigger numbers are handles of immutable, reference counted
+*  magnitudes (PolyCoeffBig) - the two highest bits of such word differ.
+*  The sign of the word is always the sign of the number, so coefficients
+*  can be compared with 0 directly.
+*
+*  Coefficients are values owned by polynomials: copies are made
+*  with PolyCoeffClone and released with PolyCoeffDestroy.
+*  The arithmetic functions never take ownership of their arguments
+*  and return new coefficients.
+*
+*  The modulus is set globally (PolyCoeffSetModulus) or at build time
+*  by defining POLY_COEFF_MODULUS. In modular mode all the coefficients
+*  are kept in range [0, p) and the products are reduced with
+*  Barrett reduction, so every operation takes a few cycles.
+*
+*  Usage:
+*  @code
+*     #include <poly_coeff.h>
+*      ...
+*     poly_coeff_t x = PolyCoeffPow(10, 30); // 10^30 (big number)
+*     PolyCoeffPrint(x);
+*     PolyCoeffDestroy(x);
+*
+*     PolyCoeffSetModulus(7);
+*     poly_coeff_t y = PolyCoeffMul(5, 4); // 20 mod 7 = 6
+*     poly_coeff_t z = PolyCoeffReduce(-1); // 6
+*     PolyCoeffSetModulus(0); // back to integers
+*  @endcode
+*
+*  @author Piotr Styczyński <piotrsty1@gmail.com>
+*  @copyright MIT
+*  @date 2017-05-13
+*/
+#include "utils.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "memalloc.h"
+
+#ifndef __STY_COMMON_POLY_COEFF_H__
+#define __STY_COMMON_POLY_COEFF_H__
+
+/** Type of polynomial coefficients (tagged word - see the file description) */
+typedef long poly_coeff_t;
+
+/**
+* @def POLY_COEFF_SMALL_MIN
+*
+* The lowest coefficient stored inline (without memory allocation).
+*/
+#define POLY_COEFF_SMALL_MIN (-(1L << 62))
+
+/**
+* @def POLY_COEFF_SMALL_MAX
+*
+* The highest coefficient stored inline (without memory allocation).
+*/
+#define POLY_COEFF_SMALL_MAX ((1L << 62) - 1)
+
+/**
+* @def POLY_COEFF_MODULUS
+*
+* Modulus used by coefficients arithmetic at program start
+* (0 means arithmetic of integers without modulus).
+*/
+#ifndef POLY_COEFF_MODULUS
+#define POLY_COEFF_MODULUS 0
+#endif
+
+/**
+* @def POLY_COEFF_MODULUS_MAX
+*
+* Maximum modulus of coefficients arithmetic.
+* Sum of two reduced coefficients and remainders of Barrett reduction
+* must fit in unsigned long.
+*/
+#define POLY_COEFF_MODULUS_MAX ((1L << 62) - 1)
+
+#if defined(__SIZEOF_INT128__)
+/** Unsigned integer holding product of two coefficients */
+__extension__ typedef unsigned __int128 PolyCoeffWide;
+#endif
+
+/**
+* Magnitude of coefficient that is not stored inline.
+* It's never modified after creation and shared by all the copies
+* of the coefficient.
+*/
+typedef struct PolyCoeffBig {
+  atomic_long refs; ///< Number of references (negative for copies living in arena)
+  int size; ///< Number of limbs (the highest one is not zero)
+  uint32_t limbs[]; ///< Limbs of magnitude (the least significant first)
+} PolyCoeffBig;
+
+/**
+* Modulus of coefficients with precomputed Barrett reduction factor.
+* For modulus p of n bits the factor is @f$\lfloor 4^n / p \rfloor@f$.
+*/
+typedef struct PolyCoeffModulus {
+  poly_coeff_t value; ///< Modulus (0 if arithmetic is not modular)
+  unsigned long barrett; ///< Barrett reduction factor
+  int bits; ///< Number of bits of the modulus
+} PolyCoeffModulus;
+
+/**
+* Modulus used by all the polynomial operations.
+* It must not be changed when any operation is running.
+*/
+extern PolyCoeffModulus PolyCoeffCurrentModulus;
+
+/**
+* Set modulus of coefficients arithmetic.
+* Already existing polynomials are not reduced (see PolyReduceCoeffs).
+*
+* @param[in] modulus : 0 or number from range [2, POLY_COEFF_MODULUS_MAX]
+*/
+void PolyCoeffSetModulus(poly_coeff_t modulus);
+
+/**
+* Get modulus of coefficients arithmetic.
+*
+* @return modulus (0 if arithmetic is not modular)
+*/
+static inline poly_coeff_t PolyCoeffGetModulus(void) {
+  return PolyCoeffCurrentModulus.value;
+}
+
+/**
+* Checks if coefficients are computed modulo some number.
+*
+* @return if arithmetic is modular
+*/
+static inline bool PolyCoeffIsModular(void) {
+  return PolyCoeffCurrentModulus.value != 0;
+}
+
+/**
+* Checks if coefficient is stored inline.
+*
+* @param[in] c : coefficient
+* @return if @p c is from range [POLY_COEFF_SMALL_MIN, POLY_COEFF_SMALL_MAX]
+*/
+static inline bool PolyCoeffIsSmall(poly_coeff_t c) {
+  return (unsigned long) c + (1UL << 62) < (1UL << 63);
+}
+
+/**
+* Gets magnitude of coefficient that is not stored inline.
+*
+* @param[in] c : big coefficient
+* @return magnitude of @p c
+*/
+static inline PolyCoeffBig* PolyCoeffBigOf(poly_coeff_t c) {
+  assert(!PolyCoeffIsSmall(c));
+  const unsigned long word = (c < 0) ? ~(unsigned long) c : (unsigned long) c;
+  return (PolyCoeffBig*) (uintptr_t) ((word & (unsigned long) POLY_COEFF_SMALL_MAX) << 1);
+}
+
+/**
+* Copies magnitude of big coefficient living in arena to the heap.
+*
+* @param[in] c : big coefficient
+* @return copy of @p c
+*/
+poly_coeff_t PolyCoeffBigCopy(poly_coeff_t c);
+
+/**
+* Frees magnitude of big coefficient.
+*
+* @param[in] big : magnitude without references
+*/
+void PolyCoeffBigFree(PolyCoeffBig* big);
+
+/**
+* Copies coefficient (O(1) for heap numbers).
+*
+* @param[in] c : coefficient
+* @return copy of @p c
+*/
+static inline poly_coeff_t PolyCoeffClone(poly_coeff_t c) {
+  if(PolyCoeffIsSmall(c)) return c;
+  PolyCoeffBig* big = PolyCoeffBigOf(c);
+  if(atomic_load_explicit(&(big->refs), memory_order_relaxed) < 0) {
+    return PolyCoeffBigCopy(c);
+  }
+  atomic_fetch_add_explicit(&(big->refs), 1, memory_order_relaxed);
+  return c;
+}
+
+/**
+* Releases coefficient.
+* Numbers stored inline and copies living in arena are not freed.
+*
+* @param[in] c : coefficient
+*/
+static inline void PolyCoeffDestroy(poly_coeff_t c) {
+  if(PolyCoeffIsSmall(c)) return;
+  PolyCoeffBig* big = PolyCoeffBigOf(c);
+  if(atomic_load_explicit(&(big->refs), memory_order_relaxed) < 0) return;
+  if(atomic_fetch_sub_explicit(&(big->refs), 1, memory_order_acq_rel) == 1) {
+    PolyCoeffBigFree(big);
+  }
+}
+
+/**
+* Assigns new value to the coefficient releasing the old one.
+*
+* @param[in] c     : coefficient to be assigned
+* @param[in] value : new value (its ownership is taken)
+*/
+static inline void PolyCoeffReplace(poly_coeff_t* c, poly_coeff_t value) {
+  PolyCoeffDestroy(*c);
+  *c = value;
+}
+
+/**
+* Copies coefficient into the arena.
+* The copy is never freed (it's released with the arena).
+*
+* @param[in] c     : coefficient
+* @param[in] arena : memory arena
+* @return copy of @p c
+*/
+poly_coeff_t PolyCoeffCloneToArena(poly_coeff_t c, MemArena* arena);
+
+/**
+* Creates big coefficient from machine integer.
+*
+* @param[in] value : number not stored inline
+* @return coefficient equal to @p value
+*/
+poly_coeff_t PolyCoeffBigFromLong(long value);
+
+/**
+* Creates coefficient from magnitude given as limbs.
+*
+* @param[in] limbs    : limbs of magnitude (the least significant first)
+* @param[in] size     : number of limbs (leading zero limbs are allowed)
+* @param[in] negative : is the coefficient negative
+* @return coefficient with the given sign and magnitude
+*/
+poly_coeff_t PolyCoeffFromLimbs(const uint32_t* limbs, int size, bool negative);
+
+/**
+* Creates coefficient from any machine integer.
+*
+* @param[in] value : number
+* @return coefficient equal to @p value
+*/
+static inline poly_coeff_t PolyCoeffFromLong(long value) {
+  return PolyCoeffIsSmall(value) ? value : PolyCoeffBigFromLong(value);
+}
+
+/**
+* Add two coefficients without modulus.
+*
+* @param[in] a : coefficient
+* @param[in] b : coefficient
+* @return `a + b`
+*/
+poly_coeff_t PolyCoeffAddExact(poly_coeff_t a, poly_coeff_t b);
+
+/**
+* Negate coefficient without modulus.
+*
+* @param[in] a : coefficient
+* @return `-a`
+*/
+poly_coeff_t PolyCoeffNegExact(poly_coeff_t a);
+
+/**
+* Multiply two coefficients without modulus.
+*
+* @param[in] a : coefficient
+* @param[in] b : coefficient
+* @return `a * b`
+*/
+poly_coeff_t PolyCoeffMulExact(poly_coeff_t a, poly_coeff_t b);
+
+/**
+* Divide big coefficient by small positive number.
+*
+* @param[in] a : big coefficient divisible by @p d
+* @param[in] d : number from range [1, 2^32)
+* @return `a / d`
+*/
+poly_coeff_t PolyCoeffBigDivExact(poly_coeff_t a, long d);
+
+/**
+* Compares magnitudes of two big coefficients of the same sign.
+*
+* @param[in] a : big coefficient
+* @param[in] b : big coefficient
+* @return if `a == b`
+*/
+bool PolyCoeffBigIsEq(poly_coeff_t a, poly_coeff_t b);
+
+/**
+* Reduce big coefficient modulo @p mod.
+*
+* @param[in] mod   : modulus
+* @param[in] value : big coefficient
+* @return reduced number
+*/
+poly_coeff_t PolyCoeffBigReduceMod(const PolyCoeffModulus* mod, poly_coeff_t value);
+
+/**
+* Counts bits of magnitude of big coefficient.
+*
+* @param[in] c : big coefficient
+* @return number of bits of `|c|`
+*/
+int PolyCoeffBigBits(poly_coeff_t c);
+
+/**
+* Reduce any number modulo @p mod to range [0, mod).
+*
+* @param[in] mod   : modulus
+* @param[in] value : number
+* @return reduced number
+*/
+static inline poly_coeff_t PolyCoeffReduceMod(const PolyCoeffModulus* mod, poly_coeff_t value) {
+  if((unsigned long) value < (unsigned long) mod->value) return value;
+  if(!PolyCoeffIsSmall(value)) return PolyCoeffBigReduceMod(mod, value);
+  value %= mod->value;
+  return (value < 0) ? value + mod->value : value;
+}
+
+/**
+* Add two reduced numbers modulo @p mod.
+*
+* @param[in] mod : modulus
+* @param[in] a   : number from range [0, mod)
+* @param[in] b   : number from range [0, mod)
+* @return `a + b mod p`
+*/
+static inline poly_coeff_t PolyCoeffAddMod(const PolyCoeffModulus* mod, poly_coeff_t a, poly_coeff_t b) {
+  const poly_coeff_t sum = a + b;
+  return (sum >= mod->value) ? sum - mod->value : sum;
+}
+
+/**
+* Multiply two reduced numbers modulo @p mod.
+*
+* @param[in] mod : modulus
+* @param[in] a   : number from range [0, mod)
+* @param[in] b   : number from range [0, mod)
+* @return `a * b mod p`
+*/
+static inline poly_coeff_t PolyCoeffMulMod(const PolyCoeffModulus* mod, poly_coeff_t a, poly_coeff_t b) {
+  const unsigned long p = (unsigned long) mod->value;
+#if defined(__SIZEOF_INT128__)
+  // The quotient is underestimated by at most 2
+  const PolyCoeffWide x = (PolyCoeffWide)(unsigned long) a * (unsigned long) b;
+  const PolyCoeffWide q = ((x >> (mod->bits - 1)) * mod->barrett) >> (mod->bits + 1);
+  unsigned long r = (unsigned long) (x - q * p);
+  while(r >= p) r -= p;
+  return (poly_coeff_t) r;
+#else
+  // Multiplication by doubling and adding (both values fit in 63 bits)
+  unsigned long r = 0;
+  unsigned long x = (unsigned long) a;
+  unsigned long y = (unsigned long) b;
+  while(y) {
+    if(y & 1) {
+      r += x;
+      if(r >= p) r -= p;
+    }
+    x += x;
+    if(x >= p) x -= p;
+    y >>= 1;
+  }
+  return (poly_coeff_t) r;
+#endif
+}
+
+/**
+* Reduce number using current modulus.
+* Without modulus the number is returned unchanged
+* (so the result is owned by the owner of @p value).
+*
+* @param[in] value : number
+* @return reduced number
+*/
+static inline poly_coeff_t PolyCoeffReduce(poly_coeff_t value) {
+  if(!PolyCoeffIsModular()) return value;
+  return PolyCoeffReduceMod(&PolyCoeffCurrentModulus, value);
+}
+
+/**
+* Checks if two coefficients are equal.
+*
+* @param[in] a : coefficient
+* @param[in] b : coefficient
+* @return if `a == b`
+*/
+static inline bool PolyCoeffIsEq(poly_coeff_t a, poly_coeff_t b) {
+  if(a == b) return true;
+  // Small numbers are never stored as big ones
+  if(PolyCoeffIsSmall(a) || PolyCoeffIsSmall(b) || (a < 0) != (b < 0)) return false;
+  return PolyCoeffBigIsEq(a, b);
+}
+
+/**
+* Counts bits of absolute value of coefficient.
+*
+* @param[in] c : coefficient
+* @return number of bits of `|c|` (0 for zero)
+*/
+static inline int PolyCoeffBits(poly_coeff_t c) {
+  if(!PolyCoeffIsSmall(c)) return PolyCoeffBigBits(c);
+  if(c == 0) return 0;
+  const unsigned long magnitude = (c < 0) ? 0UL - (unsigned long) c : (unsigned long) c;
+  return (int)(8 * sizeof(unsigned long)) - __builtin_clzl(magnitude);
+}
+
+/**
+* Add two coefficients.
+*
+* @param[in] a : coefficient
+* @param[in] b : coefficient
+* @return `a + b`
+*/
+static inline poly_coeff_t PolyCoeffAdd(poly_coeff_t a, poly_coeff_t b) {
+  if(PolyCoeffIsModular()) return PolyCoeffAddMod(&PolyCoeffCurrentModulus, a, b);
+  // Sum of two small numbers never overflows machine word
+  if(PolyCoeffIsSmall(a) && PolyCoeffIsSmall(b) && PolyCoeffIsSmall(a + b)) return a + b;
+  return PolyCoeffAddExact(a, b);
+}
+
+/**
+* Negate coefficient.
+*
+* @param[in] a : coefficient
+* @return `-a`
+*/
+static inline poly_coeff_t PolyCoeffNeg(poly_coeff_t a) {
+  if(PolyCoeffIsModular()) return (a == 0) ? 0 : PolyCoeffCurrentModulus.value - a;
+  if(PolyCoeffIsSmall(a) && a != POLY_COEFF_SMALL_MIN) return -a;
+  return PolyCoeffNegExact(a);
+}
+
+/**
+* Multiply two coefficients.
+*
+* @param[in] a : coefficient
+* @param[in] b : coefficient
+* @return `a * b`
+*/
+static inline poly_coeff_t PolyCoeffMul(poly_coeff_t a, poly_coeff_t b) {
+  if(PolyCoeffIsModular()) return PolyCoeffMulMod(&PolyCoeffCurrentModulus, a, b);
+  poly_coeff_t product;
+  if(PolyCoeffIsSmall(a) && PolyCoeffIsSmall(b)
+     && !__builtin_mul_overflow(a, b, &product) && PolyCoeffIsSmall(product)) {
+    return product;
+  }
+  return PolyCoeffMulExact(a, b);
+}
+
+/**
+* Divide coefficient by small positive number.
+* Used only without modulus.
+*
+* @param[in] a : coefficient divisible by @p d
+* @param[in] d : number from range [1, 2^32)
+* @return `a / d`
+*/
+static inline poly_coeff_t PolyCoeffDivExact(poly_coeff_t a, long d) {
+  assert(d > 0);
+  if(PolyCoeffIsSmall(a)) return a / d;
+  return PolyCoeffBigDivExact(a, d);
+}
+
+/**
+* Calculate power of coefficient (`0^0` is 1).
+*
+* @param[in] a   : coefficient
+* @param[in] exp : exponent (not negative)
+* @return `a^exp`
+*/
+static inline poly_coeff_t PolyCoeffPow(poly_coeff_t a, long exp) {
+  assert(exp >= 0);
+  poly_coeff_t result = PolyCoeffReduce(1);
+  poly_coeff_t base = PolyCoeffClone(a);
+  while(exp) {
+    if(exp & 1) {
+      PolyCoeffReplace(&result, PolyCoeffMul(result, base));
+    }
+    exp >>= 1;
+    if(exp) {
+      PolyCoeffReplace(&base, PolyCoeffMul(base, base));
+    }
+  }
+  PolyCoeffDestroy(base);
+  return result;
+}
+
+#if defined(__SIZEOF_INT128__)
+/** Machine integer holding sums of products of small coefficients */
+__extension__ typedef __int128 PolyCoeffAccValue;
+#else
+/** Machine integer holding sums of products of small coefficients */
+typedef long PolyCoeffAccValue;
+#endif
+
+/**
+* Accumulator of sum of products of coefficients (see PolyCoeffAccMulAdd).
+* Products of small coefficients are summed in the machine integer
+* (twice as wide as the coefficients if possible) and the sum is promoted
+* to the exact coefficient only when it's about to overflow.
+*/
+typedef struct PolyCoeffAcc {
+  PolyCoeffAccValue value; ///< Part of the sum kept in machine integer
+  poly_coeff_t spill; ///< Exact part of the sum (owned coefficient)
+} PolyCoeffAcc;
+
+/**
+* Creates coefficient from the machine integer of accumulator
+* which is not stored inline (see PolyCoeffAccSpill).
+*
+* @param[in] value : machine integer
+* @return coefficient
+*/
+poly_coeff_t PolyCoeffBigFromAccValue(PolyCoeffAccValue value);
+
+/**
+* Creates accumulator with zero sum.
+*
+* @return PolyCoeffAcc
+*/
+static inline PolyCoeffAcc PolyCoeffAccZero(void) {
+  return (PolyCoeffAcc) { .value = 0, .spill = 0 };
+}
+
+/**
+* Moves the machine integer part of the sum to its exact part.
+*
+* @param[in,out] acc : accumulator
+*/
+static inline void PolyCoeffAccSpill(PolyCoeffAcc* acc) {
+  if(acc->value == 0) return;
+  const poly_coeff_t value = (acc->value >= POLY_COEFF_SMALL_MIN && acc->value <= POLY_COEFF_SMALL_MAX)
+    ? (poly_coeff_t) acc->value : PolyCoeffBigFromAccValue(acc->value);
+  PolyCoeffReplace(&(acc->spill), PolyCoeffAdd(acc->spill, value));
+  PolyCoeffDestroy(value);
+  acc->value = 0;
+}
+
+/**
+* Adds product of two coefficients to the accumulator.
+* Products of small coefficients never allocate memory
+* unless the sum exceeds the machine integer.
+*
+* @param[in,out] acc : accumulator
+* @param[in]     a   : coefficient
+* @param[in]     b   : coefficient
+*/
+static inline void PolyCoeffAccMulAdd(PolyCoeffAcc* acc, poly_coeff_t a, poly_coeff_t b) {
+  PolyCoeffAccValue product;
+  PolyCoeffAccValue sum;
+  if(!PolyCoeffIsModular() && PolyCoeffIsSmall(a) && PolyCoeffIsSmall(b)
+     && !__builtin_mul_overflow((PolyCoeffAccValue) a, (PolyCoeffAccValue) b, &product)) {
+    if(!__builtin_add_overflow(acc->value, product, &sum)) {
+      acc->value = sum;
+      return;
+    }
+    PolyCoeffAccSpill(acc);
+    acc->value = product;
+    return;
+  }
+  const poly_coeff_t exact = PolyCoeffMul(a, b);
+  PolyCoeffReplace(&(acc->spill), PolyCoeffAdd(acc->spill, exact));
+  PolyCoeffDestroy(exact);
+}
+
+/**
+* Adds the sum of accumulator to the coefficient @p c
+* and resets the accumulator to zero.
+*
+* @param[in,out] acc : accumulator
+* @param[in,out] c   : coefficient
+*/
+static inline void PolyCoeffAccFlush(PolyCoeffAcc* acc, poly_coeff_t* c) {
+  PolyCoeffAccSpill(acc);
+  if(acc->spill == 0) return;
+  PolyCoeffReplace(c, PolyCoeffAdd(*c, acc->spill));
+  PolyCoeffReplace(&(acc->spill), 0);
+}
+
+/**
+* Prints decimal representation of coefficient to the given buffer.
+*
+* @param[in] dest : buffer
+* @param[in] c    : coefficient
+* @return number of printed characters (without terminating zero)
+*/
+int PolyCoeffSprintf(char* dest, poly_coeff_t c);
+
+/**
+* Prints decimal representation of coefficient to the stdout.
+*
+* @param[in] c : coefficient
+*/
+void PolyCoeffPrint(poly_coeff_t c);
+
+#endif /* __STY_COMMON_POLY_COEFF_H__ */
@@ -0,0 +1,366 @@
+/*
+*  Distributed representation of multivariate polynomials.
+*
+*  @author Piotr Styczyński <piotrsty1@gmail.com>
+*  @copyright MIT
+*  @date 2017-05-13
+*/
+#include "utils.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "memalloc.h"
+#include "poly_dist.h"
+
+/*
+* Counts variables of polynomial (its nesting depth)
+*/
+static int PolyDistVarsRec(const Poly* p) {
+  int result = 0;
+  LOOP_POLY(p, m) {
+    const int vars = PolyDistVarsRec(&(m->p)) + 1;
+    if(vars > result) result = vars;
+  }
+  return result;
+}
+
+/*
+* Largest exponent which fits in the field of @p bits bits
+* (and in poly_exp_t)
+*/
+static inline uint64_t PolyDistExpLimit(int bits) {
+  return (bits >= 31) ? (uint64_t) 0x7FFFFFFF : ((uint64_t) 1 << bits) - 1;
+}
+
+/*
+* Shift of exponent of variable @p var
+*/
+static inline int PolyDistShift(int vars, int bits, int var) {
+  return bits * (vars - 1 - var);
+}
+
+/*
+* Checks if exponents fit in fields of @p bits bits
+*/
+static bool PolyDistCanPackRec(const Poly* p, int bits) {
+  LOOP_POLY(p, m) {
+    if((uint64_t) m->exp > PolyDistExpLimit(bits)) return false;
+    if(!PolyDistCanPackRec(&(m->p), bits)) return false;
+  }
+  return true;
+}
+
+/*
+* Checks if polynomial can be converted (see poly_dist.h)
+*/
+bool PolyDistCanPack(const Poly* p) {
+  assert(p!=NULL);
+  const int vars = PolyDistVarsRec(p);
+  if(vars > POLY_DIST_MAX_VARS) return false;
+  return PolyDistCanPackRec(p, PolyDistBitsOf(vars));
+}
+
+/*
+* Counts (at most) number of terms of distributed form of polynomial
+*/
+static int PolyDistCountRec(const Poly* p) {
+  int result = (p->c != 0) ? 1 : 0;
+  LOOP_POLY(p, m) {
+    result += PolyDistCountRec(&(m->p));
+  }
+  return result;
+}
+
+/*
+* Appends term to the distributed polynomial.
+* Constant terms of nested levels with exponent 0 have the same
+* monomial as the constant term of the level above,
+* so such terms are merged.
+*/
+static inline void PolyDistPushTerm(PolyDist* d, uint64_t exps, poly_coeff_t c) {
+  if(d->size > 0 && d->terms[d->size-1].exps == exps) {
+    PolyDistTerm* last = &(d->terms[d->size-1]);
+    PolyCoeffReplace(&(last->c), PolyCoeffAdd(last->c, c));
+    if(last->c == 0) --(d->size);
+    return;
+  }
+  assert(d->size == 0 || d->terms[d->size-1].exps < exps);
+  d->terms[d->size++] = (PolyDistTerm) { .exps = exps, .c = PolyCoeffClone(c) };
+}
+
+/*
+* Appends terms of polynomial of variable @p var
+* with exponents of outer variables given by @p prefix
+*/
+static void PolyDistFromPolyRec(PolyDist* d, const Poly* p, int var, uint64_t prefix) {
+  if(p->c != 0) {
+    PolyDistPushTerm(d, prefix, p->c);
+  }
+  LOOP_POLY(p, m) {
+    const uint64_t exps = prefix | ((uint64_t) m->exp << PolyDistShift(d->vars, d->bits, var));
+    PolyDistFromPolyRec(d, &(m->p), var+1, exps);
+  }
+}
+
+/*
+* Converts nested polynomial to distributed one (see poly_dist.h)
+*/
+PolyDist PolyDistFromPoly(const Poly* p) {
+  assert(p!=NULL);
+  assert(PolyDistCanPack(p));
+  PolyDist d = PolyDistZero(PolyDistVarsRec(p));
+  const int count = PolyDistCountRec(p);
+  if(count == 0) return d;
+  d.terms = MALLOCATE_ARRAY(PolyDistTerm, count);
+  PolyDistFromPolyRec(&d, p, 0, 0);
+  return d;
+}
+
+/*
+* Builds nested polynomial of variable @p var
+* from the terms [@p begin, @p end) with the same outer exponents
+*/
+static Poly PolyDistToPolyRec(const PolyDist* d, int begin, int end, int var) {
+  if(var == d->vars) {
+    assert(end - begin == 1);
+    return PolyFromCoeff(PolyCoeffClone(d->terms[begin].c));
+  }
+  Poly result = PolyZero();
+  int i = begin;
+  while(i < end) {
+    const poly_exp_t exp = PolyDistExp(d, d->terms[i].exps, var);
+    int j = i + 1;
+    while(j < end && PolyDistExp(d, d->terms[j].exps, var) == exp) ++j;
+    PolyInsertMono(&result, (Mono) { .p = PolyDistToPolyRec(d, i, j, var+1), .exp = exp });
+    i = j;
+  }
+  return result;
+}
+
+/*
+* Converts distributed polynomial to nested one (see poly_dist.h)
+*/
+Poly PolyDistToPoly(const PolyDist* d) {
+  assert(d!=NULL);
+  if(d->size == 0) return PolyZero();
+  return PolyDistToPolyRec(d, 0, d->size, 0);
+}
+
+/*
+* Frees memory of distributed polynomial
+*/
+void PolyDistDestroy(PolyDist* d) {
+  assert(d!=NULL);
+  for(int i=0;i<d->size;++i) {
+    PolyCoeffDestroy(d->terms[i].c);
+  }
+  free(d->terms);
+  d->terms = NULL;
+  d->size = 0;
+}
+
+/*
+* Packs exponents of @p d into layout of @p vars variables
+* (not lower than the number of variables of @p d).
+* The order of monomials is kept, so the terms stay sorted.
+*/
+static inline uint64_t PolyDistRepack(const PolyDist* d, uint64_t exps, int vars, int bits) {
+  if(d->vars == vars) return exps;
+  uint64_t result = 0;
+  for(int var=0;var<d->vars;++var) {
+    const uint64_t exp = (uint64_t) PolyDistExp(d, exps, var);
+    assert(exp <= PolyDistExpLimit(bits));
+    result |= exp << PolyDistShift(vars, bits, var);
+  }
+  return result;
+}
+
+/*
+* Appends term with coefficient taken by the polynomial
+* (the array grows twice when it's full)
+*/
+static inline void PolyDistAppendTerm(PolyDist* d, int* alloc_size, uint64_t exps, poly_coeff_t c) {
+  if(d->size == *alloc_size) {
+    *alloc_size = (*alloc_size > 0) ? 2 * (*alloc_size) : 4;
+    d->terms = MREALLOCATE_ARRAY(PolyDistTerm, *alloc_size, d->terms);
+  }
+  d->terms[d->size++] = (PolyDistTerm) { .exps = exps, .c = c };
+}
+
+/*
+* Adds two distributed polynomials by merging their terms
+*/
+PolyDist PolyDistAdd(const PolyDist* p, const PolyDist* q) {
+  assert(p!=NULL);
+  assert(q!=NULL);
+  PolyDist result = PolyDistZero((p->vars > q->vars) ? p->vars : q->vars);
+  if(p->size + q->size == 0) return result;
+  int alloc_size = p->size + q->size;
+  result.terms = MALLOCATE_ARRAY(PolyDistTerm, alloc_size);
+
+  int i = 0;
+  int j = 0;
+  while(i < p->size || j < q->size) {
+    const uint64_t ep = (i < p->size) ? PolyDistRepack(p, p->terms[i].exps, result.vars, result.bits) : 0;
+    const uint64_t eq = (j < q->size) ? PolyDistRepack(q, q->terms[j].exps, result.vars, result.bits) : 0;
+    if(j >= q->size || (i < p->size && ep < eq)) {
+      PolyDistAppendTerm(&result, &alloc_size, ep, PolyCoeffClone(p->terms[i++].c));
+    } else if(i >= p->size || ep > eq) {
+      PolyDistAppendTerm(&result, &alloc_size, eq, PolyCoeffClone(q->terms[j++].c));
+    } else {
+      const poly_coeff_t c = PolyCoeffAdd(p->terms[i++].c, q->terms[j++].c);
+      if(c != 0) {
+        PolyDistAppendTerm(&result, &alloc_size, ep, c);
+      }
+    }
+  }
+  return result;
+}
+
+/*
+* Gets largest exponents of all variables in layout of @p vars variables
+*/
+static void PolyDistMaxExps(const PolyDist* d, int vars, uint64_t* max_exps) {
+  for(int var=0;var<vars;++var) {
+    max_exps[var] = 0;
+  }
+  for(int i=0;i<d->size;++i) {
+    for(int var=0;var<d->vars;++var) {
+      const uint64_t exp = (uint64_t) PolyDistExp(d, d->terms[i].exps, var);
+      if(exp > max_exps[var]) max_exps[var] = exp;
+    }
+  }
+}
+
+/*
+* Checks if product exponents fit in packed words (see poly_dist.h)
+*/
+bool PolyDistMulFits(const PolyDist* p, const PolyDist* q) {
+  assert(p!=NULL);
+  assert(q!=NULL);
+  const int vars = (p->vars > q->vars) ? p->vars : q->vars;
+  const uint64_t limit = PolyDistExpLimit(PolyDistBitsOf(vars));
+  uint64_t max_p[POLY_DIST_MAX_VARS];
+  uint64_t max_q[POLY_DIST_MAX_VARS];
+  PolyDistMaxExps(p, vars, max_p);
+  PolyDistMaxExps(q, vars, max_q);
+  for(int var=0;var<vars;++var) {
+    if(max_p[var] + max_q[var] > limit) return false;
+  }
+  return true;
+}
+
+/*
+* Entry of the multiplication heap - the product of
+* @p i-th term of the first polynomial with @p j-th term of the second one
+*/
+typedef struct PolyDistHeapEntry {
+  uint64_t exps; ///< Packed exponents of product (heap key)
+  int i; ///< Index of term of the first polynomial
+  int j; ///< Index of term of the second polynomial
+} PolyDistHeapEntry;
+
+/*
+* Restores heap property going down from @p index
+*/
+static inline void PolyDistHeapSiftDown(PolyDistHeapEntry* heap, int size, int index) {
+  const PolyDistHeapEntry entry = heap[index];
+  while(true) {
+    int child = 2*index + 1;
+    if(child >= size) break;
+    if(child + 1 < size && heap[child+1].exps < heap[child].exps) {
+      ++child;
+    }
+    if(heap[child].exps >= entry.exps) break;
+    heap[index] = heap[child];
+    index = child;
+  }
+  heap[index] = entry;
+}
+
+/*
+* Multiplies two distributed polynomials using heap over
+* the terms of the shorter one (Johnson's algorithm, see PolyMulHeap)
+*/
+PolyDist PolyDistMul(const PolyDist* p, const PolyDist* q) {
+  assert(p!=NULL);
+  assert(q!=NULL);
+  assert(PolyDistMulFits(p, q));
+  if(p->size > q->size) {
+    const PolyDist* tmp = p;
+    p = q;
+    q = tmp;
+  }
+  PolyDist result = PolyDistZero((p->vars > q->vars) ? p->vars : q->vars);
+  if(p->size == 0) return result;
+
+  // Exponents of products are sums of packed words
+  uint64_t* rows = MALLOCATE_ARRAY(uint64_t, p->size);
+  uint64_t* cols = MALLOCATE_ARRAY(uint64_t, q->size);
+  for(int i=0;i<p->size;++i) {
+    rows[i] = PolyDistRepack(p, p->terms[i].exps, result.vars, result.bits);
+  }
+  for(int j=0;j<q->size;++j) {
+    cols[j] = PolyDistRepack(q, q->terms[j].exps, result.vars, result.bits);
+  }
+
+  PolyDistHeapEntry* heap = MALLOCATE_ARRAY(PolyDistHeapEntry, p->size);
+  int heap_size = 0;
+  for(int i=0;i<p->size;++i) {
+    heap[heap_size++] = (PolyDistHeapEntry) { .exps = rows[i] + cols[0], .i = i, .j = 0 };
+  }
+  // Rows are sorted so the initial array is already a heap
+
+  int alloc_size = 0;
+  PolyCoeffAcc acc = PolyCoeffAccZero();
+  uint64_t acc_exps = heap[0].exps;
+  while(heap_size > 0) {
+    PolyDistHeapEntry* top = &heap[0];
+    if(top->exps != acc_exps) {
+      poly_coeff_t c = 0;
+      PolyCoeffAccFlush(&acc, &c);
+      if(c != 0) PolyDistAppendTerm(&result, &alloc_size, acc_exps, c);
+      acc_exps = top->exps;
+    }
+
+    PolyCoeffAccMulAdd(&acc, p->terms[top->i].c, q->terms[top->j].c);
+
+    if(top->j + 1 < q->size) {
+      ++(top->j);
+      top->exps = rows[top->i] + cols[top->j];
+    } else {
+      heap[0] = heap[--heap_size];
+    }
+    if(heap_size > 0) {
+      PolyDistHeapSiftDown(heap, heap_size, 0);
+    }
+  }
+  poly_coeff_t c = 0;
+  PolyCoeffAccFlush(&acc, &c);
+  if(c != 0) PolyDistAppendTerm(&result, &alloc_size, acc_exps, c);
+
+  free(heap);
+  free(rows);
+  free(cols);
+  return result;
+}
+
+/*
+* Checks equality of two distributed polynomials
+*/
+bool PolyDistIsEq(const PolyDist* p, const PolyDist* q) {
+  assert(p!=NULL);
+  assert(q!=NULL);
+  if(p->size != q->size) return false;
+  const int vars = (p->vars > q->vars) ? p->vars : q->vars;
+  const int bits = PolyDistBitsOf(vars);
+  for(int i=0;i<p->size;++i) {
+    if(PolyDistRepack(p, p->terms[i].exps, vars, bits) != PolyDistRepack(q, q->terms[i].exps, vars, bits)) {
+      return false;
+    }
+    if(!PolyCoeffIsEq(p->terms[i].c, q->terms[i].c)) {
+      return false;
+    }
+  }
+  return true;
+}
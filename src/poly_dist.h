@@ -0,0 +1,189 @@
+/** @file
+*  Distributed representation of multivariate polynomials.
+*
+*  Polynomial is a flat array of terms sorted by monomials.
+*  Every term is a pair of coefficient and the exponent vector
+*  packed into a single 64-bit word, so that:
+*    - the terms take no allocations per variable (as nested Poly does)
+*    - monomials are compared with single integer comparison
+*    - monomials are multiplied with single integer addition
+*
+*  Exponent of variable x_i is stored in a field of PolyDist.bits bits.
+*  Fields are ordered from x_0 (the most significant one), so the order
+*  of packed words is the lexicographic order of monomials - the same
+*  as the order of terms of nested polynomial (see poly.h).
+*
+*  Usage:
+*  @code
+*     #include <poly_dist.h>
+*      ...
+*     PolyDist d = PolyDistFromPoly(&p);
+*     PolyDist sq = PolyDistMul(&d, &d);
+*     Poly q = PolyDistToPoly(&sq);
+*     PolyDistDestroy(&d);
+*     PolyDistDestroy(&sq);
+*  @endcode
+*
+*  @author Piotr Styczyński <piotrsty1@gmail.com>
+*  @copyright MIT
+*  @date 2017-05-13
+*/
+#include "utils.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "poly.h"
+
+#ifndef __STY_COMMON_POLY_DIST_H__
+#define __STY_COMMON_POLY_DIST_H__
+
+/**
+* @def POLY_DIST_MAX_VARS
+*
+* Maximum number of variables of distributed polynomial
+* (every variable takes at least one bit of packed word).
+*/
+#define POLY_DIST_MAX_VARS 64
+
+/**
+* Single term of distributed polynomial
+*/
+typedef struct PolyDistTerm {
+  uint64_t exps; ///< Packed exponents of variables
+  poly_coeff_t c; ///< Coefficient (owned by the term)
+} PolyDistTerm;
+
+/**
+* Polynomial stored as the array of terms
+* sorted by packed exponents (rising).
+* Terms have nonzero coefficients and different monomials.
+*/
+typedef struct PolyDist {
+  PolyDistTerm* terms; ///< Terms of polynomial
+  int size; ///< Number of terms
+  int vars; ///< Number of variables
+  int bits; ///< Number of bits of exponent of single variable
+} PolyDist;
+
+/**
+* Number of bits of exponent of single variable
+* used when packing exponents of @p vars variables.
+*
+* @param[in] vars : number of variables
+* @return number of bits
+*/
+static inline int PolyDistBitsOf(int vars) {
+  assert(vars >= 0 && vars <= POLY_DIST_MAX_VARS);
+  return (vars <= 2) ? 32 : 64 / vars;
+}
+
+/**
+* Creates zero polynomial of @p vars variables.
+*
+* @param[in] vars : number of variables
+* @return zero polynomial
+*/
+static inline PolyDist PolyDistZero(int vars) {
+  return (PolyDist) { .terms = NULL, .size = 0, .vars = vars, .bits = PolyDistBitsOf(vars) };
+}
+
+/**
+* Get exponent of variable @p var of packed monomial.
+*
+* @param[in] d    : distributed polynomial (layout of packed word)
+* @param[in] exps : packed exponents
+* @param[in] var  : index of variable
+* @return exponent
+*/
+static inline poly_exp_t PolyDistExp(const PolyDist* d, uint64_t exps, int var) {
+  assert(var >= 0 && var < d->vars);
+  const int shift = d->bits * (d->vars - 1 - var);
+  const uint64_t mask = (d->bits == 64) ? ~(uint64_t) 0 : ((uint64_t) 1 << d->bits) - 1;
+  return (poly_exp_t) ((exps >> shift) & mask);
+}
+
+/**
+* Compares packed monomials of the same layout.
+*
+* @param[in] a : packed exponents
+* @param[in] b : packed exponents
+* @return -1, 0 or 1 if @p a is lower, equal or higher than @p b
+*/
+static inline int PolyDistMonoCompare(uint64_t a, uint64_t b) {
+  return (a > b) - (a < b);
+}
+
+/**
+* Checks if exponents of polynomial fit in the packed words
+* (see PolyDistFromPoly).
+*
+* @param[in] p : polynomial
+* @return if @p p can be converted to distributed polynomial
+*/
+bool PolyDistCanPack(const Poly* p);
+
+/**
+* Converts nested polynomial to distributed polynomial.
+* The exponents must fit in the packed words (see PolyDistCanPack).
+* Coefficients are copied.
+*
+* @param[in] p : polynomial
+* @return distributed polynomial
+*/
+PolyDist PolyDistFromPoly(const Poly* p);
+
+/**
+* Converts distributed polynomial to nested polynomial.
+* Coefficients are copied.
+*
+* @param[in] d : distributed polynomial
+* @return polynomial
+*/
+Poly PolyDistToPoly(const PolyDist* d);
+
+/**
+* Frees memory of distributed polynomial.
+*
+* @param[in,out] d : distributed polynomial
+*/
+void PolyDistDestroy(PolyDist* d);
+
+/**
+* Adds two distributed polynomials (the result has more variables of both).
+*
+* @param[in] p : distributed polynomial
+* @param[in] q : distributed polynomial
+* @return `p + q`
+*/
+PolyDist PolyDistAdd(const PolyDist* p, const PolyDist* q);
+
+/**
+* Checks if exponents of product of polynomials fit in the packed words.
+*
+* @param[in] p : distributed polynomial
+* @param[in] q : distributed polynomial
+* @return if PolyDistMul can multiply @p p and @p q
+*/
+bool PolyDistMulFits(const PolyDist* p, const PolyDist* q);
+
+/**
+* Multiplies two distributed polynomials using heap of products
+* (see PolyMul). Monomials of products are sums of packed words,
+* so the exponents of product must fit in them (see PolyDistMulFits).
+*
+* @param[in] p : distributed polynomial
+* @param[in] q : distributed polynomial
+* @return `p * q`
+*/
+PolyDist PolyDistMul(const PolyDist* p, const PolyDist* q);
+
+/**
+* Checks equality of two distributed polynomials.
+*
+* @param[in] p : distributed polynomial
+* @param[in] q : distributed polynomial
+* @return `p = q`
+*/
+bool PolyDistIsEq(const PolyDist* p, const PolyDist* q);
+
+#endif /* __STY_COMMON_POLY_DIST_H__ */
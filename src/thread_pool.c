@@ -0,0 +1,271 @@
+/*
+*  Work-stealing pool of threads for fork-join parallelism.
+*
+*  @author Piotr Styczyński <piotrsty1@gmail.com>
+*  @copyright MIT
+*  @date 2017-05-13
+*/
+#include "utils.h"
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include "memalloc.h"
+#include "thread_pool.h"
+
+/*
+* Initial capacity of the deque of tasks (must be power of 2)
+*/
+#define THREAD_POOL_DEQUE_INITIAL_SIZE 64
+
+/*
+* Single submitted task
+*/
+typedef struct ThreadPoolTask {
+  ThreadPoolTaskFunction fn; ///< Task function
+  void* arg; ///< Argument of the function
+  ThreadPoolGroup* group; ///< Group of the task
+} ThreadPoolTask;
+
+/*
+* Deque of tasks (cyclic buffer)
+* The owner uses its bottom (tail) and thieves take tasks from the top (head).
+*/
+typedef struct ThreadPoolDeque {
+  pthread_mutex_t lock; ///< Lock guarding the deque
+  ThreadPoolTask* tasks; ///< Cyclic buffer of tasks
+  int head; ///< Index of the oldest task
+  int size; ///< Number of tasks
+  int alloc_size; ///< Capacity of the buffer
+} ThreadPoolDeque;
+
+/*
+* Argument of pool thread function
+*/
+typedef struct ThreadPoolWorker {
+  ThreadPool* pool; ///< Pool of the thread
+  int index; ///< Index of the thread deque
+} ThreadPoolWorker;
+
+struct ThreadPool {
+  int threads; ///< Number of threads (including the waiting thread)
+  pthread_t* handles; ///< Started threads
+  ThreadPoolWorker* workers; ///< Arguments of started threads
+  ThreadPoolDeque* deques; ///< Deques of tasks (index 0 is shared by non-pool threads)
+  atomic_int queued; ///< Number of tasks in all deques
+  bool stop; ///< Should the threads exit?
+  pthread_mutex_t sleep_lock; ///< Lock of sleeping threads
+  pthread_cond_t sleep_cond; ///< Condition sleeping threads wait for
+};
+
+/*
+* Pool and deque index of the current thread
+*/
+static _Thread_local ThreadPool* ThreadPoolCurrent = NULL;
+static _Thread_local int ThreadPoolCurrentIndex = 0;
+
+/*
+* Get index of the deque owned by the calling thread
+*/
+static inline int ThreadPoolSelfIndex(const ThreadPool* pool) {
+  return (ThreadPoolCurrent == pool) ? ThreadPoolCurrentIndex : 0;
+}
+
+/*
+* Push task at the bottom of the deque
+*/
+static void ThreadPoolDequePush(ThreadPoolDeque* deque, ThreadPoolTask task) {
+  pthread_mutex_lock(&(deque->lock));
+  if(deque->size == deque->alloc_size) {
+    const int new_size = deque->alloc_size * 2;
+    ThreadPoolTask* tasks = MALLOCATE_ARRAY(ThreadPoolTask, new_size);
+    for(int i=0;i<deque->size;++i) {
+      tasks[i] = deque->tasks[(deque->head + i) & (deque->alloc_size - 1)];
+    }
+    free(deque->tasks);
+    deque->tasks = tasks;
+    deque->head = 0;
+    deque->alloc_size = new_size;
+  }
+  deque->tasks[(deque->head + deque->size) & (deque->alloc_size - 1)] = task;
+  ++(deque->size);
+  pthread_mutex_unlock(&(deque->lock));
+}
+
+/*
+* Take task from the bottom (newest task) or from the top (oldest task)
+* of the deque. Returns false if the deque is empty.
+*/
+static bool ThreadPoolDequeTake(ThreadPoolDeque* deque, bool bottom, ThreadPoolTask* task) {
+  pthread_mutex_lock(&(deque->lock));
+  if(deque->size == 0) {
+    pthread_mutex_unlock(&(deque->lock));
+    return false;
+  }
+  if(bottom) {
+    *task = deque->tasks[(deque->head + deque->size - 1) & (deque->alloc_size - 1)];
+  } else {
+    *task = deque->tasks[deque->head];
+    deque->head = (deque->head + 1) & (deque->alloc_size - 1);
+  }
+  --(deque->size);
+  pthread_mutex_unlock(&(deque->lock));
+  return true;
+}
+
+/*
+* Find task for the thread owning deque @p self
+* (own tasks are taken first then the other deques are robbed)
+*/
+static bool ThreadPoolFindTask(ThreadPool* pool, int self, ThreadPoolTask* task) {
+  if(atomic_load(&(pool->queued)) == 0) return false;
+  bool found = ThreadPoolDequeTake(&(pool->deques[self]), true, task);
+  for(int i=1;i<pool->threads && !found;++i) {
+    found = ThreadPoolDequeTake(&(pool->deques[(self + i) % pool->threads]), false, task);
+  }
+  if(found) {
+    atomic_fetch_sub(&(pool->queued), 1);
+  }
+  return found;
+}
+
+/*
+* Execute task and mark it as done in its group
+*/
+static inline void ThreadPoolRun(ThreadPoolTask* task) {
+  task->fn(task->arg);
+  atomic_fetch_sub_explicit(&(task->group->pending), 1, memory_order_release);
+}
+
+/*
+* Main function of pool threads
+*/
+static void* ThreadPoolWorkerMain(void* arg) {
+  ThreadPoolWorker* worker = arg;
+  ThreadPool* pool = worker->pool;
+  ThreadPoolCurrent = pool;
+  ThreadPoolCurrentIndex = worker->index;
+
+  ThreadPoolTask task;
+  while(true) {
+    if(ThreadPoolFindTask(pool, worker->index, &task)) {
+      ThreadPoolRun(&task);
+      continue;
+    }
+    pthread_mutex_lock(&(pool->sleep_lock));
+    while(atomic_load(&(pool->queued)) == 0 && !pool->stop) {
+      pthread_cond_wait(&(pool->sleep_cond), &(pool->sleep_lock));
+    }
+    const bool stop = pool->stop;
+    pthread_mutex_unlock(&(pool->sleep_lock));
+    if(stop) break;
+  }
+  return NULL;
+}
+
+/*
+* Create new pool of threads (see thread_pool.h)
+*/
+ThreadPool* ThreadPoolNew(int threads) {
+  assert(threads >= 1);
+  ThreadPool* pool = MALLOCATE(ThreadPool);
+  pool->threads = threads;
+  pool->stop = false;
+  atomic_init(&(pool->queued), 0);
+  pthread_mutex_init(&(pool->sleep_lock), NULL);
+  pthread_cond_init(&(pool->sleep_cond), NULL);
+
+  pool->deques = MALLOCATE_ARRAY(ThreadPoolDeque, threads);
+  for(int i=0;i<threads;++i) {
+    ThreadPoolDeque* deque = &(pool->deques[i]);
+    pthread_mutex_init(&(deque->lock), NULL);
+    deque->tasks = MALLOCATE_ARRAY(ThreadPoolTask, THREAD_POOL_DEQUE_INITIAL_SIZE);
+    deque->head = 0;
+    deque->size = 0;
+    deque->alloc_size = THREAD_POOL_DEQUE_INITIAL_SIZE;
+  }
+
+  pool->handles = NULL;
+  pool->workers = NULL;
+  if(threads > 1) {
+    pool->handles = MALLOCATE_ARRAY(pthread_t, threads - 1);
+    pool->workers = MALLOCATE_ARRAY(ThreadPoolWorker, threads - 1);
+    for(int i=1;i<threads;++i) {
+      pool->workers[i-1] = (ThreadPoolWorker) { .pool = pool, .index = i };
+      const int status = pthread_create(&(pool->handles[i-1]), NULL, ThreadPoolWorkerMain, &(pool->workers[i-1]));
+      assert(status == 0);
+      (void)status;
+    }
+  }
+  return pool;
+}
+
+/*
+* Stop threads of the pool and free its memory
+*/
+void ThreadPoolDestroy(ThreadPool* pool) {
+  if(pool == NULL) return;
+  assert(atomic_load(&(pool->queued)) == 0);
+
+  pthread_mutex_lock(&(pool->sleep_lock));
+  pool->stop = true;
+  pthread_cond_broadcast(&(pool->sleep_cond));
+  pthread_mutex_unlock(&(pool->sleep_lock));
+  for(int i=1;i<pool->threads;++i) {
+    pthread_join(pool->handles[i-1], NULL);
+  }
+
+  for(int i=0;i<pool->threads;++i) {
+    pthread_mutex_destroy(&(pool->deques[i].lock));
+    free(pool->deques[i].tasks);
+  }
+  pthread_mutex_destroy(&(pool->sleep_lock));
+  pthread_cond_destroy(&(pool->sleep_cond));
+  free(pool->deques);
+  free(pool->handles);
+  free(pool->workers);
+  free(pool);
+}
+
+/*
+* Get number of threads of the pool
+*/
+int ThreadPoolThreads(const ThreadPool* pool) {
+  assert(pool != NULL);
+  return pool->threads;
+}
+
+/*
+* Submit task to the deque of the calling thread
+*/
+void ThreadPoolSubmit(ThreadPool* pool, ThreadPoolGroup* group, ThreadPoolTaskFunction fn, void* arg) {
+  assert(pool != NULL);
+  assert(group != NULL);
+  atomic_fetch_add(&(group->pending), 1);
+  atomic_fetch_add(&(pool->queued), 1);
+  ThreadPoolDequePush(&(pool->deques[ThreadPoolSelfIndex(pool)]),
+    (ThreadPoolTask) { .fn = fn, .arg = arg, .group = group });
+
+  if(pool->threads > 1) {
+    pthread_mutex_lock(&(pool->sleep_lock));
+    pthread_cond_signal(&(pool->sleep_cond));
+    pthread_mutex_unlock(&(pool->sleep_lock));
+  }
+}
+
+/*
+* Wait for the group executing pending tasks in the meantime
+*/
+void ThreadPoolWait(ThreadPool* pool, ThreadPoolGroup* group) {
+  assert(pool != NULL);
+  assert(group != NULL);
+  const int self = ThreadPoolSelfIndex(pool);
+  ThreadPoolTask task;
+  while(atomic_load_explicit(&(group->pending), memory_order_acquire) > 0) {
+    if(ThreadPoolFindTask(pool, self, &task)) {
+      ThreadPoolRun(&task);
+    } else {
+      sched_yield();
+    }
+  }
+}
@@ -0,0 +1,119 @@
+/** @file
+*  Work-stealing pool of threads for fork-join parallelism.
+*
+*  Every thread of the pool has its own deque of tasks.
+*  The thread pushes and pops tasks at the bottom of its deque
+*  and idle threads steal the oldest tasks from the top of other deques.
+*  Tasks are submitted in groups and the thread waiting for the group
+*  executes pending tasks instead of blocking, so tasks may safely
+*  submit and wait for their own subtasks.
+*
+*  Usage:
+*  @code
+*     #include <thread_pool.h>
+*      ...
+*     void Square(void* arg) {
+*       long* x = arg;
+*       *x = (*x) * (*x);
+*     }
+*      ...
+*     ThreadPool* pool = ThreadPoolNew(4);
+*     ThreadPoolGroup group = ThreadPoolGroupNew();
+*     long values[] = { 1, 2, 3 };
+*
+*     for(int i=0;i<3;++i) {
+*       ThreadPoolSubmit(pool, &group, Square, &values[i]);
+*     }
+*     ThreadPoolWait(pool, &group);
+*     // values = { 1, 4, 9 }
+*
+*     ThreadPoolDestroy(pool);
+*  @endcode
+*
+*  @author Piotr Styczyński <piotrsty1@gmail.com>
+*  @copyright MIT
+*  @date 2017-05-13
+*/
+#include "utils.h"
+#include <stdatomic.h>
+
+#ifndef __STY_COMMON_THREAD_POOL_H__
+#define __STY_COMMON_THREAD_POOL_H__
+
+/**
+* Pool of threads (the structure is opaque)
+*/
+typedef struct ThreadPool ThreadPool;
+
+/**
+* Function executed as a task
+*/
+typedef void (*ThreadPoolTaskFunction)(void* arg);
+
+/**
+* Group of tasks that can be waited for
+*/
+typedef struct ThreadPoolGroup {
+  atomic_int pending; ///< Number of not finished tasks of the group
+} ThreadPoolGroup;
+
+/**
+* Create new empty group of tasks.
+*
+* @return ThreadPoolGroup
+*/
+static inline ThreadPoolGroup ThreadPoolGroupNew() {
+  ThreadPoolGroup group;
+  atomic_init(&(group.pending), 0);
+  return group;
+}
+
+/**
+* Create new pool of threads.
+* The thread waiting for tasks (ThreadPoolWait) works as one of the
+* pool threads, so only `threads - 1` new threads are started.
+* For @p threads equal to 1 all the tasks are executed by the waiting thread.
+*
+* @param[in] threads : Number of threads (at least 1)
+* @return ThreadPool
+*/
+ThreadPool* ThreadPoolNew(int threads);
+
+/**
+* Stop all threads of the pool and free its memory.
+* There must be no pending tasks.
+*
+* @param[in] pool : ThreadPool
+*/
+void ThreadPoolDestroy(ThreadPool* pool);
+
+/**
+* Get number of threads of the pool.
+*
+* @param[in] pool : ThreadPool
+* @return number of threads
+*/
+int ThreadPoolThreads(const ThreadPool* pool);
+
+/**
+* Submit task to the pool.
+* The task is pushed to the deque of the calling thread
+* (or the shared deque if the caller is not a pool thread).
+*
+* @param[in] pool  : ThreadPool
+* @param[in] group : Group of the task
+* @param[in] fn    : Task function
+* @param[in] arg   : Argument passed to the task function
+*/
+void ThreadPoolSubmit(ThreadPool* pool, ThreadPoolGroup* group, ThreadPoolTaskFunction fn, void* arg);
+
+/**
+* Wait for all the tasks of the group.
+* The calling thread executes pending tasks while waiting.
+*
+* @param[in] pool  : ThreadPool
+* @param[in] group : Group of tasks
+*/
+void ThreadPoolWait(ThreadPool* pool, ThreadPoolGroup* group);
+
+#endif /* __STY_COMMON_THREAD_POOL_H__ */
@@ -68,6 +68,14 @@
 #undef getchar
 #endif /* getchar */
 
+#ifdef read
+#undef read
+#endif /* read */
+
+#ifdef write
+#undef write
+#endif /* write */
+
 #ifdef scanf
 #undef scanf
 #endif /* scanf */
@@ -123,6 +131,21 @@ extern int mock_printf(const char *format, ...);
 #define getchar() mock_getchar()
 extern int mock_getchar();
 
+/*
+* Redirect reading of standard input descriptor
+* to the same buffer as getchar.
+*/
+#include <unistd.h>
+#define read(fd, buf, count) mock_read(fd, buf, count)
+extern ssize_t mock_read(int fd, void* buf, size_t count);
+
+/*
+* Redirect writing to standard output descriptor
+* to the same buffer as printf.
+*/
+#define write(fd, buf, count) mock_write(fd, buf, count)
+extern ssize_t mock_write(int fd, const void* buf, size_t count);
+
 #define scanf(...) mock_scanf(__VA_ARGS__)
 extern int mock_scanf(const char *format, ...);
 
@@ -26,6 +26,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <unistd.h>
 
 /*
 * Export code only if its UNIT_TESTING mode
@@ -76,6 +77,28 @@ int mock_getchar() {
   return c;
 }
 
+/* Mocked read that reads standard input from scanf_buffer */
+ssize_t mock_read(int fd, void* buf, size_t count) {
+  if(fd != STDIN_FILENO) return read(fd, buf, count);
+  size_t result = 0;
+  char* out = (char*) buf;
+  while(result < count) {
+    const int c = mock_getchar();
+    if(c == EOF) break;
+    out[result++] = (char) c;
+  }
+  return (ssize_t) result;
+}
+
+/* Mocked write that writes standard output to printf_buffer */
+ssize_t mock_write(int fd, const void* buf, size_t count) {
+  if(fd != STDOUT_FILENO) return write(fd, buf, count);
+  assert_true((size_t)printf_position + count < sizeof(printf_buffer));
+  memcpy(printf_buffer + printf_position, buf, count);
+  printf_position += (int) count;
+  return (ssize_t) count;
+}
+
 /* Mocked printf that writes to printf_buffer */
 int mock_printf(const char *format, ...) {
     int return_value;
@@ -54,6 +54,11 @@
 
 #include "utils.h" // Install traps
 #include "poly.h"  // All includes here are now trapped
+#include "poly_dist.h"
+#include "input_buffer.h"
+#include "output_buffer.h"
+#include "poly_binary.h"
+#include "calc_interpreter.h"
 
 #define DISABLE_TRAPS // Uninstall traps now
 #include "utils.h"    // Uninstall traps
@@ -104,6 +109,30 @@ int mock_scanf(const char *format, ...);
  */
 int mock_getchar();
 
+/**
+ * Read function trap.
+ * Returns data of standard input from internal buffer
+ * (other descriptors are read as usual).
+ *
+ * @param  fd    : File descriptor
+ * @param  buf   : Buffer to read to
+ * @param  count : Maximum number of bytes to read
+ * @return (as read) number of read bytes.
+ */
+ssize_t mock_read(int fd, void* buf, size_t count);
+
+/**
+ * Write function trap.
+ * Captures standard output and stores in the same buffer as printf
+ * (other descriptors are written as usual).
+ *
+ * @param  fd    : File descriptor
+ * @param  buf   : Bytes to write
+ * @param  count : Number of bytes to write
+ * @return (as write) number of written bytes.
+ */
+ssize_t mock_write(int fd, const void* buf, size_t count);
+
 /**
  * Printf function trap.
  * Captures output and stores in internal buffer.
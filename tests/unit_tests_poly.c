@@ -1,6 +1,7 @@
 /*
 * Unit tests for COMPOSE functionality.
 */
+#include <limits.h>
 #include "test_utils.h"
 
 /*
@@ -152,6 +153,66 @@ static void test_compose_fn_poly_linear_count_1_linear(void **state) {
     );
 }
 
+/*
+* Single test of PolyCompose
+*   description:        composition of exponents with gaps
+*   input:
+*      p:                3 + 2x^2 + y*x^5
+*      count:            2
+*      components:      [ 1+x, 2 ]
+*   expected output:     7 + 14x + 22x^2 + 20x^3 + 10x^4 + 2x^5
+*/
+static void test_compose_fn_poly_gaps_count_2(void **state) {
+    (void)state;
+    test_compose_fn_helper(
+      PolyP(PolyC(3), 0, PolyC(2), 2, PolyP(PolyC(1), 1), 5),
+      2,
+      PolyL(PolyP(PolyC(1), 0, PolyC(1), 1), PolyC(2)),
+      PolyP(PolyC(7), 0, PolyC(14), 1, PolyC(22), 2, PolyC(20), 3, PolyC(10), 4, PolyC(2), 5)
+    );
+}
+
+/*
+* Single test of PolyComposeParallel
+*   description:        parallel composition gives the same result
+*                       as the serial one
+*   input:
+*      p:                sum of ((i+1) + y^(i%3)*z)*x^(2i) for i < 2*T
+*                        plus sum of j*y^j for 3 <= j < T+3 at x^10
+*                        (T = POLY_COMPOSE_PARALLEL_THRESHOLD)
+*      count:            3
+*      components:      [ 1-x, 2+x^2, y ]
+*/
+static void test_compose_fn_parallel(void **state) {
+    (void)state;
+    // Both the top level and one of its sub-levels are split into ranges
+    Poly p = PolyZero();
+    for(int i=0;i<2*POLY_COMPOSE_PARALLEL_THRESHOLD;++i) {
+        Poly coeff = PolyC(i+1);
+        PolyInsertMono(&coeff, (Mono){ .p = PolyP(PolyC(1), 1), .exp = i%3 });
+        if(i == 5) {
+            for(int j=3;j<POLY_COMPOSE_PARALLEL_THRESHOLD+3;++j) {
+                PolyInsertMono(&coeff, (Mono){ .p = PolyC(j), .exp = j });
+            }
+        }
+        PolyInsertMono(&p, (Mono){ .p = coeff, .exp = 2*i });
+    }
+    Poly x[] = { PolyP(PolyC(1), 0, PolyC(-1), 1), PolyP(PolyC(2), 0, PolyC(1), 2), PolyP(PolyC(1), 1) };
+
+    ThreadPool* pool = ThreadPoolNew(1);
+    Poly result = PolyComposeParallel(&p, 3, x, pool);
+    Poly expected = PolyCompose(&p, 3, x);
+    assert_poly_equal(&result, &expected);
+    ThreadPoolDestroy(pool);
+
+    PolyDestroy(&p);
+    PolyDestroy(&result);
+    PolyDestroy(&expected);
+    for(int i=0;i<3;++i) {
+        PolyDestroy(&x[i]);
+    }
+}
+
 /*
 * Single test of calculator op COMPOSE
 *   description:        single calculator composition test
@@ -323,6 +384,1230 @@ static void test_parser_compose_count_letters_digits_combination(void **state) {
     );
 }
 
+/*
+* Single test of monomials storage
+*   description:        monomials given in any order are stored
+*                       sorted and merged by exponent
+*   input:
+*      monos:           [ 3x^5, 2x^1, -3x^5, 4x^2, 1x^1 ]
+*   expected output:     3x + 4x^2
+*/
+static void test_storage_add_monos_unsorted(void **state) {
+    (void)state;
+    Mono monos[] = {
+      (Mono){ .p = PolyC(3), .exp = 5 },
+      (Mono){ .p = PolyC(2), .exp = 1 },
+      (Mono){ .p = PolyC(-3), .exp = 5 },
+      (Mono){ .p = PolyC(4), .exp = 2 },
+      (Mono){ .p = PolyC(1), .exp = 1 }
+    };
+    Poly result = PolyAddMonos(ARRAY_LENGTH(monos), monos);
+    Poly expected = PolyP(PolyC(3), 1, PolyC(4), 2);
+    assert_int_equal(PolyMonosCount(&result), 2);
+    assert_int_equal(PolyBegin(&result)[0].exp, 1);
+    assert_int_equal(PolyBegin(&result)[1].exp, 2);
+    assert_poly_equal(&result, &expected);
+    PolyDestroy(&result);
+    PolyDestroy(&expected);
+}
+
+/*
+* Single test of monomials storage
+*   description:        builder sorts many monomials given in any order
+*                       (with radix sort) the same as inserting them
+*   input:
+*      monos:           x^e for shuffled e (every exponent twice,
+*                       once with coefficient cancelled out),
+*                       y*x^0 and some negative exponents
+*   expected output:     the same as PolyInsertMono of every monomial
+*/
+static void test_storage_builder_radix(void **state) {
+    (void)state;
+    PolyCoeffSetModulus(0);
+    const int count = POLY_BUILDER_RADIX_THRESHOLD * 8;
+    PolyBuilder builder = PolyBuilderNew();
+    Poly expected = PolyZero();
+    for(int i=0;i<count;++i) {
+        const poly_exp_t exp = ((i * 7919) % count) * 65537 - ((i % 5 == 0) ? INT_MAX : 0);
+        const poly_coeff_t c = (i % 3 == 0) ? -(poly_coeff_t)exp : i;
+        PolyBuilderAdd(&builder, (Mono){ .p = PolyC(c), .exp = exp });
+        PolyBuilderAdd(&builder, (Mono){ .p = PolyC(exp), .exp = exp });
+        PolyInsertMono(&expected, (Mono){ .p = PolyC(c), .exp = exp });
+        PolyInsertMono(&expected, (Mono){ .p = PolyC(exp), .exp = exp });
+    }
+    PolyBuilderAdd(&builder, (Mono){ .p = PolyP(PolyC(1), 1), .exp = 0 });
+    PolyInsertMono(&expected, (Mono){ .p = PolyP(PolyC(1), 1), .exp = 0 });
+
+    Poly result = PolyBuilderBuild(&builder);
+    assert_poly_equal(&result, &expected);
+    for(int i=1;i<PolyMonosCount(&result);++i) {
+        assert_true(PolyBegin(&result)[i-1].exp < PolyBegin(&result)[i].exp);
+    }
+
+    // Unused builder frees its monomials
+    builder = PolyBuilderNew();
+    PolyBuilderAdd(&builder, (Mono){ .p = PolyP(PolyC(2), 3), .exp = 4 });
+    PolyBuilderDestroy(&builder);
+
+    PolyDestroy(&result);
+    PolyDestroy(&expected);
+}
+
+/*
+* Single test of monomials storage
+*   description:        polynomial is not equal to its own prefix
+*   input:
+*      p:                x + x^2
+*      q:                x
+*   expected output:     p != q
+*/
+static void test_storage_is_eq_prefix(void **state) {
+    (void)state;
+    Poly p = PolyP(PolyC(1), 1, PolyC(1), 2);
+    Poly q = PolyP(PolyC(1), 1);
+    assert_true(!PolyIsEq(&p, &q));
+    assert_true(!PolyIsEq(&q, &p));
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+}
+
+/*
+* Single test of arena allocated polynomials
+*   description:        copy placed in arena is equal to the original
+*                       and can be modified like any other polynomial
+*   input:
+*      p:                (2y^2)x + 3x^4
+*      inserted:         (y^2)x + 5x^7
+*   expected output:     (3y^2)x + 3x^4 + 5x^7
+*/
+static void test_arena_clone_modify(void **state) {
+    (void)state;
+    MemArena arena = MemArenaNew();
+    Poly p = PolyP(PolyP(PolyC(2), 2), 1, PolyC(3), 4);
+    Poly q = PolyCloneToArena(&p, &arena);
+    assert_poly_equal(&q, &p);
+
+    PolyInsertMono(&q, (Mono){ .p = PolyP(PolyC(1), 2), .exp = 1 });
+    PolyInsertMono(&q, (Mono){ .p = PolyC(5), .exp = 7 });
+
+    Poly expected = PolyP(PolyP(PolyC(3), 2), 1, PolyC(3), 4, PolyC(5), 7);
+    assert_poly_equal(&q, &expected);
+
+    PolyDestroy(&q);
+    MemArenaDestroy(&arena);
+    PolyDestroy(&p);
+    PolyDestroy(&expected);
+}
+
+static void test_mul_cancel_middle_terms(void **state) {
+    (void)state;
+    Poly p = PolyP(PolyP(PolyC(1), 1), 0, PolyC(1), 1);
+    Poly q = PolyP(PolyP(PolyC(1), 1), 0, PolyC(-1), 1);
+    Poly r = PolyMul(&p, &q);
+
+    Poly expected = PolyP(PolyP(PolyC(1), 2), 0, PolyC(-1), 2);
+    assert_poly_equal(&r, &expected);
+
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    PolyDestroy(&r);
+    PolyDestroy(&expected);
+}
+
+static void test_mul_const_terms(void **state) {
+    (void)state;
+    Poly p = PolyP(PolyC(2), 0, PolyC(1), 1);
+    Poly q = PolyP(PolyC(-2), 0, PolyC(1), 1);
+    Poly r = PolyMul(&p, &q);
+
+    Poly expected = PolyP(PolyC(-4), 0, PolyC(1), 2);
+    assert_poly_equal(&r, &expected);
+    assert_int_equal(PolyMonosCount(&r), 1);
+
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    PolyDestroy(&r);
+    PolyDestroy(&expected);
+}
+
+/*
+* Creates polynomial y + yx + ... + yx^(len-1)
+* (or 1 + x + ... + x^(len-1) if @p nested is false)
+*/
+static Poly create_dense_ones(int len, bool nested) {
+    Mono* monos = calloc(len, sizeof(Mono));
+    for(int i=0;i<len;++i) {
+        monos[i] = (Mono){ .p = nested ? PolyP(PolyC(1), 1) : PolyC(1), .exp = i };
+    }
+    Poly result = PolyAddMonos(len, monos);
+    free(monos);
+    return result;
+}
+
+/*
+* Checks that square of polynomial created by create_dense_ones
+* has correct coefficients
+*/
+static void check_dense_ones_square(int len, bool nested) {
+    Poly p = create_dense_ones(len, nested);
+    Poly r = PolyMul(&p, &p);
+
+    assert_int_equal(PolyMonosCount(&r), nested ? (2*len - 1) : (2*len - 2));
+    assert_int_equal(r.c, nested ? 0 : 1);
+    LOOP_POLY(&r, m) {
+        const int expected = (m->exp < len) ? (m->exp + 1) : (2*len - 1 - m->exp);
+        if(nested) {
+            assert_int_equal(PolyMonosCount(&(m->p)), 1);
+            assert_int_equal(m->p.monos[0].exp, 2);
+            assert_int_equal(m->p.monos[0].p.c, expected);
+        } else {
+            assert_true(PolyIsCoeff(&(m->p)));
+            assert_int_equal(m->p.c, expected);
+        }
+    }
+
+    PolyDestroy(&p);
+    PolyDestroy(&r);
+}
+
+static void test_mul_dense_karatsuba(void **state) {
+    (void)state;
+    check_dense_ones_square(POLY_MUL_KARATSUBA_THRESHOLD * 3 + 1, true);
+}
+
+static void test_mul_dense_toom3(void **state) {
+    (void)state;
+    check_dense_ones_square(POLY_MUL_TOOM3_THRESHOLD * 2 + 3, true);
+}
+
+static void test_mul_dense_ntt(void **state) {
+    (void)state;
+    check_dense_ones_square(POLY_MUL_NTT_THRESHOLD * 2 + 5, false);
+}
+
+/*
+* Product of dense polynomials with large coefficients
+* (which cannot be multiplied using NTT) is exact
+*/
+static void test_mul_dense_large(void **state) {
+    (void)state;
+    const int len = POLY_MUL_NTT_THRESHOLD + 7;
+    poly_coeff_t* a = calloc(len, sizeof(poly_coeff_t));
+    poly_coeff_t* b = calloc(len, sizeof(poly_coeff_t));
+    Mono* monos = calloc(len, sizeof(Mono));
+    for(int i=0;i<len;++i) {
+        a[i] = PolyCoeffFromLong(9000000000000000000L - (long)i * 7919);
+        b[i] = (poly_coeff_t)i * 104729 + 1;
+    }
+    for(int i=0;i<len;++i) {
+        monos[i] = (Mono){ .p = PolyC(PolyCoeffClone(a[i])), .exp = i };
+    }
+    Poly p = PolyAddMonos(len, monos);
+    for(int i=0;i<len;++i) {
+        monos[i] = (Mono){ .p = PolyC(b[i]), .exp = i };
+    }
+    Poly q = PolyAddMonos(len, monos);
+    Poly r = PolyMul(&p, &q);
+
+    assert_true(PolyCoeffIsEq(r.c, a[0]));
+    LOOP_POLY(&r, m) {
+        poly_coeff_t expected = 0;
+        for(int i=0;i<len;++i) {
+            const int j = m->exp - i;
+            if(j >= 0 && j < len) {
+                const poly_coeff_t product = PolyCoeffMul(a[i], b[j]);
+                PolyCoeffReplace(&expected, PolyCoeffAdd(expected, product));
+                PolyCoeffDestroy(product);
+            }
+        }
+        assert_false(PolyCoeffIsSmall(m->p.c));
+        assert_true(PolyCoeffIsEq(m->p.c, expected));
+        PolyCoeffDestroy(expected);
+    }
+
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    PolyDestroy(&r);
+    for(int i=0;i<len;++i) {
+        PolyCoeffDestroy(a[i]);
+    }
+    free(monos);
+    free(a);
+    free(b);
+}
+
+/*
+* Evaluates polynomial of three variables at given point
+*/
+static long eval_poly_3(const Poly* p, long x, long y, long z) {
+    Poly px = PolyAt(p, x);
+    Poly pxy = PolyAt(&px, y);
+    Poly pxyz = PolyAt(&pxy, z);
+    assert_true(PolyIsCoeff(&pxyz));
+    const long result = pxyz.c;
+    PolyDestroy(&px);
+    PolyDestroy(&pxy);
+    PolyDestroy(&pxyz);
+    return result;
+}
+
+/*
+* Sparse product of 150 by 150 monomials is split among pool threads
+* and so is the square of the first factor
+*/
+static void test_mul_parallel(void **state) {
+    (void)state;
+    Poly p = PolyZero();
+    Poly q = PolyZero();
+    for(int i=0;i<150;++i) {
+        PolyInsertMono(&p, (Mono){ .p = PolyC(i+1), .exp = i*i });
+        PolyInsertMono(&q, (Mono){ .p = PolyC(i%7-3), .exp = i*i*i });
+    }
+
+    ThreadPool* pool = ThreadPoolNew(1);
+    Poly result = PolyMulParallel(&p, &q, pool);
+    Poly expected = PolyMul(&p, &q);
+    assert_poly_equal(&result, &expected);
+
+    PolyDestroy(&result);
+    PolyDestroy(&expected);
+    result = PolyClone(&p);
+    expected = PolyClone(&p);
+    PolyPowInPlaceParallel(&result, 2, pool);
+    PolyPowInPlace(&expected, 2);
+    assert_poly_equal(&result, &expected);
+    ThreadPoolDestroy(pool);
+
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    PolyDestroy(&result);
+    PolyDestroy(&expected);
+}
+
+/*
+* Product of (1+x+y+z)^14 with itself is large enough
+* to be computed using Kronecker substitution
+*/
+static void test_mul_kronecker_eval(void **state) {
+    (void)state;
+    Poly base = PolyP(PolyP(PolyP(PolyC(1), 0, PolyC(1), 1), 0, PolyC(1), 1), 0, PolyC(1), 1);
+    Poly p = PolyPow(&base, 14);
+    Poly r = PolyMul(&p, &p);
+
+    assert_int_equal(PolyDeg(&r), 28);
+    assert_int_equal(eval_poly_3(&r, 1, 1, 1), 1L << 56);
+    assert_int_equal(eval_poly_3(&r, 1, -1, 1), 1L << 28);
+    assert_int_equal(eval_poly_3(&r, -2, 1, 2), 1L << 28);
+    assert_int_equal(eval_poly_3(&r, 2, -1, -1), 1);
+
+    PolyDestroy(&base);
+    PolyDestroy(&p);
+    PolyDestroy(&r);
+}
+
+static void test_inplace_add_take(void **state) {
+    (void)state;
+    Poly p = PolyP(PolyC(1), 1, PolyC(2), 3);
+    Poly q = PolyP(PolyC(-1), 1, PolyP(PolyC(1), 2), 2);
+    PolyAddTakeInPlace(&p, &q);
+
+    Poly expected = PolyP(PolyP(PolyC(1), 2), 2, PolyC(2), 3);
+    assert_poly_equal(&p, &expected);
+    assert_true(PolyIsZero(&q));
+
+    PolyDestroy(&p);
+    PolyDestroy(&expected);
+}
+
+static void test_inplace_add_scaled_self(void **state) {
+    (void)state;
+    Poly p = PolyP(PolyC(1), 0, PolyP(PolyC(2), 1), 4);
+    PolyAddScaledInPlace(&p, &p, 2);
+
+    Poly expected = PolyP(PolyC(3), 0, PolyP(PolyC(6), 1), 4);
+    assert_poly_equal(&p, &expected);
+
+    PolyAddScaledInPlace(&p, &p, -1);
+    assert_true(PolyIsZero(&p));
+
+    PolyDestroy(&p);
+    PolyDestroy(&expected);
+}
+
+static void test_inplace_mul_add(void **state) {
+    (void)state;
+    Poly p = PolyP(PolyC(1), 2);
+    Poly q = PolyP(PolyC(1), 0, PolyC(1), 1);
+    Poly r = PolyP(PolyC(1), 0, PolyC(-1), 1);
+    PolyMulAddInPlace(&p, &q, &r);
+
+    Poly expected = PolyC(1);
+    assert_poly_equal(&p, &expected);
+
+    PolyMulAddInPlace(&p, &q, &expected);
+    PolyAddInPlace(&p, &r);
+    Poly expected_sum = PolyC(3);
+    assert_poly_equal(&p, &expected_sum);
+
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    PolyDestroy(&r);
+    PolyDestroy(&expected);
+    PolyDestroy(&expected_sum);
+}
+
+static void test_inplace_mul_take_const(void **state) {
+    (void)state;
+    Poly p = PolyC(3);
+    Poly q = PolyP(PolyC(1), 1, PolyP(PolyC(2), 1), 2);
+    PolyMulTakeInPlace(&p, &q);
+
+    Poly expected = PolyP(PolyC(3), 1, PolyP(PolyC(6), 1), 2);
+    assert_poly_equal(&p, &expected);
+    assert_true(PolyIsZero(&q));
+
+    PolyDestroy(&p);
+    PolyDestroy(&expected);
+}
+
+static void test_inplace_sub_take(void **state) {
+    (void)state;
+    Poly p = PolyP(PolyC(2), 0, PolyC(1), 1);
+    Poly q = PolyP(PolyC(2), 0, PolyC(1), 1, PolyC(1), 2);
+    PolySubTakeInPlace(&p, &q);
+
+    Poly expected = PolyP(PolyC(-1), 2);
+    assert_poly_equal(&p, &expected);
+    assert_true(PolyIsZero(&q));
+
+    PolyDestroy(&p);
+    PolyDestroy(&expected);
+}
+
+static void test_inplace_at_pow(void **state) {
+    (void)state;
+    Poly p = PolyP(PolyP(PolyC(1), 1), 0, PolyC(2), 1, PolyP(PolyC(1), 2), 3);
+    Poly expected_at = PolyAt(&p, -2);
+    PolyAtInPlace(&p, -2);
+    assert_poly_equal(&p, &expected_at);
+
+    Poly expected_pow = PolyPow(&p, 5);
+    PolyPowInPlace(&p, 5);
+    assert_poly_equal(&p, &expected_pow);
+
+    PolyPowInPlace(&p, 0);
+    Poly one = PolyC(1);
+    assert_poly_equal(&p, &one);
+
+    PolyDestroy(&p);
+    PolyDestroy(&expected_at);
+    PolyDestroy(&expected_pow);
+    PolyDestroy(&one);
+}
+
+static void test_shared_clone_copy_on_write(void **state) {
+    (void)state;
+    Poly p = PolyP(PolyP(PolyC(2), 2), 1, PolyC(3), 4);
+    Poly q = PolyClone(&p);
+    assert_ptr_equal(p.monos, q.monos);
+
+    PolyNegInPlace(&q);
+    PolyInsertMono(&p, (Mono){ .p = PolyC(5), .exp = 7 });
+    assert_ptr_not_equal(p.monos, q.monos);
+
+    Poly expected_p = PolyP(PolyP(PolyC(2), 2), 1, PolyC(3), 4, PolyC(5), 7);
+    Poly expected_q = PolyP(PolyP(PolyC(-2), 2), 1, PolyC(-3), 4);
+    assert_poly_equal(&p, &expected_p);
+    assert_poly_equal(&q, &expected_q);
+
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    PolyDestroy(&expected_p);
+    PolyDestroy(&expected_q);
+}
+
+static void test_shared_add_take_clones(void **state) {
+    (void)state;
+    Poly p = PolyP(PolyP(PolyC(1), 1), 1, PolyC(1), 2);
+    Poly q = PolyClone(&p);
+    Poly r = PolyClone(&p);
+    PolyAddTakeInPlace(&q, &r);
+
+    Poly expected = PolyP(PolyP(PolyC(2), 1), 1, PolyC(2), 2);
+    Poly original = PolyP(PolyP(PolyC(1), 1), 1, PolyC(1), 2);
+    assert_poly_equal(&q, &expected);
+    assert_poly_equal(&p, &original);
+
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    PolyDestroy(&r);
+    PolyDestroy(&expected);
+    PolyDestroy(&original);
+}
+
+static void test_shared_intern(void **state) {
+    (void)state;
+    PolyInternTable table = PolyInternTableNew();
+    Poly p = PolyP(PolyP(PolyC(1), 2), 1, PolyP(PolyC(1), 2), 3);
+    Poly q = PolyP(PolyC(4), 0, PolyP(PolyC(1), 2), 1, PolyP(PolyC(1), 2), 3);
+    PolyIntern(&p, &table);
+    PolyIntern(&q, &table);
+
+    assert_ptr_equal(p.monos, q.monos);
+    assert_ptr_equal(p.monos[0].p.monos, p.monos[1].p.monos);
+    assert_false(PolyIsEq(&p, &q));
+    q.c = 0;
+    assert_true(PolyIsEq(&p, &q));
+
+    PolyInternTableDestroy(&table);
+    PolyNegInPlace(&q);
+    Poly expected = PolyP(PolyP(PolyC(-1), 2), 1, PolyP(PolyC(-1), 2), 3);
+    assert_poly_equal(&q, &expected);
+
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    PolyDestroy(&expected);
+}
+
+static void test_pow_cached(void **state) {
+    (void)state;
+    Poly x = PolyP(PolyP(PolyC(1), 1), 0, PolyC(-2), 1, PolyC(1), 3);
+    PolyPowCache cache = PolyPowCacheNew(&x);
+    const poly_exp_t exps[] = { 5, 3, 12, 0, 13, 12, 1, 40 };
+
+    for(size_t i=0;i<sizeof(exps)/sizeof(exps[0]);++i) {
+        Poly cached = PolyPowCached(&cache, exps[i]);
+        Poly expected = PolyPow(&x, exps[i]);
+        assert_poly_equal(&cached, &expected);
+        PolyDestroy(&cached);
+        PolyDestroy(&expected);
+    }
+
+    PolyDestroy(&x);
+    PolyPowCacheDestroy(&cache);
+}
+
+/*
+* Evaluation at 150 points (more than one block) matches PolyAt
+* and the third (not given) variable is substituted with 0
+*/
+static void test_eval_batch(void **state) {
+    (void)state;
+    Poly y = PolyP(PolyC(3), 0, PolyC(-2), 2, PolyC(1), 5);
+    Poly z = PolyP(PolyC(1), 1);
+    Poly yz = PolyP(PolyC(4), 0, PolyClone(&z), 3);
+    Poly p = PolyP(PolyC(7), 0, PolyClone(&y), 1, PolyClone(&yz), 4, PolyC(-1), 9);
+
+    const int count = 150;
+    poly_coeff_t xs[150];
+    poly_coeff_t ys[150];
+    for(int i=0;i<count;++i) {
+        xs[i] = i%11 - 5;
+        ys[i] = i%7 - 3;
+    }
+    const poly_coeff_t* points[] = { xs, ys };
+    poly_coeff_t* values = PolyEvalBatch(&p, 2, points, count);
+    for(int i=0;i<count;++i) {
+        assert_int_equal(values[i], eval_poly_3(&p, xs[i], ys[i], 0));
+    }
+    test_free(values);
+
+    values = PolyEvalBatch(&z, 0, NULL, 1);
+    assert_int_equal(values[0], 0);
+    test_free(values);
+
+    PolyDestroy(&y);
+    PolyDestroy(&z);
+    PolyDestroy(&yz);
+    PolyDestroy(&p);
+}
+
+/*
+* Compiled program is reused for many points and Horner steps
+* share powers (x^3 is used twice, so only x^2, x^3 and y^3 are computed)
+*/
+static void test_program_eval(void **state) {
+    (void)state;
+    Poly y = PolyP(PolyC(2), 0, PolyC(1), 3);
+    Poly p = PolyP(PolyC(1), 0, PolyC(-3), 2, PolyClone(&y), 5, PolyC(4), 8);
+    PolyProgram program = PolyCompile(&p);
+    assert_int_equal(program.powers_size, 3);
+
+    for(poly_coeff_t x=-4;x<=4;++x) {
+        for(poly_coeff_t z=-3;z<=3;++z) {
+            const poly_coeff_t values[] = { x, z };
+            assert_int_equal(PolyProgramEval(&program, 2, values), eval_poly_3(&p, x, z, 0));
+        }
+    }
+    PolyProgramDestroy(&program);
+
+    PolyDestroy(&y);
+    PolyDestroy(&p);
+}
+
+/*
+* Barrett reduction gives the same products as the exact ones
+* for the largest supported modulus
+*/
+static void test_coeff_mod_mul(void **state) {
+    (void)state;
+    const poly_coeff_t modulus = POLY_COEFF_MODULUS_MAX;
+    PolyCoeffSetModulus(modulus);
+    poly_coeff_t a = 1;
+    poly_coeff_t b = modulus - 1;
+    for(int i=0;i<1000;++i) {
+        a = (poly_coeff_t) (((unsigned long) a * 6364136223846793005UL + 1442695040888963407UL) >> 2) % modulus;
+        const poly_coeff_t c = PolyCoeffMul(a, b);
+        assert_true(c >= 0 && c < modulus);
+#if defined(__SIZEOF_INT128__)
+        assert_int_equal(c, (poly_coeff_t) ((PolyCoeffWide) a * (unsigned long) b % (unsigned long) modulus));
+#endif
+        assert_int_equal(PolyCoeffAdd(c, PolyCoeffMul(PolyCoeffNeg(a), b)), 0);
+        assert_int_equal(PolyCoeffMul(a, 1), a);
+        b = c;
+    }
+    assert_int_equal(PolyCoeffMul(modulus - 1, modulus - 1), 1);
+    assert_int_equal(PolyCoeffReduce(-1), modulus - 1);
+    PolyCoeffSetModulus(0);
+}
+
+/*
+* Modulo prime p polynomial (x+1)^p is equal to x^p + 1
+* and its coefficients are reduced to range [0, p)
+*/
+static void test_coeff_mod_pow(void **state) {
+    (void)state;
+    PolyCoeffSetModulus(101);
+    Poly p = PolyP(PolyC(1), 0, PolyC(1), 1);
+    Poly q = PolyPow(&p, 101);
+    Poly expected = PolyP(PolyC(1), 0, PolyC(1), 101);
+    assert_poly_equal(&q, &expected);
+
+    Poly r = PolyP(PolyC(-3), 0, PolyC(205), 2);
+    PolyReduceCoeffs(&r);
+    Poly r_expected = PolyP(PolyC(98), 0, PolyC(3), 2);
+    assert_poly_equal(&r, &r_expected);
+    PolyCoeffSetModulus(0);
+
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    PolyDestroy(&expected);
+    PolyDestroy(&r);
+    PolyDestroy(&r_expected);
+}
+
+/*
+* Single test of calculator op MOD
+*   description:        modulus is applied to stack and new polynomials
+*   input:
+*      (3,2)+(5,1)
+*      -1
+*      MOD 7
+*      PRINT
+*      POP
+*      PRINT
+*      (4,0)
+*      MUL
+*      PRINT
+*      MOD 1
+*   expected std output:
+*      6
+*      (5,1)+(3,2)
+*      (6,1)+(5,2)
+*   expected err output:    WRONG VALUE
+*/
+static void test_parser_mod(void **state) {
+    (void)state;
+    mock_run_calc_main(
+      "(3,2)+(5,1)\n-1\nMOD 7\nPRINT\nPOP\nPRINT\n(4,0)\nMUL\nPRINT\nMOD 1\n",
+      "6\n(5,1)+(3,2)\n(6,1)+(5,2)\n",
+      "ERROR 10 WRONG VALUE\n",
+      0
+    );
+}
+
+/*
+* Large coefficients are computed exactly
+* and the results which fit are stored inline again
+*/
+static void test_coeff_big_ops(void **state) {
+    (void)state;
+    PolyCoeffSetModulus(0);
+    char buffer[64];
+    const poly_coeff_t big = PolyCoeffPow(2, 100);
+    assert_false(PolyCoeffIsSmall(big));
+    assert_int_equal(PolyCoeffBits(big), 101);
+    PolyCoeffSprintf(buffer, big);
+    assert_string_equal(buffer, "1267650600228229401496703205376");
+
+    const poly_coeff_t neg = PolyCoeffNeg(big);
+    assert_true(neg < 0);
+    PolyCoeffSprintf(buffer, neg);
+    assert_string_equal(buffer, "-1267650600228229401496703205376");
+    assert_int_equal(PolyCoeffAdd(big, neg), 0);
+    assert_int_equal(PolyCoeffMul(big, 0), 0);
+
+    const poly_coeff_t limit = PolyCoeffPow(2, 62);
+    assert_false(PolyCoeffIsSmall(limit));
+    assert_int_equal(PolyCoeffAdd(limit, -1), POLY_COEFF_SMALL_MAX);
+    assert_int_equal(PolyCoeffNeg(limit), POLY_COEFF_SMALL_MIN);
+    assert_int_equal(PolyCoeffDivExact(limit, 4), 1L << 60);
+
+    const poly_coeff_t min = PolyCoeffFromLong(LONG_MIN);
+    PolyCoeffSprintf(buffer, min);
+    assert_string_equal(buffer, "-9223372036854775808");
+
+    PolyCoeffDestroy(big);
+    PolyCoeffDestroy(neg);
+    PolyCoeffDestroy(limit);
+    PolyCoeffDestroy(min);
+}
+
+/*
+* Points for which the values of polynomial are large
+* are evaluated exactly (the small points are checked
+* for overflows, the large one is evaluated exactly at once)
+*/
+static void test_coeff_big_eval(void **state) {
+    (void)state;
+    PolyCoeffSetModulus(0);
+    Poly p = PolyP(PolyC(5), 0, PolyC(-1), 3);
+    const poly_coeff_t xs[] = { 2, 1L << 40, -(1L << 30), 7, PolyCoeffPow(3, 50) };
+    const poly_coeff_t* points[] = { xs };
+    for(int count=4;count<=5;++count) {
+        poly_coeff_t* results = PolyEvalBatch(&p, 1, points, count);
+        for(int i=0;i<count;++i) {
+            Poly value = PolyAt(&p, xs[i]);
+            assert_true(PolyIsCoeff(&value));
+            assert_true(PolyCoeffIsEq(results[i], value.c));
+            PolyCoeffDestroy(results[i]);
+            PolyDestroy(&value);
+        }
+        test_free(results);
+    }
+    PolyCoeffDestroy(xs[4]);
+    PolyDestroy(&p);
+}
+
+/*
+* Programs with large constants are evaluated exactly
+* even if the values are small
+*/
+static void test_coeff_big_eval_const(void **state) {
+    (void)state;
+    PolyCoeffSetModulus(0);
+    const poly_coeff_t c = PolyCoeffPow(10, 30);
+    Poly p = PolyP(PolyP(PolyFromCoeff(PolyCoeffNeg(c)), 1), 0, PolyFromCoeff(c), 1);
+    const poly_coeff_t xs[] = { 1, 2 };
+    const poly_coeff_t* points[] = { xs, xs };
+    poly_coeff_t* results = PolyEvalBatch(&p, 2, points, 2);
+    assert_int_equal(results[0], 0);
+    assert_int_equal(results[1], 0);
+    test_free(results);
+    PolyDestroy(&p);
+}
+
+/*
+* Sums of products of the largest small coefficients
+* exceed the accumulator and are promoted to large coefficients
+*/
+static void test_coeff_acc_mul(void **state) {
+    (void)state;
+    PolyCoeffSetModulus(0);
+    const int len = 24;
+    Poly p = PolyZero();
+    for(int i=2;i<len;++i) {
+        PolyInsertMono(&p, (Mono){ .p = PolyC((i % 2) ? POLY_COEFF_SMALL_MAX : POLY_COEFF_SMALL_MIN), .exp = i*i });
+        PolyInsertMono(&p, (Mono){ .p = PolyC(POLY_COEFF_SMALL_MAX), .exp = i });
+    }
+    Poly q = PolyMul(&p, &p);
+
+    PolyCoeffAcc acc = PolyCoeffAccZero();
+    poly_coeff_t expected = 0;
+    for(int i=0;i<len;++i) {
+        PolyCoeffAccMulAdd(&acc, POLY_COEFF_SMALL_MAX, POLY_COEFF_SMALL_MAX);
+        const poly_coeff_t product = PolyCoeffMul(POLY_COEFF_SMALL_MAX, POLY_COEFF_SMALL_MAX);
+        PolyCoeffReplace(&expected, PolyCoeffAdd(expected, product));
+        PolyCoeffDestroy(product);
+    }
+    poly_coeff_t sum = 0;
+    PolyCoeffAccFlush(&acc, &sum);
+    assert_true(PolyCoeffBits(sum) > 128);
+    assert_true(PolyCoeffIsEq(sum, expected));
+
+    assert_int_equal(q.c, 0);
+    LOOP_POLY(&q, m) {
+        poly_coeff_t value = 0;
+        LOOP_POLY(&p, a) {
+            LOOP_POLY(&p, b) {
+                if(a->exp + b->exp == m->exp) {
+                    const poly_coeff_t product = PolyCoeffMul(a->p.c, b->p.c);
+                    PolyCoeffReplace(&value, PolyCoeffAdd(value, product));
+                    PolyCoeffDestroy(product);
+                }
+            }
+        }
+        assert_true(PolyCoeffIsEq(m->p.c, value));
+        PolyCoeffDestroy(value);
+    }
+
+    PolyCoeffDestroy(expected);
+    PolyCoeffDestroy(sum);
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+}
+
+/*
+* Single test of calculator with large coefficients
+*   description:        coefficients are not limited to machine integers
+*   input:
+*      2
+*      POW 100
+*      PRINT
+*      -1267650600228229401496703205376
+*      ADD
+*      IS_ZERO
+*      (-99999999999999999999,3)+(1,0)
+*      CLONE
+*      MUL
+*      PRINT
+*      (12345678901234567890123,1)
+*      AT -100000000000
+*      PRINT
+*      MOD 7
+*      100000000000000000000
+*      PRINT
+*   expected std output:
+*      1267650600228229401496703205376
+*      1
+*      (1,0)+(-199999999999999999998,3)+(9999999999999999999800000000000000000001,6)
+*      -1234567890123456789012300000000000
+*      2
+*   expected err output:    NONE
+*/
+static void test_parser_big_coeffs(void **state) {
+    (void)state;
+    mock_run_calc_main(
+      "2\nPOW 100\nPRINT\n-1267650600228229401496703205376\nADD\nIS_ZERO\n"
+      "(-99999999999999999999,3)+(1,0)\nCLONE\nMUL\nPRINT\n"
+      "(12345678901234567890123,1)\nAT -100000000000\nPRINT\n"
+      "MOD 7\n100000000000000000000\nPRINT\n",
+      "1267650600228229401496703205376\n1\n"
+      "(1,0)+(-199999999999999999998,3)+(9999999999999999999800000000000000000001,6)\n"
+      "-1234567890123456789012300000000000\n2\n",
+      "",
+      0
+    );
+}
+
+/*
+* Distributed form of polynomial keeps its terms
+* and converts back to the same nested polynomial
+*/
+static void test_dist_round_trip(void **state) {
+    (void)state;
+    PolyCoeffSetModulus(0);
+    const poly_coeff_t big = PolyCoeffMul(POLY_COEFF_SMALL_MAX, POLY_COEFF_SMALL_MAX);
+    // 3 + 2w^4 + (-1 + 5yz^2)x + (big*z^7)x^3
+    Poly p = PolyP(
+      PolyC(3), 0,
+      PolyP(PolyC(-1), 0, PolyP(PolyC(5), 2), 1), 1,
+      PolyP(PolyP(PolyC(PolyCoeffClone(big)), 7), 0), 3
+    );
+    PolyInsertMono(&p, (Mono){ .p = PolyP(PolyP(PolyP(PolyC(2), 4), 0), 0), .exp = 0 });
+    assert_true(PolyDistCanPack(&p));
+
+    PolyDist d = PolyDistFromPoly(&p);
+    assert_int_equal(d.vars, 4);
+    assert_int_equal(d.bits, 16);
+    assert_int_equal(d.size, 5);
+    for(int i=1;i<d.size;++i) {
+        assert_int_equal(PolyDistMonoCompare(d.terms[i-1].exps, d.terms[i].exps), -1);
+    }
+    assert_int_equal(PolyDistExp(&d, d.terms[1].exps, 3), 4);
+    assert_int_equal(PolyDistExp(&d, d.terms[3].exps, 0), 1);
+    assert_int_equal(PolyDistExp(&d, d.terms[3].exps, 1), 1);
+    assert_int_equal(PolyDistExp(&d, d.terms[3].exps, 2), 2);
+    assert_int_equal(d.terms[3].c, 5);
+    assert_true(PolyCoeffIsEq(d.terms[4].c, big));
+
+    Poly q = PolyDistToPoly(&d);
+    assert_poly_equal(&p, &q);
+
+    Poly wide = PolyP(PolyP(PolyP(PolyC(1), 1 << 21), 0), 1);
+    assert_false(PolyDistCanPack(&wide));
+
+    PolyCoeffDestroy(big);
+    PolyDistDestroy(&d);
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    PolyDestroy(&wide);
+}
+
+/*
+* Sums and products of distributed polynomials
+* (with different numbers of variables) match nested ones
+*/
+static void test_dist_arith(void **state) {
+    (void)state;
+    PolyCoeffSetModulus(0);
+    // (1 + y)x + 2 + (y^2 + 3z)x^2
+    Poly p = PolyP(
+      PolyC(2), 0,
+      PolyP(PolyC(1), 0, PolyC(1), 1), 1,
+      PolyP(PolyP(PolyC(3), 1), 0, PolyC(1), 2), 2
+    );
+    // -1 + (-1 - y)x + (POLY_COEFF_SMALL_MAX)x^5
+    Poly q = PolyP(
+      PolyC(-1), 0,
+      PolyP(PolyC(-1), 0, PolyC(-1), 1), 1,
+      PolyC(POLY_COEFF_SMALL_MAX), 5
+    );
+    PolyDist dp = PolyDistFromPoly(&p);
+    PolyDist dq = PolyDistFromPoly(&q);
+    assert_true(dp.vars != dq.vars);
+
+    Poly sum = PolyAdd(&p, &q);
+    PolyDist dsum = PolyDistAdd(&dp, &dq);
+    PolyDist expected_sum = PolyDistFromPoly(&sum);
+    assert_true(PolyDistIsEq(&dsum, &expected_sum));
+    Poly sum_back = PolyDistToPoly(&dsum);
+    assert_poly_equal(&sum, &sum_back);
+
+    assert_true(PolyDistMulFits(&dp, &dq));
+    Poly product = PolyMul(&p, &q);
+    PolyDist dproduct = PolyDistMul(&dp, &dq);
+    Poly product_back = PolyDistToPoly(&dproduct);
+    assert_poly_equal(&product, &product_back);
+    assert_false(PolyDistIsEq(&dproduct, &dsum));
+
+    PolyDistDestroy(&dp);
+    PolyDistDestroy(&dq);
+    PolyDistDestroy(&dsum);
+    PolyDistDestroy(&expected_sum);
+    PolyDistDestroy(&dproduct);
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    PolyDestroy(&sum);
+    PolyDestroy(&sum_back);
+    PolyDestroy(&product);
+    PolyDestroy(&product_back);
+}
+
+/*
+* Input read in small blocks is consumed
+* in the same order by characters and by skipped lines
+*/
+static void test_input_buffer_blocks(void **state) {
+    (void)state;
+    mock_clear_all_buffers();
+    mock_set_scanf_buffer("ab\n\ncd\nlast");
+    InputBuffer input = InputBufferFromFd(STDIN_FILENO, 3);
+    size_t skipped = 0;
+
+    assert_int_equal(InputBufferGet(&input), 'a');
+    assert_int_equal(InputBufferGet(&input), 'b');
+    assert_int_equal(InputBufferSkipLine(&input, &skipped), '\n');
+    assert_int_equal(skipped, 0);
+    assert_int_equal(InputBufferSkipLine(&input, &skipped), '\n');
+    assert_int_equal(skipped, 0);
+    assert_int_equal(InputBufferGet(&input), 'c');
+    assert_int_equal(InputBufferSkipLine(&input, &skipped), '\n');
+    assert_int_equal(skipped, 1);
+    assert_int_equal(InputBufferSkipLine(&input, &skipped), EOF);
+    assert_int_equal(skipped, 4);
+    assert_int_equal(InputBufferGet(&input), EOF);
+
+    InputBufferDestroy(&input);
+}
+
+/*
+* Calculator reads the file given as argument (mapped into memory)
+* and reports the same positions of errors as for standard input
+*/
+static void test_input_file_argument(void **state) {
+    (void)state;
+    const char* path = "unit_tests_input.tmp";
+    const char* input = "(1,2)\nPRINT\n(1,\nPOP FOO\n(2,1)+(1,3)x y z\nADD\nPRINT\n";
+    FILE* file = fopen(path, "w");
+    assert_non_null(file);
+    fputs(input, file);
+    fclose(file);
+
+    InputBuffer mapped;
+    assert_true(InputBufferOpen(&mapped, path, INPUT_BUFFER_BLOCK_SIZE));
+    assert_non_null(mapped.mapping);
+    for(size_t i=0;input[i]!='\0';++i) {
+        assert_int_equal(InputBufferGet(&mapped), input[i]);
+    }
+    assert_int_equal(InputBufferGet(&mapped), EOF);
+    InputBufferDestroy(&mapped);
+
+    const char *args[] = { "calc_poly", path };
+    mock_clear_all_buffers();
+    assert_int_equal(calculator_main(ARRAY_LENGTH(args), (char **)args), 0);
+    assert_string_equal(mock_get_printf_buffer(), "(1,2)\n");
+    assert_string_equal(mock_get_fprintf_buffer(),
+      "ERROR 3 4\nERROR 4 WRONG COMMAND\nERROR 5 12\n"
+      "ERROR 6 STACK UNDERFLOW\nERROR 7 STACK UNDERFLOW\n");
+    remove(path);
+}
+
+/*
+* Writes polynomial (((...(7,1)...,1),1) nested @p depth levels
+* to file @p path (with the last character replaced by @p last)
+*/
+static void write_nested_poly(const char* path, int depth, char last) {
+    FILE* file = fopen(path, "w");
+    assert_non_null(file);
+    for(int i=0;i<depth;++i) fputc('(', file);
+    fputc('7', file);
+    for(int i=0;i<depth;++i) fputs((i+1 < depth) ? ",1)" : ",1", file);
+    fputc(last, file);
+    fputc('\n', file);
+    fclose(file);
+}
+
+/*
+* Polynomials nested deeper than native stack could handle recursively
+* are parsed and invalid input is reported at the same position
+*/
+static void test_parser_deep_nesting(void **state) {
+    (void)state;
+    const char* path = "unit_tests_input.tmp";
+    const int depth = 50000;
+
+    write_nested_poly(path, depth, ')');
+    InterpreterState calc = InterpreterNew(NULL);
+    assert_true(InterpreterOpenInput(&calc, path));
+    InterpreterNextChar(&calc);
+    Poly p = InterpreterParsePoly(&calc);
+    assert_false(InterpreterWasError(&calc));
+    assert_int_equal(calc.char_buffer, '\n');
+
+    Poly** levels = calloc(depth + 1, sizeof(Poly*));
+    levels[0] = &p;
+    for(int i=0;i<depth;++i) {
+        assert_int_equal(PolyMonosCount(levels[i]), 1);
+        assert_int_equal(levels[i]->monos[0].exp, 1);
+        levels[i+1] = &(levels[i]->monos[0].p);
+    }
+    assert_true(PolyIsCoeff(levels[depth]));
+    assert_int_equal(levels[depth]->c, 7);
+
+    // Free the polynomial level by level (from the deepest one)
+    for(int i=depth-1;i>=0;--i) {
+        PolyDestroy(levels[i]);
+        *levels[i] = PolyZero();
+    }
+    free(levels);
+    InterpreterCleanup(&calc);
+
+    write_nested_poly(path, depth, 'x');
+    calc = InterpreterNew(NULL);
+    assert_true(InterpreterOpenInput(&calc, path));
+    InterpreterNextChar(&calc);
+    Poly q = InterpreterParsePoly(&calc);
+    assert_true(InterpreterWasError(&calc));
+    assert_int_equal(calc.error_row, 1);
+    assert_int_equal(calc.error_col, 4 * depth + 1);
+    PolyDestroy(&q);
+    InterpreterCleanup(&calc);
+    remove(path);
+}
+
+/*
+* Writer counting calls and collected characters of printed polynomial
+*/
+typedef struct PrintCollector {
+    char* str;
+    size_t length;
+    int calls;
+} PrintCollector;
+
+static void print_collector_writer(void* data, const char* str, size_t length) {
+    PrintCollector* collector = data;
+    collector->str = realloc(collector->str, collector->length + length + 1);
+    memcpy(collector->str + collector->length, str, length);
+    collector->length += length;
+    collector->str[collector->length] = '\0';
+    ++collector->calls;
+}
+
+/*
+* Printed polynomial skips ones and signs wherever possible
+* and PolySnprintf truncates it like snprintf does
+*/
+static void test_print_format(void **state) {
+    (void)state;
+    // -1 + 2a^-3 + (b - 5b^2)a^4
+    PolyBuilder builder = PolyBuilderNew();
+    Poly terms[] = { PolyP(PolyC(1), 1, PolyC(-5), 2), PolyC(-1), PolyC(2) };
+    PolyBuilderAdd(&builder, MonoFromPoly(&terms[0], 4));
+    PolyBuilderAdd(&builder, MonoFromPoly(&terms[1], 0));
+    PolyBuilderAdd(&builder, MonoFromPoly(&terms[2], -3));
+    Poly p = PolyBuilderBuild(&builder);
+    const char* expected = "-1 + 2a^-3 + a^4*b - 5a^4*b^2";
+    const size_t length = strlen(expected);
+
+    char* str = PolyToString(&p);
+    assert_string_equal(str, expected);
+    test_free(str);
+
+    char buf[16];
+    assert_int_equal(PolySnprintf(NULL, 0, &p), length);
+    assert_int_equal(PolySnprintf(buf, sizeof(buf), &p), length);
+    assert_int_equal(strlen(buf), sizeof(buf) - 1);
+    assert_memory_equal(buf, expected, sizeof(buf) - 1);
+
+    Poly zero = PolyZero();
+    assert_int_equal(PolySnprintf(buf, sizeof(buf), &zero), 1);
+    assert_string_equal(buf, "0");
+    PolyDestroy(&p);
+}
+
+/*
+* Polynomials longer than any fixed buffer are printed
+* in chunks passed to the writer
+*/
+static void test_print_long(void **state) {
+    (void)state;
+    const int count = 3000;
+    PolyBuilder builder = PolyBuilderNew();
+    for(int i=1;i<=count;++i) {
+        Poly c = PolyC(i);
+        PolyBuilderAdd(&builder, MonoFromPoly(&c, i));
+    }
+    Poly p = PolyBuilderBuild(&builder);
+
+    PrintCollector collector = { .str = NULL, .length = 0, .calls = 0 };
+    PolyPrintTo(&p, print_collector_writer, &collector);
+    assert_true(collector.calls > 1);
+    assert_int_equal(collector.length, PolySnprintf(NULL, 0, &p));
+    assert_memory_equal(collector.str, "1a + 2a^2 + 3a^3 + ", 19);
+    assert_string_equal(collector.str + collector.length - 13, " + 3000a^3000");
+
+    char* str = PolyToString(&p);
+    assert_string_equal(str, collector.str);
+    test_free(str);
+    free(collector.str);
+    PolyDestroy(&p);
+}
+
+/*
+* Output written in blocks of few bytes is the same as written at once
+* and calculator commands print through the interpreter output buffer
+*/
+static void test_print_output_buffer(void **state) {
+    (void)state;
+    mock_clear_all_buffers();
+    OutputBuffer output = OutputBufferToFd(STDOUT_FILENO, 4);
+    OutputBufferWrite(&output, "(1,", 3);
+    OutputBufferWriteLong(&output, -9223372036854775807L - 1);
+    OutputBufferWrite(&output, ")+(", 3);
+    OutputBufferWriteLong(&output, 0);
+    OutputBufferPut(&output, ',');
+    OutputBufferWrite(&output, "123456789", 9);
+    OutputBufferPut(&output, ')');
+    OutputBufferEndLine(&output);
+    OutputBufferDestroy(&output);
+    assert_string_equal(mock_get_printf_buffer(), "(1,-9223372036854775808)+(0,123456789)\n");
+
+    const char *args[] = { "calc_poly" };
+    mock_clear_all_buffers();
+    mock_set_scanf_buffer(
+      "((1,0)+(-2,3),4)+(100000000000000000000,5)\nPRINT\nIS_ZERO\nDEG\n"
+      "DEG_BY 1\n0\nIS_EQ\nIS_COEFF\nDUMP\nPOP\nPRINT\n");
+    assert_int_equal(calculator_main(ARRAY_LENGTH(args), (char **)args), 0);
+    assert_string_equal(mock_get_printf_buffer(),
+      "((1,0)+(-2,3),4)+(100000000000000000000,5)\n0\n7\n3\n0\n1\n"
+      "[ 1a^4 - 2a^4*b^3 + 100000000000000000000a^5; 0; ] \n"
+      "((1,0)+(-2,3),4)+(100000000000000000000,5)\n");
+}
+
+/*
+* Polynomials written in binary format are read back equal
+* (including big coefficients, negative exponents and deep nesting),
+* truncated input is rejected
+*/
+static void test_binary_round_trip(void **state) {
+    (void)state;
+    const char* path = "unit_tests_binary.tmp";
+    const int depth = 20000;
+    Poly polys[4];
+    polys[0] = PolyP(PolyC(-4611686018427387904L), 0, PolyP(PolyC(1), 1, PolyC(-5), 2), 4);
+    polys[1] = PolyC(PolyCoeffMul(4611686018427387903L, -4611686018427387903L));
+    polys[2] = PolyC(7);
+    for(int i=0;i<depth;++i) {
+        polys[2] = PolyP(polys[2], i % 3 + 1);
+    }
+    PolyBuilder builder = PolyBuilderNew();
+    Poly term = PolyC(3);
+    PolyBuilderAdd(&builder, MonoFromPoly(&term, -2));
+    polys[3] = PolyBuilderBuild(&builder);
+
+    OutputBuffer out;
+    assert_true(OutputBufferOpen(&out, path, 16));
+    PolyBinaryWriteHeader(&out, 4);
+    for(int i=0;i<4;++i) {
+        PolySave(&polys[i], &out);
+    }
+    assert_true(OutputBufferDestroy(&out));
+
+    InputBuffer in;
+    size_t count;
+    assert_true(InputBufferOpen(&in, path, INPUT_BUFFER_BLOCK_SIZE));
+    assert_true(PolyBinaryReadHeader(&in, &count));
+    assert_int_equal(count, 4);
+    for(int i=0;i<4;++i) {
+        Poly p;
+        assert_true(PolyLoad(&in, &p));
+        assert_true(PolyIsEq(&p, &polys[i]));
+        PolyDestroy(&p);
+    }
+    assert_int_equal(InputBufferGet(&in), EOF);
+    InputBufferDestroy(&in);
+
+    // Polynomial 1 + ... with 3 monomials missing
+    OutputBuffer cut;
+    assert_true(OutputBufferOpen(&cut, path, 16));
+    PolyBinaryWriteHeader(&cut, 1);
+    OutputBufferWrite(&cut, "\x02\x03", 2);
+    assert_true(OutputBufferDestroy(&cut));
+    assert_true(InputBufferOpen(&in, path, INPUT_BUFFER_BLOCK_SIZE));
+    assert_true(PolyBinaryReadHeader(&in, &count));
+    Poly p;
+    assert_false(PolyLoad(&in, &p));
+    assert_true(PolyIsZero(&p));
+    InputBufferDestroy(&in);
+    remove(path);
+
+    for(int i=0;i<4;++i) {
+        PolyDestroy(&polys[i]);
+    }
+}
+
+/*
+* Calculator saves the whole stack and loads it back
+* (coefficients are reduced with the current modulus)
+*/
+static void test_binary_calc_commands(void **state) {
+    (void)state;
+    const char *args[] = { "calc_poly" };
+    mock_clear_all_buffers();
+    mock_set_scanf_buffer(
+      "(1,2)+((3,0)+(-4,5),3)\n-100000000000000000000\nSAVE unit_tests_binary.tmp\n"
+      "CLEAN\nLOAD unit_tests_binary.tmp\nPRINT\nPOP\nPRINT\n"
+      "MOD 7\nLOAD unit_tests_binary.tmp\nPRINT\n"
+      "LOAD\nLOAD unit_tests_missing.tmp\n");
+    assert_int_equal(calculator_main(ARRAY_LENGTH(args), (char **)args), 0);
+    assert_string_equal(mock_get_printf_buffer(),
+      "-100000000000000000000\n(1,2)+((3,0)+(-4,5),3)\n5\n");
+    assert_string_equal(mock_get_fprintf_buffer(),
+      "ERROR 12 WRONG FILE\nERROR 13 WRONG FILE\n");
+    remove("unit_tests_binary.tmp");
+}
+
 /*
 * Tests entry point
 */
@@ -341,7 +1626,9 @@ int main(void) {
       cmocka_unit_test(test_compose_fn_poly_const_count_1),
       cmocka_unit_test(test_compose_fn_poly_linear_count_0),
       cmocka_unit_test(test_compose_fn_poly_linear_count_1_const),
-      cmocka_unit_test(test_compose_fn_poly_linear_count_1_linear)
+      cmocka_unit_test(test_compose_fn_poly_linear_count_1_linear),
+      cmocka_unit_test(test_compose_fn_poly_gaps_count_2),
+      cmocka_unit_test(test_compose_fn_parallel)
     };
 
     /*
@@ -362,11 +1649,185 @@ int main(void) {
       cmocka_unit_test(test_parser_compose_count_letters_digits_combination)
     };
 
-    
+
+    /*
+    * Group test
+    *   description:
+    *        Testing sorted array storage of monomials
+    *
+    */
+    const struct CMUnitTest storage_tests[] = {
+      cmocka_unit_test(test_storage_add_monos_unsorted),
+      cmocka_unit_test(test_storage_builder_radix),
+      cmocka_unit_test(test_storage_is_eq_prefix)
+    };
+
+    /*
+    * Group test
+    *   description:
+    *        Testing polynomials allocated in memory arena
+    *
+    */
+    const struct CMUnitTest arena_tests[] = {
+      cmocka_unit_test(test_arena_clone_modify)
+    };
+
+    /*
+    * Group test
+    *   description:
+    *        Testing multiplication via PolyMul
+    *
+    */
+    const struct CMUnitTest mul_tests[] = {
+      cmocka_unit_test(test_mul_cancel_middle_terms),
+      cmocka_unit_test(test_mul_const_terms),
+      cmocka_unit_test(test_mul_dense_karatsuba),
+      cmocka_unit_test(test_mul_dense_toom3),
+      cmocka_unit_test(test_mul_dense_ntt),
+      cmocka_unit_test(test_mul_dense_large),
+      cmocka_unit_test(test_mul_kronecker_eval),
+      cmocka_unit_test(test_mul_parallel)
+    };
+
+    /*
+    * Group test
+    *   description:
+    *        Testing in-place arithmetic operations
+    *
+    */
+    const struct CMUnitTest inplace_tests[] = {
+      cmocka_unit_test(test_inplace_add_take),
+      cmocka_unit_test(test_inplace_add_scaled_self),
+      cmocka_unit_test(test_inplace_mul_add),
+      cmocka_unit_test(test_inplace_mul_take_const),
+      cmocka_unit_test(test_inplace_sub_take),
+      cmocka_unit_test(test_inplace_at_pow)
+    };
+
+    /**
+    * Group test
+    *   description:
+    *        Testing powers computed with PolyPowCache
+    *
+    */
+    const struct CMUnitTest pow_cache_tests[] = {
+      cmocka_unit_test(test_pow_cached)
+    };
+
+    /**
+    * Group test
+    *   description:
+    *        Testing monomials arrays shared between copies
+    *        and hash-consing of polynomials
+    *
+    */
+    const struct CMUnitTest shared_tests[] = {
+      cmocka_unit_test(test_shared_clone_copy_on_write),
+      cmocka_unit_test(test_shared_add_take_clones),
+      cmocka_unit_test(test_shared_intern)
+    };
+
+    /**
+    * Group test
+    *   description:
+    *        Testing evaluation at many points via PolyEvalBatch
+    *        and compiled programs
+    *
+    */
+    const struct CMUnitTest eval_batch_tests[] = {
+      cmocka_unit_test(test_eval_batch),
+      cmocka_unit_test(test_program_eval)
+    };
+
+    /**
+    * Group test
+    *   description:
+    *        Testing modular arithmetic of coefficients
+    *
+    */
+    const struct CMUnitTest coeff_mod_tests[] = {
+      cmocka_unit_test(test_coeff_mod_mul),
+      cmocka_unit_test(test_coeff_mod_pow),
+      cmocka_unit_test(test_parser_mod)
+    };
+
+    /**
+    * Group test
+    *   description:
+    *        Testing arbitrary precision coefficients
+    *
+    */
+    const struct CMUnitTest coeff_big_tests[] = {
+      cmocka_unit_test(test_coeff_big_ops),
+      cmocka_unit_test(test_coeff_big_eval),
+      cmocka_unit_test(test_coeff_big_eval_const),
+      cmocka_unit_test(test_coeff_acc_mul),
+      cmocka_unit_test(test_parser_big_coeffs)
+    };
+
+    /**
+    * Group test
+    *   description:
+    *        Testing distributed representation of polynomials
+    *
+    */
+    const struct CMUnitTest dist_tests[] = {
+      cmocka_unit_test(test_dist_round_trip),
+      cmocka_unit_test(test_dist_arith)
+    };
+
+    /**
+    * Group test
+    *   description:
+    *        Testing buffered reading of input
+    *
+    */
+    const struct CMUnitTest input_tests[] = {
+      cmocka_unit_test(test_input_buffer_blocks),
+      cmocka_unit_test(test_input_file_argument),
+      cmocka_unit_test(test_parser_deep_nesting)
+    };
+
+    /**
+    * Group test
+    *   description:
+    *        Testing printing of polynomials
+    *
+    */
+    const struct CMUnitTest print_tests[] = {
+      cmocka_unit_test(test_print_format),
+      cmocka_unit_test(test_print_long),
+      cmocka_unit_test(test_print_output_buffer)
+    };
+
+    /**
+    * Group test
+    *   description:
+    *        Testing binary format of polynomials
+    *
+    */
+    const struct CMUnitTest binary_tests[] = {
+      cmocka_unit_test(test_binary_round_trip),
+      cmocka_unit_test(test_binary_calc_commands)
+    };
+
     // Run tests
     int status = 0;
     status |= cmocka_run_group_tests_name("compose function tests", compose_fn_tests, NULL, NULL);
     status |= cmocka_run_group_tests_name("COMPOSE parsing calculator tests", parser_compose_tests, NULL, NULL);
+    status |= cmocka_run_group_tests_name("monomials storage tests", storage_tests, NULL, NULL);
+    status |= cmocka_run_group_tests_name("arena allocation tests", arena_tests, NULL, NULL);
+    status |= cmocka_run_group_tests_name("multiplication tests", mul_tests, NULL, NULL);
+    status |= cmocka_run_group_tests_name("in-place operations tests", inplace_tests, NULL, NULL);
+    status |= cmocka_run_group_tests_name("shared storage tests", shared_tests, NULL, NULL);
+    status |= cmocka_run_group_tests_name("cached powers tests", pow_cache_tests, NULL, NULL);
+    status |= cmocka_run_group_tests_name("batched evaluation tests", eval_batch_tests, NULL, NULL);
+    status |= cmocka_run_group_tests_name("modular coefficients tests", coeff_mod_tests, NULL, NULL);
+    status |= cmocka_run_group_tests_name("arbitrary precision coefficients tests", coeff_big_tests, NULL, NULL);
+    status |= cmocka_run_group_tests_name("distributed representation tests", dist_tests, NULL, NULL);
+    status |= cmocka_run_group_tests_name("buffered input tests", input_tests, NULL, NULL);
+    status |= cmocka_run_group_tests_name("printing tests", print_tests, NULL, NULL);
+    status |= cmocka_run_group_tests_name("binary format tests", binary_tests, NULL, NULL);
     return status;
 
 }